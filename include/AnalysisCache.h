@@ -0,0 +1,142 @@
+#ifndef ANALYSISCACHE_H
+#define ANALYSISCACHE_H
+
+#include "AudioTrack.h"
+#include "BeatGrid.h"
+#include "HarmonicKey.h"
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief Process-wide memo of per-track analysis results
+ *
+ * The same immutable track is prepared on the playlist copy, the cache copy
+ * and the deck copy, and again on every replay. Results are keyed by track
+ * identity: the shared TrackPayload block (so every clone hits the same
+ * entry and replacing the waveform naturally misses) plus duration and BPM
+ * (the inputs of the fallback grid). A track analyzed from another shared
+ * source (e.g. a mapped audio file, shared by every copy of the track; see
+ * SharedFile) is keyed by that source instead. Each
+ * entry holds a weak reference to its source, so a recycled address is never
+ * mistaken for the old track, and entries of released sources are pruned as
+ * the table grows.
+ *
+ * Harmonic keys are memoized the same way, keyed by the source alone (the
+ * key does not depend on duration or BPM). analysesRun()/analysesSkipped()
+ * count beat-grid requests only.
+ *
+ * A grid the time budget cut short (BeatGrid::complete false) is returned
+ * but not stored, so the next request analyzes the track again.
+ *
+ * Per-file data that outlives the process (MP3 seek tables) is persisted in
+ * the store directory, which the session points at the directory of its
+ * controller cache snapshot. Without a store it is rebuilt on every run.
+ *
+ * Thread-safe: the prefetch worker analyzes tracks concurrently with the
+ * session thread. Analysis itself runs outside the lock; if two threads race
+ * on the same track, the first stored result wins.
+ */
+class AnalysisCache {
+public:
+    /**
+     * @brief The cache shared by the whole process
+     */
+    static AnalysisCache& shared();
+
+    AnalysisCache() : mutex(), entries(), prune_at(64), computed(0), reused(0), store_directory() {}
+
+    /**
+     * @brief Beat grid of track, analyzing it only if no copy was analyzed before
+     */
+    std::shared_ptr<const BeatGrid> beatGrid(const AudioTrack& track);
+
+    /**
+     * @brief Beat grid of the audio held by source, computed by analyze on a miss
+     */
+    std::shared_ptr<const BeatGrid> beatGrid(const std::shared_ptr<const void>& source, int duration, int bpm,
+                                             const std::function<std::shared_ptr<const BeatGrid>()>& analyze);
+
+    /**
+     * @brief Harmonic key of track, detecting it only if no copy was analyzed before
+     */
+    std::shared_ptr<const HarmonicKey> harmonicKey(const AudioTrack& track);
+
+    /**
+     * @brief Harmonic key of the audio held by source, computed by detect on a miss
+     */
+    std::shared_ptr<const HarmonicKey> harmonicKey(const std::shared_ptr<const void>& source,
+                                                   const std::function<std::shared_ptr<const HarmonicKey>()>& detect);
+
+    /**
+     * @brief Persist per-file analysis data in directory ("" = keep it in memory only)
+     */
+    void setStoreDirectory(const std::string& directory);
+
+    /**
+     * @brief File holding the seek table of the audio file at audio_path ("" without a store)
+     * Named after the file plus a hash of its full path, so equal names in different
+     * folders do not collide. Mp3File checks the table against the file before using it.
+     */
+    std::string seekTablePath(const std::string& audio_path) const;
+
+    size_t analysesRun() const;
+    size_t analysesSkipped() const;
+    size_t size() const;
+    void clear();
+
+private:
+    AnalysisCache(const AnalysisCache&) = delete;
+    AnalysisCache& operator=(const AnalysisCache&) = delete;
+
+    struct Key {
+        const void* source;
+        int duration;
+        int bpm;
+        bool operator==(const Key& other) const {
+            return source == other.source && duration == other.duration && bpm == other.bpm;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            size_t hash = std::hash<const void*>()(key.source);
+            hash ^= std::hash<int>()(key.duration) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+            return hash ^ (std::hash<int>()(key.bpm) + 0x9e3779b9 + (hash << 6) + (hash >> 2));
+        }
+    };
+
+    struct Entry {
+        std::weak_ptr<const void> source;   // Detects address reuse
+        std::shared_ptr<const BeatGrid> beat_grid;
+        std::shared_ptr<const HarmonicKey> harmonic_key;
+        Entry() : source(), beat_grid(), harmonic_key() {}
+    };
+
+    /**
+     * @brief Memoized result in field of the entry for key, computed by analyze on a miss
+     * @param counted Whether the lookup counts towards analysesRun/analysesSkipped
+     */
+    template <typename Result>
+    std::shared_ptr<const Result> memo(const Key& key, const std::shared_ptr<const void>& source,
+                                       std::shared_ptr<const Result> Entry::*field,
+                                       const std::function<std::shared_ptr<const Result>()>& analyze, bool counted);
+
+    void pruneLocked();
+
+    // Whether a result is final and may be memoized
+    static bool settled(const BeatGrid& grid) { return grid.complete; }
+    static bool settled(const HarmonicKey& key) { (void)key; return true; }
+
+    mutable std::mutex mutex;
+    std::unordered_map<Key, Entry, KeyHash> entries;
+    size_t prune_at;     // Sweep released tracks when the table reaches this size
+    size_t computed;
+    size_t reused;
+    std::string store_directory;   // "" = nothing is persisted
+};
+
+#endif // ANALYSISCACHE_H
@@ -2,8 +2,74 @@
 
 #include <string>
 #include "PointerWrapper.h"
+#include "BeatGrid.h"
+#include "HarmonicKey.h"
+#include "TrackStream.h"
+#include "WaveformBuffer.h"
+#include "WaveformPyramid.h"
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
 #include <memory>
+#include <mutex>
 #include <vector>
+
+/**
+ * Dense library-wide track identifier, assigned by TrackRegistry when the library is built.
+ * Tracks created outside the library keep INVALID_TRACK_ID and are identified by title.
+ */
+typedef uint32_t TrackId;
+const TrackId INVALID_TRACK_ID = UINT32_MAX;
+
+/**
+ * Heavy, immutable part of a track: shared by every copy of it (library, playlist,
+ * cache, deck) through a reference-counted block. Copying a track only bumps the
+ * count; replacing the waveform builds a new block (copy-on-write).
+ *
+ * The waveform is synthesized lazily, on first access, from a generator seeded
+ * with a stable hash of the track, so it costs nothing for tracks that are never
+ * analyzed and is identical from run to run. Materialization is thread-safe.
+ * Samples are stored in waveform_format (see WaveformBuffer) and dequantized on read.
+ * The min/max/RMS pyramid (see WaveformPyramid) is likewise built on first use.
+ */
+struct TrackPayload {
+    std::vector<std::string> artists;
+    size_t waveform_size;    // Known up front; footprint queries never materialize
+    uint64_t waveform_seed;
+    WaveformBuffer::Format waveform_format;
+    bool synthesized;        // false once assign() installed samples (they cannot be regenerated)
+
+    TrackPayload() : artists(), waveform_size(0), waveform_seed(0),
+                     waveform_format(WaveformBuffer::defaultFormat()), synthesized(true),
+                     waveform(), waveform_ready(), levels(), levels_ready() {}
+
+    /**
+     * @brief Dequantize the first count samples into out, synthesizing them on first call
+     */
+    void read(double* out, size_t count) const { read(0, out, count); }
+
+    /**
+     * @brief Dequantize samples [first, first + count) into out
+     */
+    void read(size_t first, double* out, size_t count) const;
+
+    /**
+     * @brief Install already computed samples (no synthesis will happen)
+     */
+    void assign(const double* data, size_t count);
+
+    /**
+     * @brief Multi-resolution summary of the waveform, built on first call
+     */
+    const WaveformPyramid& pyramid() const;
+
+private:
+    mutable WaveformBuffer waveform;
+    mutable std::once_flag waveform_ready;
+    mutable WaveformPyramid levels;
+    mutable std::once_flag levels_ready;
+};
+
 /**
  * Base class for all audio track types in the DJ library system.
  * This class demonstrates virtual functions, Rule of 5, and dynamic memory management.
@@ -12,19 +78,28 @@
  * - load(): lightweight, format-specific preparation when a track is assigned to a deck;
  *   sets readiness state and may log; does not start playback.
  * - analyze_beatgrid(): runs immediately after load() in this assignment to make BPM
- *   available for compatibility checks; results may be cached per instance.
+ *   available for compatibility checks; detects tempo and beats from the waveform
+ *   (see BeatGridAnalyzer) and stores the BeatGrid on the instance. Results are
+ *   memoized process-wide (see AnalysisCache), so clones and replays reuse them.
+ *   It also detects the track's musical key (see KeyDetector) as a Camelot index.
+ * - open_stream(): a fresh PCM reader over the track's audio for a deck in streaming
+ *   mode; a StreamingDecoder pulls fixed-size chunks from it so playback can start
+ *   before the whole track is decoded.
  * - clone(): used at the cache→mixer boundary; mixer always receives a polymorphic clone
- *   and owns it; the cache retains its own copy.
+ *   and owns it; the cache retains its own copy. Clones share the TrackPayload, so a
+ *   clone costs O(1) bytes regardless of waveform size; only title, duration, BPM and
+ *   ID are per copy (BPM is the one field changed after construction, by sync_bpm).
  * 
  */
 class AudioTrack {
 protected:
     std::string title;
-    std::vector<std::string> artists;
+    std::shared_ptr<const TrackPayload> payload;  // Artists and waveform (never null)
     int duration_seconds;
     int bpm;  // beats per minute for mixing
-    double* waveform_data;  // Dynamic array for audio analysis
-    size_t waveform_size;   // Size of the waveform array
+    TrackId id;             // Interned library ID (shared by all clones of a track)
+    std::shared_ptr<const BeatGrid> beat_grid;  // Set by analyze_beatgrid() (null before)
+    int camelot_key;        // Set by analyze_beatgrid() (HarmonicKey::UNKNOWN before or if unclear)
 
 public:
     /**
@@ -38,19 +113,19 @@ public:
 
     /**
      * TODO: Implement destructor
-     * HINT: Don't forget to clean up waveform_data!
+     * The shared payload is released with the last copy
      */
     virtual ~AudioTrack();
 
     /**
      * TODO: Implement copy constructor
-     * HINT: Deep copy the waveform_data array
+     * Shares the payload (no deep copy)
      */
     AudioTrack(const AudioTrack& other);
 
     /**
      * TODO: Implement copy assignment operator
-     * HINT: Check for self-assignment, clean up existing data, then deep copy
+     * Shares the other track's payload (no deep copy)
      */
     AudioTrack& operator=(const AudioTrack& other);
 
@@ -73,17 +148,19 @@ public:
      * Each format implements this differently
      * E.g., MP3 might decode headers, WAV might read chunks
      * This method sets up the track for playback
-     * Practically, it will read metadata and print information
+     * Practically, it will read metadata and print information (to out)
      */
-    virtual void load() = 0;
+    virtual void load(std::ostream& out) = 0;
+    void load();   // Prints to std::cout
 
     /**
      * Pure virtual function - analyze beat grid for mixing
      * Different formats may have different analysis methods
      * mostly for demonstration; in real systems this might be more complex
-     * This method simply prints a message for demonstration purposes
+     * This method simply prints a message (to out) for demonstration purposes
      */
-    virtual void analyze_beatgrid() = 0;
+    virtual void analyze_beatgrid(std::ostream& out) = 0;
+    void analyze_beatgrid();   // Prints to std::cout
 
     /**
      * Pure virtual function - calculate audio quality score
@@ -97,16 +174,54 @@ public:
      */
     virtual PointerWrapper<AudioTrack> clone() const = 0;
 
+    /**
+     * Pure virtual function - open a PCM stream over this track's audio
+     * Each call returns an independent reader positioned at the start of the track.
+     * Call after load() (a file-backed track streams its file once it is loaded).
+     */
+    virtual PointerWrapper<TrackStream> open_stream() const = 0;
+
+    /**
+     * Memory footprint of this track while it is held in controller memory:
+     * the format's audio payload plus the waveform analysis buffer.
+     * Used as the track's weight by byte-budgeted caches.
+     */
+    virtual size_t get_memory_footprint() const;
+
     /**
      * Function to get a copy of the waveform data
      */
     void get_waveform_copy(double* buffer, size_t buffer_size) const;
+
+    /**
+     * Replace the waveform with previously analyzed samples (e.g. from a cache snapshot)
+     */
+    void set_waveform(const double* samples, size_t sample_count);
+
+    /**
+     * Install the results of an earlier analysis of the same audio (e.g. from a cache
+     * snapshot) instead of running analyze_beatgrid()
+     */
+    void set_analysis(const std::shared_ptr<const BeatGrid>& grid, int key);
+
+    /**
+     * Re-encode the waveform in another sample format (copy-on-write, like set_waveform)
+     */
+    void set_waveform_format(WaveformBuffer::Format format);
+    WaveformBuffer::Format get_waveform_format() const { return payload->waveform_format; }
     
     // ========== ACCESSOR FUNCTIONS ==========
-    std::string get_title() const { return title; }
+    const std::string& get_title() const { return title; }
+    TrackId get_id() const { return id; }
+    void set_id(TrackId new_id) { id = new_id; }
     int get_bpm() const { return bpm; }
     int get_duration() const { return duration_seconds; }
-    std::vector<std::string> get_artists() const { return artists; }
+    size_t get_waveform_size() const { return payload->waveform_size; }
+    const std::shared_ptr<const TrackPayload>& get_payload() const { return payload; }  // Identity of the audio
+    const WaveformPyramid& get_waveform_pyramid() const { return payload->pyramid(); }
+    const BeatGrid* get_beat_grid() const { return beat_grid.get(); }
+    int get_camelot_key() const { return camelot_key; }
+    const std::vector<std::string>& get_artists() const { return payload->artists; }
 
     void set_bpm(int new_bpm) { bpm = new_bpm; }
 };
\ No newline at end of file
@@ -0,0 +1,27 @@
+#ifndef BEATGRID_H
+#define BEATGRID_H
+
+#include <vector>
+
+/**
+ * @brief Result of beat-grid analysis of one track's waveform
+ *
+ * Immutable once built and shared between copies of the track. When the
+ * tempo could not be detected (waveform too coarse, analysis out of time,
+ * or no periodicity), bpm is the track's configured BPM, confidence is 0 and
+ * the beats are laid out from that BPM.
+ */
+struct BeatGrid {
+    static constexpr double MIN_CONFIDENCE = 0.3;   // Below this, trust the configured BPM
+
+    double bpm;                 // Detected tempo (fractional)
+    double confidence;          // Normalized autocorrelation at the beat period, 0-1
+    std::vector<double> beats;  // Beat positions in seconds from the track start
+    bool complete;              // false if the per-track time budget cut analysis short
+
+    BeatGrid() : bpm(0.0), confidence(0.0), beats(), complete(true) {}
+
+    bool confident() const { return confidence >= MIN_CONFIDENCE; }
+};
+
+#endif // BEATGRID_H
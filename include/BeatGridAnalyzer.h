@@ -0,0 +1,81 @@
+#ifndef BEATGRIDANALYZER_H
+#define BEATGRIDANALYZER_H
+
+#include "AudioTrack.h"
+#include "BeatGrid.h"
+#include "Mp3File.h"
+#include "WavFile.h"
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Tempo and beat detection over a track's waveform
+ *
+ * The waveform spans the whole track, so its sample rate is
+ * waveform_size / duration. Analysis runs in three O(samples) passes:
+ *   1. onset strength: per-frame energy (~100 frames/s), half-wave rectified
+ *      first difference, mean removed;
+ *   2. tempo: normalized autocorrelation of the onset envelope over the lags
+ *      of 60-200 BPM, peak refined by parabolic interpolation, preferring
+ *      the double tempo when it is nearly as strong (octave errors);
+ *   3. beats: the phase of a comb at the detected period that collects the
+ *      most onset energy.
+ * Energy, difference and autocorrelation kernels use SSE2 (scalar elsewhere).
+ * For a track, the frame energies are read from its WaveformPyramid level
+ * closest to one frame (power-of-two hop), so repeated analysis of the same
+ * audio skips the sample pass. An MP3 file is analyzed in the compressed
+ * domain: one energy per granule (576 samples) from the frames' side
+ * information, without decoding the audio.
+ *
+ * Each call is bounded by a time budget that grows with the length of the
+ * audio; if it runs out, the grid falls back to the configured BPM and is
+ * marked incomplete. Building a track's waveform pyramid is not counted: it
+ * happens once per payload and every later analysis of the track reuses it.
+ */
+class BeatGridAnalyzer {
+public:
+    static constexpr double MIN_BPM = 60.0;
+    static constexpr double MAX_BPM = 200.0;
+    static constexpr double FRAME_RATE = 100.0;   // Target onset frames per second
+
+    /**
+     * @brief Analyze a track's waveform
+     * @return A new grid (never null)
+     */
+    static std::shared_ptr<const BeatGrid> analyze(const AudioTrack& track);
+
+    /**
+     * @brief Analyze raw samples covering duration_seconds of audio
+     * @param fallback_bpm Tempo used when none can be detected
+     */
+    static std::shared_ptr<const BeatGrid> analyze(const double* samples, size_t count, double duration_seconds,
+                                                   double fallback_bpm, std::chrono::microseconds budget);
+
+    /**
+     * @brief Analyze PCM in place (e.g. a mapped WAV file), one hop at a time
+     */
+    static std::shared_ptr<const BeatGrid> analyze(const WavFile::PcmView& pcm, double fallback_bpm,
+                                                   std::chrono::microseconds budget);
+
+    /**
+     * @brief Analyze an indexed MP3 file from its granule energies (no PCM decode)
+     */
+    static std::shared_ptr<const BeatGrid> analyze(const Mp3File& file, double fallback_bpm,
+                                                   std::chrono::microseconds budget);
+
+    /**
+     * @brief Time budget for analyzing duration_seconds of audio: the per-minute
+     * budget pro rata, and never less than one minute's worth
+     */
+    static std::chrono::microseconds timeBudget(double duration_seconds);
+
+    /**
+     * @brief Budget per minute of audio (default 100 ms)
+     */
+    static std::chrono::microseconds timeBudget();
+    static void setTimeBudget(std::chrono::microseconds per_minute);
+};
+
+#endif // BEATGRIDANALYZER_H
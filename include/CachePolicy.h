@@ -0,0 +1,274 @@
+#ifndef CACHEPOLICY_H
+#define CACHEPOLICY_H
+
+#include "PointerWrapper.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Key a policy sees for a track: its interned TrackId, or a title hash
+ * at or above 2^32 for tracks without one (see LRUCache). Ghost lists and the
+ * frequency sketch compare these integers, never titles.
+ */
+typedef uint64_t CacheKey;
+const CacheKey NO_CACHE_KEY = UINT64_MAX;   // victim() with no incoming track
+
+/**
+ * @brief Eviction strategy used by LRUCache (Strategy pattern)
+ *
+ * A policy never owns tracks. It only sees slot indices and track keys and
+ * decides which occupied slot should be evicted next. The cache owns the
+ * slots and drives the policy through the hooks below:
+ * - onMiss(key) is called for every lookup that did not hit, before any eviction.
+ * - victim(incoming) is called only when the cache is full and must return an
+ *   occupied slot. It only looks: the cache may still decide not to evict.
+ * - commitVictim(slot) is called once the cache does evict victim()'s choice,
+ *   just before onEvict() for that slot.
+ * - onInsert(slot, key) is called once the new entry has been stored.
+ * - onHit(slot) is called on every cache hit.
+ * - clone() copies the policy, so the cache can replay a sequence of hooks on
+ *   the copy before committing to it.
+ *
+ * All hooks are O(1) (amortised) for every policy provided here.
+ */
+class CachePolicy {
+public:
+    virtual ~CachePolicy() {}
+
+    /**
+     * @brief Short policy name as used by controller_cache_policy in dj_config.txt
+     */
+    virtual std::string name() const = 0;
+
+    /**
+     * @brief Forget all bookkeeping and prepare for a cache of the given capacity
+     */
+    virtual void reset(size_t capacity) = 0;
+
+    virtual void onMiss(CacheKey key) { (void)key; }
+    virtual void onHit(size_t slot) = 0;
+    virtual void onInsert(size_t slot, CacheKey key) = 0;
+    virtual size_t victim(CacheKey incoming) const = 0;
+    virtual void commitVictim(size_t slot) { (void)slot; }
+    virtual void onEvict(size_t slot, CacheKey key) = 0;
+
+    /**
+     * @brief Independent copy of the policy and all its bookkeeping (to try out evictions)
+     */
+    virtual PointerWrapper<CachePolicy> clone() const = 0;
+
+    /**
+     * @brief Create a policy by name (case-insensitive)
+     * @return Wrapped policy, or an empty wrapper if the name is unknown
+     */
+    static PointerWrapper<CachePolicy> create(const std::string& name);
+
+    /**
+     * @brief Names of all supported policies, in reporting order
+     */
+    static std::vector<std::string> names();
+};
+
+/**
+ * @brief Intrusive doubly linked list over slot indices (MRU at front)
+ */
+class SlotList {
+public:
+    SlotList();
+    void reset(size_t capacity);
+    void pushFront(size_t slot);
+    void remove(size_t slot);
+    void moveToFront(size_t slot) { remove(slot); pushFront(slot); }
+    size_t back() const { return tail; }
+    bool contains(size_t slot) const { return slot < member.size() && member[slot]; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+private:
+    std::vector<size_t> prev;
+    std::vector<size_t> next;
+    std::vector<bool> member;
+    size_t head;
+    size_t tail;
+    size_t count;
+};
+
+/**
+ * @brief Recency-ordered set of keys that are no longer resident (ghost entries)
+ */
+class GhostList {
+public:
+    GhostList() : order(), where() {}
+    GhostList(const GhostList& other);
+    GhostList& operator=(const GhostList&) = delete;
+    void pushFront(CacheKey key);
+    bool remove(CacheKey key);
+    bool contains(CacheKey key) const { return where.count(key) != 0; }
+    void popBack();
+    size_t size() const { return order.size(); }
+    void clear() { order.clear(); where.clear(); }
+
+private:
+    std::list<CacheKey> order;
+    std::unordered_map<CacheKey, std::list<CacheKey>::iterator> where;
+};
+
+/**
+ * @brief Least Recently Used
+ */
+class LRUPolicy : public CachePolicy {
+public:
+    LRUPolicy() : recency() {}
+    std::string name() const override { return "LRU"; }
+    void reset(size_t capacity) override { recency.reset(capacity); }
+    void onHit(size_t slot) override { recency.moveToFront(slot); }
+    void onInsert(size_t slot, CacheKey key) override;
+    size_t victim(CacheKey incoming) const override;
+    void onEvict(size_t slot, CacheKey key) override;
+    PointerWrapper<CachePolicy> clone() const override { return PointerWrapper<CachePolicy>(new LRUPolicy(*this)); }
+
+private:
+    SlotList recency;
+};
+
+/**
+ * @brief Least Frequently Used, ties broken by recency (O(1) frequency buckets)
+ *
+ * Buckets form a list in ascending frequency, each holding its slots most
+ * recent first. A hit moves the slot into the next bucket (created right
+ * after its own if missing), so the list stays sorted without a search, and
+ * the victim is always the last slot of the front bucket. Empty buckets are
+ * unlinked at once, so the front is the exact minimum even after an eviction.
+ */
+class LFUPolicy : public CachePolicy {
+public:
+    LFUPolicy() : buckets(), bucket_of(), pos() {}
+    LFUPolicy(const LFUPolicy& other);
+    LFUPolicy& operator=(const LFUPolicy&) = delete;
+    std::string name() const override { return "LFU"; }
+    void reset(size_t capacity) override;
+    void onHit(size_t slot) override;
+    void onInsert(size_t slot, CacheKey key) override;
+    size_t victim(CacheKey incoming) const override;
+    void onEvict(size_t slot, CacheKey key) override;
+    PointerWrapper<CachePolicy> clone() const override { return PointerWrapper<CachePolicy>(new LFUPolicy(*this)); }
+
+private:
+    struct Bucket {
+        uint64_t freq;
+        std::list<size_t> slots;   // Most recently used first
+    };
+
+    void unlinkSlot(size_t slot);
+
+    std::list<Bucket> buckets;                             // Ascending frequency
+    std::vector<std::list<Bucket>::iterator> bucket_of;    // Per occupied slot
+    std::vector<std::list<size_t>::iterator> pos;          // Per occupied slot, within its bucket
+};
+
+/**
+ * @brief 2Q: new entries go through a FIFO (A1in); keys seen again after leaving
+ * it (tracked in the A1out ghost list) are promoted to the main LRU queue (Am).
+ * A single scan through a long playlist therefore cannot flush Am.
+ */
+class TwoQueuePolicy : public CachePolicy {
+public:
+    TwoQueuePolicy() : a1in(), am(), a1out(), kin(1), kout(1) {}
+    std::string name() const override { return "2Q"; }
+    void reset(size_t capacity) override;
+    void onHit(size_t slot) override;
+    void onInsert(size_t slot, CacheKey key) override;
+    size_t victim(CacheKey incoming) const override;
+    void onEvict(size_t slot, CacheKey key) override;
+    PointerWrapper<CachePolicy> clone() const override { return PointerWrapper<CachePolicy>(new TwoQueuePolicy(*this)); }
+
+private:
+    SlotList a1in;
+    SlotList am;
+    GhostList a1out;
+    size_t kin;
+    size_t kout;
+};
+
+/**
+ * @brief Adaptive Replacement Cache: balances a recency list (T1) against a
+ * frequency list (T2), steering the split with hits in their ghost lists (B1/B2).
+ */
+class ARCPolicy : public CachePolicy {
+public:
+    ARCPolicy() : t1(), t2(), b1(), b2(), capacity(0), target_t1(0) {}
+    std::string name() const override { return "ARC"; }
+    void reset(size_t capacity) override;
+    void onMiss(CacheKey key) override;
+    void onHit(size_t slot) override;
+    void onInsert(size_t slot, CacheKey key) override;
+    size_t victim(CacheKey incoming) const override;
+    void onEvict(size_t slot, CacheKey key) override;
+    PointerWrapper<CachePolicy> clone() const override { return PointerWrapper<CachePolicy>(new ARCPolicy(*this)); }
+
+private:
+    void trimGhosts();
+
+    SlotList t1;
+    SlotList t2;
+    GhostList b1;
+    GhostList b2;
+    size_t capacity;
+    size_t target_t1;   // ARC's adaptive parameter p
+};
+
+/**
+ * @brief Count-Min sketch of 4-bit style saturating counters with periodic halving
+ */
+class FrequencySketch {
+public:
+    FrequencySketch() : table(), mask(0), additions(0), sample_size(0) {}
+    void reset(size_t capacity);
+    void increment(size_t hash);
+    unsigned frequency(size_t hash) const;
+
+private:
+    size_t indexOf(size_t hash, size_t row) const;
+
+    std::vector<uint8_t> table;   // 4 rows of (mask + 1) counters
+    size_t mask;
+    size_t additions;
+    size_t sample_size;
+};
+
+/**
+ * @brief W-TinyLFU: a small LRU admission window in front of a segmented LRU
+ * main area. When the window overflows, its LRU candidate only displaces the
+ * main area's victim if the frequency sketch says it is more popular.
+ */
+class TinyLFUPolicy : public CachePolicy {
+public:
+    TinyLFUPolicy()
+        : window(), probation(), protected_(), hashes(), sketch(),
+          window_cap(1), main_cap(0), protected_cap(0) {}
+    std::string name() const override { return "W-TinyLFU"; }
+    void reset(size_t capacity) override;
+    void onMiss(CacheKey key) override;
+    void onHit(size_t slot) override;
+    void onInsert(size_t slot, CacheKey key) override;
+    size_t victim(CacheKey incoming) const override;
+    void commitVictim(size_t slot) override;
+    void onEvict(size_t slot, CacheKey key) override;
+    PointerWrapper<CachePolicy> clone() const override { return PointerWrapper<CachePolicy>(new TinyLFUPolicy(*this)); }
+
+private:
+    SlotList window;
+    SlotList probation;
+    SlotList protected_;
+    std::vector<size_t> hashes;
+    FrequencySketch sketch;
+    size_t window_cap;
+    size_t main_cap;
+    size_t protected_cap;
+};
+
+#endif // CACHEPOLICY_H
@@ -0,0 +1,72 @@
+#ifndef CACHESIMULATOR_H
+#define CACHESIMULATOR_H
+
+#include "SessionFileParser.h"
+#include "TrackRegistry.h"
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Offline replay of a session's controller-cache access trace
+ *
+ * The trace is the sequence of loadTrackToCache keys a play-all session
+ * (`dj_manager -I -A`) would issue: playlists in name order, each expanded
+ * from its track indices in play order, with the cache carried over from
+ * one playlist to the next.
+ *
+ * The trace can be replayed through every CachePolicy (via ShadowCache, the
+ * same ID-only replay the controller uses to compare policies live) at any
+ * capacity, through Belady's optimal (OPT) policy, and summarized as an LRU
+ * reuse-distance histogram.
+ */
+class CacheSimulator {
+public:
+    /**
+     * @brief Expand every playlist of config into the access trace
+     * Invalid track indices are skipped, as DJLibraryService does.
+     */
+    static std::vector<std::string> buildTrace(const SessionConfig& config);
+
+    explicit CacheSimulator(const std::vector<std::string>& trace);
+
+    size_t accesses() const { return trace.size(); }
+    size_t distinctTracks() const { return registry.size(); }
+
+    /**
+     * @brief Miss ratio of a CachePolicy (by name) at the given capacity
+     */
+    double missRatio(const std::string& policy_name, size_t capacity) const;
+
+    /**
+     * @brief Miss ratio of Belady's OPT: on eviction, drop the track whose next
+     * access is farthest in the future. A lower bound for every policy.
+     */
+    double optimalMissRatio(size_t capacity) const;
+
+    /**
+     * @brief LRU stack distance histogram
+     * @return counts[d] = re-accesses with d distinct tracks accessed since the
+     * previous access of the same track; first accesses are counted by coldMisses()
+     */
+    std::vector<size_t> reuseDistances() const;
+    size_t coldMisses() const { return registry.size(); }
+
+    /**
+     * @brief CSV: capacity, then one miss-ratio column per policy and OPT
+     */
+    void writeMissRatioCurves(std::ostream& out, const std::vector<size_t>& capacities) const;
+
+    /**
+     * @brief CSV: reuse distance, accesses, cumulative LRU hit ratio at capacity distance + 1
+     */
+    void writeReuseHistogram(std::ostream& out) const;
+
+private:
+    std::vector<std::string> trace;
+    std::vector<TrackId> ids;    // trace interned to dense IDs
+    TrackRegistry registry;
+};
+
+#endif // CACHESIMULATOR_H
@@ -4,6 +4,14 @@
 #include "PointerWrapper.h"
 #include <cstddef>
 #include <cstdint>
+#include <memory>
+
+/**
+ * @brief Shared, read-only handle to a cached track.
+ * Stays valid after the cache evicts the entry, so it can be read safely
+ * while another thread keeps using the cache.
+ */
+typedef std::shared_ptr<const AudioTrack> TrackHandle;
 
 /**
  * @brief Single Cache Entry with LRU Metadata (Single Responsibility)
@@ -14,16 +22,27 @@
  *
  * Phase 4 usage:
  * - Each slot holds exactly one cached track instance owned by the controller.
+ *   Ownership is reference counted so share() handles can outlive eviction.
  * - access() updates last_access_time to reflect MRU/LRU policy.
  * - clear() releases ownership; callers log evictions as needed.
+ * - prev/next are intrusive links owned by LRUCache: they chain occupied
+ *   slots in recency order and free slots in a free list.
  */
 class CacheSlot {
 private:
-    PointerWrapper<AudioTrack> track;    // The cached track
+    std::shared_ptr<AudioTrack> track;   // The cached track
     uint64_t last_access_time;           // For LRU algorithm
     bool occupied;                       // Is this slot in use?
+    size_t bytes;                        // Memory footprint of the cached track
+    size_t prev;                         // Neighbour towards MRU (or npos)
+    size_t next;                         // Neighbour towards LRU / next free slot (or npos)
 
 public:
+    /**
+     * @brief Sentinel link value meaning "no slot"
+     */
+    static const size_t npos = static_cast<size_t>(-1);
+
     /**
      * @brief Construct empty cache slot
      */
@@ -57,9 +76,25 @@ public:
      * @brief Get last access time for LRU comparison
      */
     uint64_t getLastAccessTime() const { return last_access_time; }
+
+    /**
+     * @brief Get the memory footprint recorded when the track was stored
+     */
+    size_t getBytes() const { return bytes; }
     
     /**
      * @brief Get track without updating access time
      */
     AudioTrack* getTrack() const { return track.get(); }
+
+    /**
+     * @brief Get a shared handle to the track without updating access time
+     */
+    TrackHandle share() const { return track; }
+
+    // ========== INTRUSIVE LIST LINKS (managed by LRUCache) ==========
+    size_t getPrev() const { return prev; }
+    size_t getNext() const { return next; }
+    void setPrev(size_t slot) { prev = slot; }
+    void setNext(size_t slot) { next = slot; }
 };
\ No newline at end of file
@@ -0,0 +1,89 @@
+#ifndef CACHESNAPSHOT_H
+#define CACHESNAPSHOT_H
+
+#include "AudioTrack.h"
+#include "BeatGrid.h"
+#include "CacheSlot.h"
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Binary snapshot of the controller cache, used to warm-start a session
+ *
+ * File layout (native byte order, every block 8-byte aligned):
+ *   header: "DJCS", version, entry count, reserved        (4 x uint32)
+ *   entry:  title length, format, duration, bpm           (4 x uint32)
+ *           waveform seed, waveform sample count           (2 x uint64)
+ *           detected BPM, confidence, first beat           (3 x double)
+ *           beat count, Camelot key, flags, reserved       (4 x uint32)
+ *           title bytes, zero-padded to a multiple of 8
+ * Entries are stored least recently used first, so re-inserting them in
+ * file order reproduces the recency order.
+ *
+ * The waveform is not stored: it is synthesized from its seed, so a seed
+ * that matches the library track's identifies the same audio. What is
+ * stored is what analysis produced, the beat grid (its beats are evenly
+ * spaced, so the first beat and the count rebuild them) and the key, so
+ * restored tracks come back analyzed. A track whose waveform was replaced
+ * (see AudioTrack::set_waveform) cannot be rebuilt from its seed and is
+ * saved flagged as such.
+ */
+class CacheSnapshot {
+public:
+    enum Format : uint32_t { FORMAT_OTHER = 0, FORMAT_MP3 = 1, FORMAT_WAV = 2 };
+
+    static constexpr uint32_t MAX_BEATS = 1u << 20;   // About 87 hours at 200 BPM; more is a corrupt file
+
+    struct Entry {
+        std::string title;
+        uint32_t format;
+        int duration;
+        int bpm;
+        uint64_t waveform_seed;
+        size_t waveform_size;
+        bool synthesized;                          // false: the saved waveform is not the seed's
+        std::shared_ptr<const BeatGrid> beat_grid; // null if the track was saved before analysis
+        int camelot_key;
+        Entry()
+            : title(), format(FORMAT_OTHER), duration(0), bpm(0), waveform_seed(0), waveform_size(0),
+              synthesized(true), beat_grid(), camelot_key(HarmonicKey::UNKNOWN) {}
+    };
+
+    /**
+     * @brief Write tracks (least recently used first) to path
+     * The file is written next to path and renamed over it, so a crash never
+     * leaves a truncated snapshot behind.
+     * @return false if the file could not be written
+     */
+    static bool save(const std::string& path, const std::vector<TrackHandle>& tracks);
+
+    /**
+     * @brief Format tag stored for a track (and compared on restore)
+     */
+    static uint32_t formatOf(const AudioTrack& track);
+
+    /**
+     * @brief Map and validate the snapshot at path
+     * A missing, truncated or foreign file yields an empty snapshot (is_open() == false).
+     */
+    explicit CacheSnapshot(const std::string& path);
+
+    CacheSnapshot(const CacheSnapshot&) = delete;
+    CacheSnapshot& operator=(const CacheSnapshot&) = delete;
+
+    bool is_open() const { return mapped.is_open(); }
+    const std::vector<Entry>& entries() const { return parsed; }
+
+private:
+    bool parse();
+    void unmap();
+
+    MappedFile mapped;
+    std::vector<Entry> parsed;
+};
+
+#endif // CACHESNAPSHOT_H
@@ -0,0 +1,117 @@
+#ifndef CONCURRENTTRACKCACHE_H
+#define CONCURRENTTRACKCACHE_H
+
+#include "AudioTrack.h"
+#include "CacheSlot.h"
+#include "PointerWrapper.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Thread-safe controller cache split into independently locked shards
+ *
+ * Entries are keyed by interned TrackId; tracks without one are never stored.
+ * IDs are dense, so ID modulo the shard count spreads them evenly. A shard
+ * owns a fixed share of the total capacity, its own mutex and its own index,
+ * so loaders working on different tracks rarely contend. Inside a shard, eviction uses the CLOCK algorithm
+ * (approximate LRU): a hit only sets a reference bit, and the clock hand gives
+ * referenced entries a second chance before evicting them.
+ *
+ * Tracks are handed out as TrackHandle (shared ownership), so a handle stays
+ * readable even if another thread evicts the entry in the meantime.
+ */
+class ConcurrentTrackCache {
+public:
+    static constexpr int ALREADY_CACHED = 2;   // tryPut(): another copy was cached first
+
+    /**
+     * @param capacity Total number of tracks across all shards
+     * @param shard_count Requested number of shards (clamped to [1, capacity])
+     */
+    ConcurrentTrackCache(size_t capacity, size_t shard_count);
+
+    bool contains(TrackId id) const;
+
+    /**
+     * @brief Get a track and mark it recently used
+     * @return Handle to the track, or an empty handle on MISS
+     */
+    TrackHandle get(TrackId id);
+
+    /**
+     * @brief Put a track into its shard (evicts inside that shard if full)
+     * @param track Track to cache (transfers ownership)
+     * @return true if an eviction occurred, false otherwise (including when
+     * the track was already cached; the cached copy is kept and touched)
+     */
+    bool put(PointerWrapper<AudioTrack> track);
+
+    /**
+     * @brief put() telling every outcome apart, decided under the shard's lock
+     * @return 1 if stored after an eviction, 0 if stored without eviction,
+     * ALREADY_CACHED if the track was cached first (that copy is kept and touched),
+     * -1 if not stored (including a track without an ID)
+     */
+    int tryPut(PointerWrapper<AudioTrack> track);
+
+    /**
+     * @brief Put a track without evicting any entry whose ID is listed in keep
+     * The CLOCK sweep skips kept entries; if every entry of the shard is kept,
+     * nothing is stored.
+     * @return true if the track was stored
+     */
+    bool putUnless(PointerWrapper<AudioTrack> track, const std::vector<TrackId>& keep);
+
+    size_t size() const;
+
+    /**
+     * @brief Handles to all cached tracks, shard by shard in ring order
+     * (CLOCK keeps no exact recency order)
+     */
+    std::vector<TrackHandle> entries() const;
+
+    size_t capacity() const { return total_capacity; }
+    size_t shard_count() const { return shards.size(); }
+    void clear();
+
+    /**
+     * @brief Display per-shard occupancy and CLOCK state
+     */
+    void displayStatus() const;
+
+private:
+    struct Entry {
+        std::shared_ptr<AudioTrack> track;
+        TrackId key;
+        bool referenced;    // CLOCK reference bit
+        Entry() : track(), key(INVALID_TRACK_ID), referenced(false) {}
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<TrackId, size_t> index;  // key -> ring position
+        std::vector<Entry> ring;
+        size_t hand;
+        size_t used;
+        explicit Shard(size_t capacity) : mutex(), index(), ring(capacity), hand(0), used(0) {}
+    };
+
+    Shard& shardFor(TrackId id) const;
+
+    /**
+     * @brief Shared insert path for put() and putUnless()
+     * @return 1 if stored after an eviction, 0 if stored without eviction,
+     * ALREADY_CACHED (touched unless keep is given), -1 if not stored (no room
+     * or only kept victims)
+     */
+    int insert(PointerWrapper<AudioTrack> track, const std::vector<TrackId>* keep);
+
+    std::vector<PointerWrapper<Shard>> shards;
+    size_t total_capacity;
+};
+
+#endif // CONCURRENTTRACKCACHE_H
@@ -3,14 +3,36 @@
 
 #include "LRUCache.h"
 #include "CacheSlot.h"
+#include "ConcurrentTrackCache.h"
+#include "ShadowCache.h"
 #include "PointerWrapper.h"
+#include <iosfwd>
+#include <mutex>
 #include <string>
+#include <vector>
 
 /**
  * Service responsible for managing the controller's memory (cache)
- * Cache capacity is fixed, and the tracks are managed with LRU policy.
- * On HIT: touch MRU (most recently used); on MISS: insert; if full, evict LRU.
+ * Cache capacity is fixed, and the tracks are managed with LRU policy by default
+ * (LFU, 2Q, ARC or W-TinyLFU can be selected with set_cache_policy).
+ * On HIT: touch MRU (most recently used); on MISS: insert; if full, evict the policy's victim.
  * - Mixer always receives a polymorphic clone; cache retains its copy.
+ * - Every request is also replayed through one ID-only ShadowCache per policy,
+ *   so hit ratios of all policies can be compared on the same session. Shadows
+ *   share the cache's slot count and byte budget, weighing each track by its footprint.
+ * - Thread safety: all methods may be called concurrently. The single LRUCache is
+ *   guarded by one mutex; with set_cache_shards(n > 1) the service switches to a
+ *   ConcurrentTrackCache whose shards lock independently (CLOCK approximate LRU).
+ *   clone()/load()/analyze_beatgrid() on a MISS always run outside any lock.
+ * - Byte budget: with set_cache_bytes(n > 0) entries are weighted by their memory
+ *   footprint. A track larger than the whole budget bypasses the cache: it is held
+ *   aside (without evicting anything) until the next oversized track replaces it.
+ * - Prefetch: prefetchTrackToCache warms a track ahead of demand (see TrackPrefetcher).
+ *   It never evicts a track whose ID is in its keep list, and the first demand HIT on
+ *   a prefetched entry is reported separately so prefetch accuracy can be measured.
+ * - Keys: behind the title-based lookups meant for the UI, requests, shadows, prefetch
+ *   marks and the sharded cache are keyed by interned TrackId. Tracks without an ID
+ *   are cached in single-cache mode only and are not replayed through the shadows.
  */
 class DJControllerService {
 public:
@@ -19,9 +41,42 @@ public:
 
     // Contract: Ensure a track is present in cache by key (full playlist line)
     // Input: A reference to an AudioTrack.
-    // Output: An integer indicating the result: 1 for HIT, 0 for MISS without eviction, -1 for MISS with eviction.
+    // Output: An integer indicating the result: 1 for HIT, 0 for MISS without eviction, -1 for MISS with eviction,
+    // 2 for a HIT on an entry that was prefetched and not requested since.
+    // If another thread inserts the same track while this one is preparing it, the
+    // result is reported as a HIT and the duplicate copy is discarded.
     int loadTrackToCache(AudioTrack& track);
 
+    /**
+     * @brief Warm a track into the cache ahead of demand.
+     * @param track Library track to clone, load and analyze (read only).
+     * @param keep IDs of tracks that must not be evicted to make room (now playing, up next).
+     * @param log Receives everything the clone's load()/analyze_beatgrid() and the
+     * prefetch itself print, so a worker never writes std::cout.
+     * @return true if the track was stored by this call; false if it was already
+     * cached, has no ID, or storing it would have evicted a kept track.
+     * @note Safe to call from a background thread; not replayed through the shadow caches.
+     */
+    bool prefetchTrackToCache(AudioTrack& track, const std::vector<TrackId>& keep, std::ostream& log);
+
+    /**
+     * @brief Write the cached tracks (keys, recency order, BPM, waveform seed, beat grid and key)
+     * to a snapshot file.
+     * @return false if the file could not be written.
+     */
+    bool saveCacheSnapshot(const std::string& path) const;
+
+    /**
+     * @brief Warm the cache from a snapshot written by saveCacheSnapshot.
+     * Each entry is matched by title against the library and must agree on format,
+     * duration, BPM, waveform size and waveform seed; stale entries are dropped. Restored
+     * tracks skip load()/analyze_beatgrid(), come back with the beat grid and key they
+     * were saved with, and keep their snapshot recency order.
+     * @param library Tracks of the current library (not owned).
+     * @return Number of tracks restored.
+     */
+    size_t restoreCacheSnapshot(const std::string& path, const std::vector<AudioTrack*>& library);
+
 
     // Contract: Display cache status (LRU order and occupancy)
     // - Intended for debugging and interactive inspection
@@ -33,15 +88,95 @@ public:
      * @note This function is meant for a single usage. don't call it more then once.
      */
     void set_cache_size(size_t new_size);
+
+    /**
+     * @brief Limit the controller cache by total track footprint.
+     * @param bytes Budget in bytes, or 0 to limit by slot count only.
+     * @note Applies to the single LRUCache; the sharded cache counts slots.
+     */
+    void set_cache_bytes(size_t bytes);
+
+    /**
+     * @brief Select the eviction policy of the controller cache.
+     * @param policy_name One of CachePolicy::names() (case-insensitive).
+     * @return false if the name is unknown; the current policy is kept.
+     */
+    bool set_cache_policy(const std::string& policy_name);
+
+    /**
+     * @brief Name of the active eviction policy ("CLOCK" in sharded mode).
+     */
+    std::string getCachePolicyName() const;
+
+    /**
+     * @brief Switch between the single LRUCache (shards <= 1) and the sharded
+     * concurrent cache (shards > 1). Cached tracks are dropped.
+     * @note Like set_cache_size, meant to be called once while configuring.
+     */
+    void set_cache_shards(size_t shards);
+
+    /**
+     * @brief Number of independently locked shards (1 in single-cache mode).
+     */
+    size_t getCacheShardCount() const;
+
+    /**
+     * @brief Display the hit ratio every supported policy would have achieved
+     * on the requests seen so far, at the current cache capacity and byte budget.
+     */
+    void displayPolicyHitRatios() const;
     /**
      * @brief Get a track from the cache by its title.
      * @param track_title The title of the track to retrieve.
      * @return A raw pointer to the track if found, otherwise nullptr. Does not transfer ownership.
+     * Single-cache mode only: a sharded cache is shared with other threads, so
+     * nothing would keep the track alive; it always returns nullptr there (use
+     * acquireTrack and hold the handle).
      */
     AudioTrack* getTrackFromCache(const std::string& track_title);
 
+    /**
+     * @brief Get a shared handle to a cached track (updates recency).
+     * @param track_title The title of the track to retrieve.
+     * @return Handle that stays valid even if the track is evicted meanwhile,
+     * or an empty handle on MISS. Prefer this over getTrackFromCache whenever
+     * other threads use the controller. In sharded mode the title is resolved
+     * by scanning the cached entries, as the shards are keyed by ID.
+     */
+    TrackHandle acquireTrack(const std::string& track_title);
+
+    /**
+     * @brief Same as acquireTrack(title), keyed by the track's interned ID when it has one
+     * (always in sharded mode, where a track without an ID is never cached).
+     * @param track Any copy of the wanted track (e.g. the library or playlist instance).
+     */
+    TrackHandle acquireTrack(const AudioTrack& track);
+
 private:
+    /**
+     * @brief Recreate one empty shadow cache per policy at the current capacity and byte budget.
+     */
+    void resetShadows();
+
+    /**
+     * @brief Single-cache lookup that touches the entry on HIT (cache_mutex must be held).
+     */
+    TrackHandle acquireLocked(const AudioTrack& track);
+
+    /**
+     * @brief MISS path of loadTrackToCache: clone, load, analyze and store the track.
+     * @return 0 or -1 as loadTrackToCache, or 1 if another thread cached the track first.
+     */
+    int cacheClone(AudioTrack& track);
+
     LRUCache cache;
+    PointerWrapper<ConcurrentTrackCache> sharded;  // Set only in sharded mode
+    TrackHandle oversized;  // Last track that exceeded the byte budget (bypasses the cache)
+    std::vector<bool> prefetched;  // By TrackId: prefetched and not yet requested on demand
+    std::vector<ShadowCache> shadows;
+    mutable std::mutex cache_mutex;   // Guards cache (single mode)
+    mutable std::mutex shadow_mutex;  // Guards shadows
+    mutable std::mutex prefetch_mutex;  // Guards prefetched
 };
 
 #endif // DJCONTROLLERSERVICE_H
@@ -4,6 +4,8 @@
 #include "Playlist.h"
 #include "AudioTrack.h"
 #include "SessionFileParser.h"
+#include "TrackRegistry.h"
+#include "TrackTable.h"
 #include <vector>
 #include <string>
 
@@ -11,10 +13,14 @@
 // Phase 4 behavior alignment:
 // - Load library tracks from config file
 // - Build playlists from track indices referencing the library
+// - Every library title is interned to a dense TrackId; playlists, cache and session
+//   refer to tracks by ID and titles are only looked up for display
+// - Library-wide metadata queries (BPM ranges, totals, best quality) run over a
+//   columnar TrackTable built alongside the library
 class DJLibraryService {
 public:
     DJLibraryService(const Playlist& playlist);
-    DJLibraryService(): playlist(), library(){}
+    DJLibraryService(): playlist(), library(), registry(), table(){}
     ~DJLibraryService();
     DJLibraryService(const DJLibraryService& other);
     DJLibraryService& operator=(const DJLibraryService& other);
@@ -46,15 +52,50 @@ public:
      */
     AudioTrack* findTrack(const std::string& track_title);
 
+    /**
+     * @brief Find a track of the current playlist by its interned ID.
+     * @return A raw pointer to the AudioTrack if found, otherwise nullptr.
+     */
+    AudioTrack* findTrack(TrackId track_id);
+
+    /**
+     * @brief Title of an interned track ID (for display).
+     */
+    const std::string& getTrackTitle(TrackId track_id) const { return registry.title(track_id); }
+
+    /**
+     * @brief Get the IDs of all tracks in the current playlist, in playlist order.
+     */
+    std::vector<TrackId> getTrackIds() const;
+
     /**
      * @brief Get a vector of all track titles in the current playlist.
      * @return A vector of strings containing the track titles.
      */
     std::vector<std::string> getTrackTitles() const;
 
+    /**
+     * @brief All tracks of the library (the library retains ownership).
+     */
+    const std::vector<AudioTrack*>& getLibrary() const { return library; }
+
+    /**
+     * @brief Columnar metadata of the library (row i is getLibrary()[i]).
+     */
+    const TrackTable& getTrackTable() const { return table; }
+
+    /**
+     * @brief Library tracks within +-tolerance BPM of bpm, closest BPM first (ties in
+     * library order). Scans and ranks on the TrackTable's BPM column; no track is
+     * dereferenced until the result is built.
+     */
+    std::vector<const AudioTrack*> findMixCandidates(int bpm, int tolerance) const;
+
 private:
     Playlist playlist;
     std::vector<AudioTrack*> library;  // Library of all tracks (owned)
+    TrackRegistry registry;            // Title <-> TrackId for every library track
+    TrackTable table;                  // Scalar metadata columns, rebuilt with the library
 };
 
 #endif // DJLIBRARYSERVICE_H
@@ -2,9 +2,11 @@
 
 #include "DJLibraryService.h"
 #include "DJControllerService.h"
+#include "TrackPrefetcher.h"
 #include "MixingEngineService.h"
 #include "SessionFileParser.h"
 #include "ConfigurationManager.h"
+#include "MixdownRenderer.h"
 #include <string>
 #include <vector>
 
@@ -34,21 +36,24 @@ private:
     DJLibraryService library_service;
     DJControllerService controller_service;
     MixingEngineService mixing_service;
+    TrackPrefetcher prefetcher;  // Warms upcoming playlist tracks into controller_service
     
     // Configuration and session state
     ConfigurationManager config_manager;
     SessionConfig session_config;
-    std::vector<std::string> track_titles;
+    std::vector<TrackId> track_ids;  // Current playlist in play order
     bool play_all;
+    bool mixdown_only;  // Set by render_mixdown: the snapshot was never restored, so it is not saved either
     // Session statistics
     struct SessionStats {
         size_t tracks_processed = 0;
         size_t cache_hits = 0;
+        size_t prefetch_hits = 0;  // Cache hits served by a prefetched entry
         size_t cache_misses = 0;
         size_t cache_evictions = 0;
-        size_t deck_loads_a = 0;
-        size_t deck_loads_b = 0;
+        std::vector<size_t> deck_loads = std::vector<size_t>(2, 0);  // Per deck, sized by deck_count
         size_t transitions = 0;
+        size_t borrowed_loads = 0;  // Deck loads that played the cached track in place (no clone)
         size_t errors = 0;
     } stats;
 
@@ -88,23 +93,33 @@ public:
 
     /**
      * Contract: Demand-load a track into the controller cache.
-     * - Input: The name of the track to load.
-     * - Output: An integer indicating a HIT (1) or MISS (0).
+     * - Input: The interned ID of the track to load.
+     * - Output: An integer indicating a HIT (1), a HIT on a prefetched entry (2) or MISS (0).
      */
-    int load_track_to_controller(const std::string& track_name);
+    int load_track_to_controller(TrackId track_id);
 
     /**
      * Contract: Load a cached track into a mixer deck (instant-transition model)
-     * - Input: track title (or key).
+     * - Input: interned track ID.
      * - Output: true on success; false if not found in cache or clone fails
+     * - The deck borrows the cached track through its pinned handle when the mixer allows
+     *   it (MixingEngineService::can_borrow) and gets a clone otherwise.
      */
-    bool load_track_to_mixer_deck(const std::string& track_title);
+    bool load_track_to_mixer_deck(TrackId track_id);
 
     /**
      * Contract: Orchestrate the DJ performance simulation
      */
     void simulate_dj_performance();
 
+    /**
+     * Contract: Headless render of a playlist's full mix to a WAV file
+     * - Walks the playlist as start_playlist() does (controller cache, decks, sync),
+     *   then renders every track with its crossfades (see MixdownRenderer).
+     * - Output: true if the file was written
+     */
+    bool render_mixdown(const std::string& playlist_name, const std::string& output_path);
+
 
     // ========== STATUS & DISPLAY METHODS ==========
 
@@ -133,6 +148,13 @@ private:
 
     /**
      * play all the tracks of given playlist
+     * (mixdown, if given, receives a copy of each track as its deck plays it)
+     */
+    void start_playlist(std::string playlist_name, MixdownRenderer* mixdown = nullptr);
+
+    /**
+     * @brief Without auto_sync, name library tracks that would mix with the playing deck
+     * when the incoming track is off its tempo (a TrackTable BPM scan)
      */
-    void start_playlist(std::string playlist_name);
+    void suggest_mix_candidates(const AudioTrack& incoming) const;
 };
\ No newline at end of file
@@ -0,0 +1,108 @@
+#ifndef DECKMIXER_H
+#define DECKMIXER_H
+
+#include "CrossfadeRenderer.h"
+#include "PointerWrapper.h"
+#include "StreamingDecoder.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Playback side of the mixing engine: one decoder per deck and the crossfade between them
+ *
+ * render() mixes the active deck with every deck still fading out (see
+ * CrossfadeRenderer). Deck state only changes through apply(), so the same
+ * Commands drive the mixer directly from the loading thread or, queued, from
+ * a MixerThread. Neither render() nor apply() allocates, locks or frees: a
+ * decoder taken off a deck is handed back in its command, for the sender to
+ * free (destroying a StreamingDecoder joins its producer thread).
+ */
+class DeckMixer {
+public:
+    struct Command {
+        enum Type { LOAD, SET_CROSSFADER, SYNC, UNLOAD };
+
+        Type type;
+        size_t deck;
+        PointerWrapper<StreamingDecoder> stream;   // LOAD, SYNC: decoder to play; once applied, the one it replaced
+        size_t fade_frames;                        // LOAD: transition length (0 = cut)
+        CrossfadeRenderer::Curve curve;            // SET_CROSSFADER: curve of later transitions
+        uint64_t position;                         // SYNC: frames the deck had played when stream was cued
+        double skip_ratio;                         // SYNC: stream frames to skip per frame played since then
+
+        Command()
+            : type(LOAD), deck(0), stream(), fade_frames(0), curve(CrossfadeRenderer::LINEAR), position(0),
+              skip_ratio(1.0) {}
+
+        static Command load(size_t deck, PointerWrapper<StreamingDecoder> stream, size_t fade_frames);
+        static Command crossfader(CrossfadeRenderer::Curve curve);
+        static Command sync(size_t deck, PointerWrapper<StreamingDecoder> stream, uint64_t position,
+                            double skip_ratio);
+        static Command unload(size_t deck);
+    };
+
+    explicit DeckMixer(size_t count = 2);
+
+    DeckMixer(const DeckMixer&) = delete;
+    DeckMixer& operator=(const DeckMixer&) = delete;
+
+    /**
+     * @brief Set the number of decks (at least 1) and drop every decoder
+     * Allocates: never while a MixerThread renders this mixer.
+     */
+    void set_deck_count(size_t count);
+    size_t deck_count() const { return decks.size(); }
+
+    /**
+     * @brief Carry out a command. Commands for decks that do not exist are ignored.
+     * - LOAD: put the decoder on the deck and make it active; every other audible
+     *   deck fades out from its current gain over fade_frames.
+     * - SET_CROSSFADER: curve of the transitions started afterwards.
+     * - SYNC: swap the deck's decoder in place (gains and transition untouched),
+     *   first skipping what the deck played since the new decoder was cued.
+     * - UNLOAD: take the deck's decoder out; the deck falls silent.
+     * On return command.stream holds the decoder taken off the deck (empty if none).
+     */
+    void apply(Command& command);
+
+    /**
+     * @brief Render up to frames of the mix into out (never blocks)
+     * @return Frames rendered; fewer when the active deck's decoder is behind or its track has ended
+     */
+    size_t render(double* out, size_t frames);
+
+    /**
+     * @brief Consume up to frames of one deck's decoded PCM (non-blocking)
+     */
+    size_t read(size_t deck, double* out, size_t frames);
+
+    StreamingDecoder* stream(size_t deck) const {
+        return deck < decks.size() && decks[deck].stream ? decks[deck].stream.get() : nullptr;
+    }
+    size_t active() const { return active_deck; }
+    bool in_transition() const { return crossfader.active(); }
+    CrossfadeRenderer::Curve curve() const { return crossfader.curve(); }
+
+private:
+    struct Deck {
+        PointerWrapper<StreamingDecoder> stream;
+        double level;   // Gain when the current transition started
+
+        Deck() : stream(), level(0.0) {}
+    };
+
+    double gain(size_t deck) const;
+
+    std::vector<Deck> decks;
+    size_t active_deck;
+    CrossfadeRenderer crossfader;
+    // Render scratch, preallocated per deck: one block of samples each, and the
+    // sources and gains of the block being mixed
+    std::vector<double> deck_blocks;
+    std::vector<const double*> sources;
+    std::vector<double> gain_start;
+    std::vector<double> gain_end;
+};
+
+#endif // DECKMIXER_H
@@ -0,0 +1,105 @@
+#ifndef DECKPOLICY_H
+#define DECKPOLICY_H
+
+#include "PointerWrapper.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Chooses the deck the next track is loaded to (Strategy pattern)
+ *
+ * A policy never owns decks. MixingEngineService drives it through the hooks below:
+ * - reset(decks) when the deck count is set; all decks are empty afterwards.
+ * - target(active) before every load; active is NO_DECK while all decks are empty.
+ *   The returned deck must be below the deck count.
+ * - onLoad(deck) once the track is on the deck.
+ */
+class DeckPolicy {
+public:
+    static const size_t NO_DECK = static_cast<size_t>(-1);
+
+    virtual ~DeckPolicy() {}
+
+    /**
+     * @brief Policy name as used by deck_policy in dj_config.txt
+     */
+    virtual std::string name() const = 0;
+
+    virtual PointerWrapper<DeckPolicy> clone() const = 0;
+
+    virtual void reset(size_t decks) = 0;
+    virtual size_t target(size_t active) const = 0;
+    virtual void onLoad(size_t deck) { (void)deck; }
+
+    /**
+     * @brief Pick the deck for the following loads
+     * @return false if the deck is out of range or the policy ignores cues
+     */
+    virtual bool cue(size_t deck) { (void)deck; return false; }
+
+    /**
+     * @brief Create a policy by name (case-insensitive)
+     * @return Wrapped policy, or an empty wrapper if the name is unknown
+     */
+    static PointerWrapper<DeckPolicy> create(const std::string& name);
+
+    /**
+     * @brief Names of all supported policies
+     */
+    static std::vector<std::string> names();
+};
+
+/**
+ * @brief Cycles through the decks (A -> B -> A with two decks)
+ */
+class RoundRobinDeckPolicy : public DeckPolicy {
+public:
+    RoundRobinDeckPolicy() : decks(1) {}
+    std::string name() const override { return "round_robin"; }
+    PointerWrapper<DeckPolicy> clone() const override;
+    void reset(size_t count) override { decks = count ? count : 1; }
+    size_t target(size_t active) const override { return active == NO_DECK ? 0 : (active + 1) % decks; }
+
+private:
+    size_t decks;
+};
+
+/**
+ * @brief Loads to the deck whose last load is the oldest; empty decks come
+ * first, lowest index first. With two decks this matches round-robin.
+ */
+class LeastRecentDeckPolicy : public DeckPolicy {
+public:
+    LeastRecentDeckPolicy() : loaded_at(1, 0), loads(0) {}
+    std::string name() const override { return "lru"; }
+    PointerWrapper<DeckPolicy> clone() const override;
+    void reset(size_t count) override;
+    size_t target(size_t active) const override;
+    void onLoad(size_t deck) override;
+
+private:
+    std::vector<uint64_t> loaded_at;   // Load sequence number per deck (0 = never loaded)
+    uint64_t loads;
+};
+
+/**
+ * @brief Loads to the deck chosen with cue() (deck 0 until cued), e.g. a
+ * sample deck that is reloaded while the others keep their tracks
+ */
+class ExplicitDeckPolicy : public DeckPolicy {
+public:
+    ExplicitDeckPolicy() : decks(1), cued(0) {}
+    std::string name() const override { return "explicit"; }
+    PointerWrapper<DeckPolicy> clone() const override;
+    void reset(size_t count) override;
+    size_t target(size_t active) const override { (void)active; return cued; }
+    bool cue(size_t deck) override;
+
+private:
+    size_t decks;
+    size_t cued;
+};
+
+#endif // DECKPOLICY_H
@@ -0,0 +1,51 @@
+#ifndef HARMONICKEY_H
+#define HARMONICKEY_H
+
+#include <string>
+
+/**
+ * @brief Result of key detection on one track's audio
+ *
+ * Keys are numbered on the Camelot wheel, the DJ notation of the circle of
+ * fifths: 1A-12A are the minor keys and 1B-12B the major keys, neighbouring
+ * numbers are a fifth apart and nA / nB are relative minor and major. The
+ * index of nA is 2 * (n - 1) and the index of nB is 2 * (n - 1) + 1.
+ *
+ * Immutable once built and shared between copies of the track. camelot is
+ * UNKNOWN when the audio is too coarse or not tonal enough to tell.
+ */
+struct HarmonicKey {
+    static constexpr int UNKNOWN = -1;
+    static constexpr int COUNT = 24;
+    static constexpr double MIN_CONFIDENCE = 0.5;   // Below this, the key is reported unknown
+
+    int camelot;        // Camelot index 0-23, or UNKNOWN
+    double confidence;  // Correlation of the chroma with the winning key profile (0 if unknown)
+
+    HarmonicKey() : camelot(UNKNOWN), confidence(0.0) {}
+
+    bool known() const { return camelot != UNKNOWN; }
+
+    /**
+     * @brief Camelot index of the key with the given tonic (pitch class, C = 0)
+     */
+    static int fromTonic(int pitch_class, bool minor) {
+        // C major is 8B and every fifth up is one step clockwise; a minor key
+        // shares its number with its relative major, three semitones up
+        const int major_tonic = ((pitch_class + (minor ? 3 : 0)) % 12 + 12) % 12;
+        const int number = (major_tonic * 7 + 7) % 12;   // 0-based wheel position
+        return 2 * number + (minor ? 0 : 1);
+    }
+
+    /**
+     * @brief Camelot notation of an index ("8A"), or "?" for UNKNOWN
+     */
+    static std::string name(int camelot) {
+        if (camelot < 0 || camelot >= COUNT) {
+            return "?";
+        }
+        return std::to_string(camelot / 2 + 1) + (camelot % 2 ? "B" : "A");
+    }
+};
+
+#endif // HARMONICKEY_H
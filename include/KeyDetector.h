@@ -0,0 +1,58 @@
+#ifndef KEYDETECTOR_H
+#define KEYDETECTOR_H
+
+#include "AudioTrack.h"
+#include "HarmonicKey.h"
+#include "WavFile.h"
+#include <cstddef>
+#include <memory>
+
+/**
+ * @brief Musical key detection and Camelot compatibility
+ *
+ * Chroma: FRAMES frames spread evenly over the track are box-filtered down to
+ * about ANALYSIS_RATE, Hann windowed and measured at every semitone from C3
+ * to B5 with Goertzel filters (two semitones per SSE2 register). Each frame's
+ * magnitudes are folded into 12 pitch classes and normalized, so loud
+ * passages do not outvote quiet ones. Only FRAMES * FRAME_SIZE decimated
+ * samples are read, whatever the track's length.
+ *
+ * Key: Pearson correlation of the averaged chroma with the 24 rotations of
+ * the Krumhansl-Kessler major and minor profiles. The best rotation wins if
+ * the chroma is peaked enough to be tonal (noise folds to a flat chroma) and
+ * the correlation reaches HarmonicKey::MIN_CONFIDENCE.
+ *
+ * Compatibility: two keys mix when they are the same key, neighbours on the
+ * Camelot wheel (a fifth apart, same letter) or relative major and minor
+ * (same number). compatible() reads a 24x24 table built once.
+ */
+class KeyDetector {
+public:
+    static constexpr size_t FRAMES = 64;
+    static constexpr size_t FRAME_SIZE = 1024;       // Samples per frame after decimation
+    static constexpr double ANALYSIS_RATE = 4000.0;  // Lowest rate the frames are decimated to (Hz)
+
+    /**
+     * @brief Key of a track's waveform (sample rate = waveform_size / duration)
+     * @return A new result (never null); unknown if the waveform is too coarse
+     */
+    static std::shared_ptr<const HarmonicKey> detect(const AudioTrack& track);
+
+    /**
+     * @brief Key of raw mono samples at sample_rate
+     */
+    static std::shared_ptr<const HarmonicKey> detect(const double* samples, size_t count, double sample_rate);
+
+    /**
+     * @brief Key of PCM read in place (e.g. a mapped WAV file)
+     */
+    static std::shared_ptr<const HarmonicKey> detect(const WavFile::PcmView& pcm);
+
+    /**
+     * @brief Whether two Camelot indices mix harmonically (O(1) table lookup)
+     * An UNKNOWN key is compatible with every key: there is nothing to clash with.
+     */
+    static bool compatible(int camelot_a, int camelot_b);
+};
+
+#endif // KEYDETECTOR_H
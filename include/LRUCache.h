@@ -1,9 +1,11 @@
 #pragma once
 
 #include "CacheSlot.h"
+#include "CachePolicy.h"
 #include "AudioTrack.h"
 #include "PointerWrapper.h"
 #include <vector>
+#include <unordered_map>
 #include <cstddef>
 #include <cstdint>
 #include <string>
@@ -19,12 +21,37 @@
  * - Used by DJControllerService with fixed capacity in this assignment.
  * - get() marks entries MRU by updating their access time.
  * - put() inserts as MRU and evicts true LRU when full.
+ *
+ * Lookup, touch and eviction are O(1): a hash index maps track titles to
+ * slot indices, and occupied slots are chained MRU -> LRU through the
+ * intrusive prev/next links in CacheSlot. Free slots form a second chain.
+ * Tracks carrying an interned TrackId are also indexed by ID, so callers
+ * that know the ID avoid hashing and comparing titles.
+ *
+ * Capacity is a slot count, optionally combined with a byte budget
+ * (set_byte_budget): each entry then weighs its track's memory footprint,
+ * and victims are evicted until the incoming track fits. A track larger
+ * than the whole budget is never admitted, so it cannot flush the cache.
+ *
+ * Victim selection can be delegated to a CachePolicy strategy (LFU, 2Q,
+ * ARC, W-TinyLFU, ...). Without one, the recency list above is used, i.e.
+ * plain LRU. Policies are fed each track's ID as its CacheKey (a hash of
+ * the title for tracks that were never interned).
  */
 class LRUCache {
 private:
     std::vector<CacheSlot> slots;
+    std::unordered_map<std::string, size_t> index;  // track title -> slot
+    std::unordered_map<TrackId, size_t> id_index;   // interned track ID -> slot
     size_t max_size;
     uint64_t access_counter;
+    size_t mru_slot;    // Head of recency list (CacheSlot::npos if empty)
+    size_t lru_slot;    // Tail of recency list (CacheSlot::npos if empty)
+    size_t free_slot;   // Head of free list (CacheSlot::npos if full)
+    size_t used;        // Number of occupied slots
+    size_t max_bytes;   // Byte budget (0 = slot count only)
+    size_t used_bytes;  // Sum of footprints of occupied slots
+    PointerWrapper<CachePolicy> policy;  // Eviction strategy (empty = built-in LRU)
 
 public:
     /**
@@ -39,6 +66,7 @@ public:
      * @return true if track is in cache
      */
     bool contains(const std::string& track_id) const;
+    bool contains(TrackId id) const;
     
     /**
      * @brief Get a track from cache (updates LRU order)
@@ -49,6 +77,15 @@ public:
      * "most recently used" position in LRU algorithm.
      */
     AudioTrack* get(const std::string& track_id);
+    AudioTrack* get(TrackId id);
+
+    /**
+     * @brief Like get(), but returns a shared handle that stays valid after eviction
+     * @param track_id Track identifier
+     * @return Handle to the track, or an empty handle if not found
+     */
+    TrackHandle acquire(const std::string& track_id);
+    TrackHandle acquire(TrackId id);
     
     /**
      * @brief Put a track into cache (handles eviction if full)
@@ -56,12 +93,24 @@ public:
      * @return true if an eviction occurred, false otherwise.
      * 
      * If cache is full, automatically evicts the least recently
-     * used track before storing the new one.
+     * used track before storing the new one. With a byte budget, evicts
+     * until the track's footprint fits; a track larger than the whole
+     * budget is rejected (dropped) without evicting anything.
      */
     bool put(PointerWrapper<AudioTrack> track);
+
+    /**
+     * @brief Put a track only if no entry listed in keep has to be evicted
+     * @param track Track to cache (transfers ownership)
+     * @param keep IDs of tracks that must stay cached (e.g. now playing / up next)
+     * @return true if the track was stored; false if it was already cached,
+     * not admitted, or storing it would have evicted a kept track (then nothing
+     * is evicted and the policy does not see the miss)
+     */
+    bool putUnless(PointerWrapper<AudioTrack> track, const std::vector<TrackId>& keep);
     
     /**
-     * @brief Manually evict the least recently used track
+     * @brief Manually evict the policy's victim (the least recently used track by default)
      * @return true if a track was evicted
      */
     bool evictLRU();
@@ -96,6 +145,40 @@ public:
      * This method should be used only once.
      */
     void set_capacity(size_t capacity);
+
+    /**
+     * @brief Limit the total memory footprint of cached tracks
+     * @param bytes Budget in bytes, or 0 to limit by slot count only.
+     * Evicts entries if the current contents exceed the new budget.
+     */
+    void set_byte_budget(size_t bytes);
+
+    size_t byte_budget() const { return max_bytes; }
+    size_t bytes_used() const { return used_bytes; }
+
+    /**
+     * @brief Check whether a track could ever fit under the byte budget
+     */
+    bool admits(const AudioTrack& track) const;
+
+    /**
+     * @brief Replace the eviction strategy
+     * @param new_policy Policy to use (transfers ownership); an empty wrapper
+     * restores the built-in LRU order. Current entries are handed to the new
+     * policy from LRU to MRU.
+     */
+    void set_policy(PointerWrapper<CachePolicy> new_policy);
+
+    /**
+     * @brief Name of the active eviction policy
+     */
+    std::string policy_name() const;
+
+    /**
+     * @brief Handles to all cached tracks, least recently used first
+     * (does not update recency)
+     */
+    std::vector<TrackHandle> entries() const;
 private:
     /**
      * @brief Find slot containing specific track
@@ -103,6 +186,19 @@ private:
      * @return Slot index, or max_size if not found
      */
     size_t findSlot(const std::string& track_id) const;
+    size_t findSlot(TrackId id) const;
+    size_t findSlot(const AudioTrack& track) const;   // By ID when the track has one
+
+    /**
+     * @brief Key the policy sees for a track: its ID, or a hash of its title without one
+     */
+    static CacheKey policyKey(const AudioTrack& track);
+
+    /**
+     * @brief Mark an occupied slot most recently used
+     * @return The slot's track
+     */
+    AudioTrack* touchSlot(size_t idx);
     
     /**
      * @brief Find the least recently used slot
@@ -115,4 +211,47 @@ private:
      * @return Slot index, or max_size if cache is full
      */
     size_t findEmptySlot() const;
+
+    /**
+     * @brief Choose the slot to evict for an incoming track
+     * @param incoming Policy key of the track about to be inserted (NO_CACHE_KEY if none)
+     * @return Slot index, or max_size if the cache is empty
+     */
+    size_t findVictimSlot(CacheKey incoming);
+
+    /**
+     * @brief Whether making room for an entry of weight bytes would evict a track in keep
+     * Replays the whole eviction chain without changing the cache or its policy.
+     */
+    bool evictsKept(CacheKey incoming, size_t weight, const std::vector<TrackId>& keep) const;
+
+    /**
+     * @brief Evict the slot findVictimSlot() chose, letting the policy commit to it first
+     */
+    bool evictVictim(size_t idx);
+
+    /**
+     * @brief Evict an occupied slot and return it to the free list
+     */
+    bool evictSlot(size_t idx);
+
+    /**
+     * @brief Store a track in the first empty slot (there must be one)
+     */
+    void store(PointerWrapper<AudioTrack> track);
+
+    /**
+     * @brief Unlink an occupied slot from the recency list
+     */
+    void unlink(size_t idx);
+
+    /**
+     * @brief Link a slot at the MRU end of the recency list
+     */
+    void pushFront(size_t idx);
+
+    /**
+     * @brief Rebuild the free list so that it chains every slot
+     */
+    void resetSlots();
 };
\ No newline at end of file
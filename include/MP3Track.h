@@ -2,6 +2,10 @@
 #define MP3TRACK_H
 
 #include "AudioTrack.h"
+#include "Mp3File.h"
+#include "SharedFile.h"
+#include <memory>
+#include <string>
 
 /**
  * MP3Track - Represents an MP3 audio file with lossy compression
@@ -10,6 +14,10 @@
  * 
  * Phase 4 contracts:
  * - load(): simulate deck preparation (format-specific message); does not start playback.
+ *   A track backed by an .mp3 file maps it (Mp3File) on first load and indexes its
+ *   frames, reusing the seek table persisted with the analysis data (see
+ *   AnalysisCache::seekTablePath) when it is current. Frames are decoded only as analysis or playback touches them. The file
+ *   is mapped and indexed once for the library track and all its clones (see SharedFile).
  * - analyze_beatgrid(): run immediately after load() in this assignment for compatibility checks.
  * - get_quality_score(): derived from bitrate (e.g., normalized by 320kbps).
  * - clone(): return a deep polymorphic copy used by the mixer; source remains unchanged.
@@ -18,13 +26,16 @@ class MP3Track : public AudioTrack {
 private:
     int bitrate;        // Compression level: 128, 192, 320 kbps (higher = better quality)
     bool has_id3_tags;  // Whether file contains ID3 metadata (artist, album, etc.)
+    std::string file_path;                  // Backing .mp3 file ("" = none)
+    std::shared_ptr<SharedFile<Mp3File>> mapping;   // Shared by every copy (null without a file)
+    std::shared_ptr<const Mp3File> audio;   // Mapped and indexed by load() (null until then)
 
 public:
     /**
      * Constructor for MP3Track
      */
     MP3Track(const std::string& title, const std::vector<std::string>& artists, 
-             int duration, int bpm, int bitrate, bool has_tags = true);
+             int duration, int bpm, int bitrate, bool has_tags = true, const std::string& file_path = "");
 
     // ========== TODO: IMPLEMENT VIRTUAL FUNCTIONS ==========
 
@@ -32,13 +43,15 @@ public:
      * TODO: Implement load function for MP3 files
      * HINT: Print loading message specific to MP3 format
      */
-    void load() override;
+    void load(std::ostream& out) override;
+    using AudioTrack::load;
 
     /**
      * TODO: Implement beat grid analysis for MP3
      * HINT: MP3 analysis might be less precise than WAV
      */
-    void analyze_beatgrid() override;
+    void analyze_beatgrid(std::ostream& out) override;
+    using AudioTrack::analyze_beatgrid;
 
     /**
      * TODO: Implement quality score calculation
@@ -46,15 +59,28 @@ public:
      */
     double get_quality_score() const override;
 
+    /**
+     * Memory footprint: compressed frame data (bitrate * duration) plus waveform buffer
+     */
+    size_t get_memory_footprint() const override;
+
     /**
      * TODO: Implement clone function
      * HINT: Return a unique_ptr to a new MP3Track with same properties
      */
     PointerWrapper<AudioTrack> clone() const override;
 
+    /**
+     * Stream of the waveform for a track without a file. A file-backed track returns an
+     * empty stream: Layer III synthesis is not built in (see Mp3File::decode_range).
+     */
+    PointerWrapper<TrackStream> open_stream() const override;
+
     // Getters
     int get_bitrate() const { return bitrate; }
     bool has_tags() const { return has_id3_tags; }
+    const std::string& get_file_path() const { return file_path; }
+    const Mp3File* get_audio() const { return audio.get(); }
 };
 
 #endif // MP3TRACK_H
\ No newline at end of file
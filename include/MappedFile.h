@@ -0,0 +1,58 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Read-only memory mapping of a whole file
+ *
+ * Opens the file, checks its size, maps it privately and closes the
+ * descriptor again (the mapping stays valid without it). The mapping is
+ * released by reset() or the destructor. Shared by the file formats read
+ * in place: WavFile, Mp3File and CacheSnapshot.
+ */
+class MappedFile {
+public:
+    MappedFile() : base(nullptr), length(0), mtime_ns(0), failure() {}
+
+    /**
+     * @brief Map the file at path
+     * @param min_size Smallest size worth mapping; a shorter file is not mapped
+     * On failure is_open() is false and error() says why.
+     */
+    MappedFile(const std::string& path, size_t min_size);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool is_open() const { return base != nullptr; }
+    const void* data() const { return base; }
+    size_t size() const { return length; }
+    const std::string& error() const { return failure; }
+
+    /**
+     * @brief Modification time of the file when it was mapped, in nanoseconds
+     */
+    int64_t modified_ns() const { return mtime_ns; }
+
+    /**
+     * @brief Hint the kernel to read ahead for a front-to-back scan (or stop doing so)
+     */
+    void advise_sequential(bool sequential) const;
+
+    /**
+     * @brief Unmap the file (no-op if nothing is mapped)
+     */
+    void reset();
+
+private:
+    void* base;
+    size_t length;
+    int64_t mtime_ns;
+    std::string failure;
+};
+
+#endif // MAPPEDFILE_H
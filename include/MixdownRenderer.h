@@ -0,0 +1,120 @@
+#ifndef MIXDOWNRENDERER_H
+#define MIXDOWNRENDERER_H
+
+#include "AudioTrack.h"
+#include "CrossfadeRenderer.h"
+#include "PointerWrapper.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Offline render of a whole set (a played playlist) to one WAV file
+ *
+ * Tracks are added in play order with the tempo their deck played them at.
+ * Each track plays in full (time-stretched by its tempo and resampled to the
+ * output rate), and consecutive tracks overlap by a crossfade window of
+ * crossfade_seconds, capped at half of either track. The timeline is thus
+ *   body 0 | fade 0-1 | body 1 | fade 1-2 | ... | body n-1
+ * where a body is the part of a track outside any fade.
+ *
+ * A pool of worker threads decodes tracks (keeping only their head and tail
+ * windows in double precision, the body goes straight to 16-bit PCM) and
+ * mixes each fade window once both of its tracks are decoded. The calling
+ * thread stitches the finished segments in timeline order through a
+ * WavWriter. At most threads + 1 tracks are in flight, which bounds memory.
+ */
+class MixdownRenderer {
+public:
+    /**
+     * @param threads Worker threads (0 = one per hardware thread)
+     */
+    MixdownRenderer(unsigned sample_rate, double crossfade_seconds, CrossfadeRenderer::Curve curve,
+                    size_t threads = 0);
+    ~MixdownRenderer();
+
+    MixdownRenderer(const MixdownRenderer&) = delete;
+    MixdownRenderer& operator=(const MixdownRenderer&) = delete;
+
+    /**
+     * @brief Append the next track of the set, played at tempo (1 = as recorded)
+     * The track must be loaded, so that open_stream() reads its audio.
+     */
+    void add_track(PointerWrapper<AudioTrack> track, double tempo);
+
+    size_t track_count() const { return entries.size(); }
+    unsigned sample_rate() const { return rate; }
+    size_t thread_count() const { return threads; }
+
+    /**
+     * @brief Render the set and write it to path
+     * @return false if there is nothing to render or the file could not be written
+     */
+    bool render(const std::string& path);
+
+    // Results of the last render()
+    uint64_t frames() const { return total_frames; }
+    double render_ms() const { return wall_ms; }
+    double write_ms() const { return io_ms; }
+    size_t write_blocks() const { return blocks; }
+
+private:
+    struct Entry {
+        PointerWrapper<AudioTrack> track;
+        double tempo;
+        uint64_t length;              // Output frames
+        uint64_t head;                // Frames inside the fade from the previous track
+        uint64_t tail;                // Frames inside the fade to the next track
+        std::vector<double> head_samples;
+        std::vector<double> tail_samples;
+        bool decoded;
+
+        Entry() : track(), tempo(1.0), length(0), head(0), tail(0), head_samples(), tail_samples(),
+                  decoded(false) {}
+    };
+
+    struct Segment {
+        std::vector<int16_t> pcm;
+        bool ready;
+
+        Segment() : pcm(), ready(false) {}
+    };
+
+    enum TaskKind { DECODE, FADE };
+    struct Task {
+        TaskKind kind;
+        size_t index;   // Track (DECODE) or fade from track index to index + 1 (FADE)
+    };
+
+    PointerWrapper<TrackStream> open(size_t index) const;
+    void plan();
+    void worker();
+    void decode(size_t index);
+    void fade(size_t index);
+    void push(Task task);
+
+    unsigned rate;
+    double fade_seconds;
+    CrossfadeRenderer::Curve fade_curve;
+    size_t threads;
+    std::vector<Entry> entries;
+    std::vector<Segment> segments;   // Body i at 2i, fade i -> i + 1 at 2i + 1
+
+    std::mutex mutex;
+    std::condition_variable work;       // Workers wait for tasks
+    std::condition_variable finished;   // The writer waits for its next segment
+    std::deque<Task> tasks;
+    bool stopping;
+
+    uint64_t total_frames;
+    double wall_ms;
+    double io_ms;
+    size_t blocks;
+};
+
+#endif // MIXDOWNRENDERER_H
@@ -0,0 +1,107 @@
+#ifndef MIXERTHREAD_H
+#define MIXERTHREAD_H
+
+#include "DeckMixer.h"
+#include "PointerWrapper.h"
+#include "SpscQueue.h"
+#include "StreamingDecoder.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Real-time render thread over a DeckMixer
+ *
+ * Every callback_frames / sample_rate seconds the thread applies the commands
+ * queued since the previous callback, renders one block of the mix (an
+ * underrun is padded with silence) and hands it to the sink, which stands in
+ * for the audio device. The callback never allocates, locks or frees:
+ * - commands arrive on a lock-free SPSC queue, any decoder in them already
+ *   built, started and buffered by the sender;
+ * - a decoder taken off a deck, and with it the deck's last reference to its
+ *   track's audio, goes back on a second SPSC queue and is freed by the
+ *   control thread in collect().
+ * If the return queue is full the thread keeps the decoder and takes no more
+ * commands until there is room again, so nothing is dropped.
+ *
+ * One control thread sends commands, collects and stops; the mixer must not be
+ * touched by anyone else until stop() returns.
+ */
+class MixerThread {
+public:
+    typedef DeckMixer::Command Command;
+    typedef std::function<void(const double* block, size_t frames)> Sink;
+
+    static constexpr size_t DEFAULT_QUEUE = 64;   // Commands in flight (and decoders awaiting collect())
+
+    /**
+     * @param paced false renders callbacks back to back instead of in real time (stress tests)
+     */
+    MixerThread(DeckMixer& mixer, double sample_rate, size_t callback_frames, const Sink& sink = Sink(),
+                bool paced = true, size_t queue_capacity = DEFAULT_QUEUE);
+    ~MixerThread();
+
+    MixerThread(const MixerThread&) = delete;
+    MixerThread& operator=(const MixerThread&) = delete;
+
+    /**
+     * @brief Queue a command for the next callback
+     * @return false if the queue is full (command is left untouched)
+     */
+    bool post(Command&& command);
+
+    /**
+     * @brief Queue a command, collecting and yielding until there is room
+     */
+    void send(Command&& command);
+
+    /**
+     * @brief Free the decoders the thread has retired
+     * @return How many were freed
+     */
+    size_t collect();
+
+    /**
+     * @brief Join the thread, apply the commands it did not get to and free every retired decoder
+     */
+    void stop();
+
+    bool running() const { return thread.joinable(); }
+    double sample_rate() const { return rate; }
+    size_t callback_frames() const { return block.size(); }
+
+    uint64_t callbacks() const { return callback_count.load(std::memory_order_relaxed); }
+    uint64_t underruns() const { return underrun_count.load(std::memory_order_relaxed); }     // Padded with silence
+    uint64_t late_callbacks() const { return late_count.load(std::memory_order_relaxed); }   // Missed their deadline
+    uint64_t commands_applied() const { return applied_count.load(std::memory_order_relaxed); }
+    uint64_t decoders_retired() const { return retired_count.load(std::memory_order_relaxed); }
+    double longest_callback_us() const { return longest_ns.load(std::memory_order_relaxed) / 1000.0; }
+
+private:
+    void run();
+    void drain();   // Audio thread: apply queued commands, retire what they replace
+
+    DeckMixer& mixer;
+    double rate;
+    Sink sink;
+    bool paced;
+    SpscQueue<Command> commands;                           // Control -> audio
+    SpscQueue<PointerWrapper<StreamingDecoder>> retired;   // Audio -> control
+    // Audio thread only: output block, command being applied, decoder awaiting room to retire
+    std::vector<double> block;
+    Command pending;
+    PointerWrapper<StreamingDecoder> held;
+    std::atomic<bool> stopping;
+    std::atomic<uint64_t> callback_count;
+    std::atomic<uint64_t> underrun_count;
+    std::atomic<uint64_t> late_count;
+    std::atomic<uint64_t> applied_count;
+    std::atomic<uint64_t> retired_count;
+    std::atomic<uint64_t> longest_ns;
+    std::thread thread;
+};
+
+#endif // MIXERTHREAD_H
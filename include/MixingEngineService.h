@@ -2,19 +2,77 @@
 #define MIXINGENGINESERVICE_H
 
 #include "AudioTrack.h"
+#include "CacheSlot.h"
+#include "CrossfadeRenderer.h"
+#include "DeckMixer.h"
+#include "DeckPolicy.h"
+#include "MixerThread.h"
+#include "StreamingDecoder.h"
+#include "TimeStretcher.h"
 #include <string>
+#include <vector>
 
 // Service responsible for deck operations and track analysis
 // Phase 4 binding:
-// - Enforces instant transitions and deck alternation policy.
+// - Enforces instant transitions and the deck selection policy over deck_count decks
+//   (two by default, alternated round-robin; see DeckPolicy).
 // - After loading to a deck: call track.load(); then analyze_beatgrid(); then switch active deck.
 // - The previously active deck becomes finished and is unloaded immediately.
+// - In streaming mode each loaded deck also gets a StreamingDecoder over the track's
+//   open_stream(); the deck is switched as soon as its first chunk is buffered, and
+//   read_deck() consumes the decoded PCM.
+// - A track retuned by sync_bpm is played time-stretched by new BPM / original BPM
+//   (TimeStretcher, pitch unchanged) when its deck streams.
+// - render() mixes the decks into an output buffer: loading a track over a playing deck
+//   starts a crossfade of default_crossfade_time seconds (see CrossfadeRenderer). Every
+//   deck still audible when a load starts fades out from its current gain, so overlapping
+//   transitions on several decks are summed in one pass.
+// - A deck either owns its track (a clone, or a track handed over by move) or plays a
+//   cached track in place through a shared read-only TrackHandle. The handle pins the
+//   entry: evicting it from the cache only drops the cache's reference, so it stays
+//   valid while the deck is live. Only a prepared track that auto_sync will not retune
+//   can be borrowed (see can_borrow); the borrowed path copies and allocates nothing.
+// - Playback state lives in a DeckMixer changed only by commands (load, crossfader,
+//   sync, unload). The engine prepares everything a command needs (clone, analysis,
+//   decoder) on the caller's thread, then applies it, or after start_mixer_thread()
+//   queues it to a MixerThread that renders in real time.
 class MixingEngineService {
 private:
-    AudioTrack* decks[2];
+    struct Deck {
+        PointerWrapper<AudioTrack> track;          // Owned track (cloned or moved in)
+        TrackHandle pinned;                        // Or a cached track borrowed read-only
+        const StreamingDecoder* stream;            // Its decoder in streaming mode (owned by the mixer)
+        double tempo;                              // Playback speed set by sync_bpm (1 = as recorded)
+
+        Deck() : track(), pinned(), stream(nullptr), tempo(1.0) {}
+        Deck(const Deck&) = delete;
+        Deck& operator=(const Deck&) = delete;
+        Deck(Deck&&) = default;
+        Deck& operator=(Deck&&) = default;
+
+        const AudioTrack* get() const { return track ? track.get() : pinned.get(); }
+    };
+
+    std::vector<Deck> decks;           // Contiguous deck state, indexed by deck number
+    PointerWrapper<DeckPolicy> policy;
     size_t active_deck;
     bool auto_sync;
     int bpm_tolerance;
+    bool streaming;
+    int crossfade_seconds;
+    CrossfadeRenderer::Curve crossfade_curve;
+    DeckMixer mixer;
+    PointerWrapper<MixerThread> mixer_thread;   // Renders the mixer while running
+
+    size_t begin_load();
+    int finish_load(size_t target);
+    bool retunes(const AudioTrack& track, size_t target) const;
+    bool can_mix(const AudioTrack& track) const;
+    bool tempo_matches(const AudioTrack& track) const;
+    PointerWrapper<StreamingDecoder> open_decoder(size_t deck) const;
+    void submit(DeckMixer::Command&& command);
+    void copy_decks(const MixingEngineService& other);
+    bool any_deck_loaded() const;
 public:
     MixingEngineService();
     ~MixingEngineService();
@@ -22,18 +80,62 @@ public:
     MixingEngineService& operator=(const MixingEngineService& other);
     /** Contract: Load a track to the next deck per instant-transition policy
      * - @param track: reference to a cached track to be cloned for the mixer
-     * - @return: index of the deck the track was loaded to (0 or 1), or -1 on failure.
+     * - @return: index of the deck the track was loaded to (below get_deck_count()), or -1 on failure.
      * - @brief: This function clones the track, unloads the target deck if needed, loads the new track, analyzes the beatgrid, switches the active deck, and unloads the previous deck.
      * - @attention: on clone failure, log an error and return
      */
     int loadTrackToDeck(const AudioTrack& track);
 
+    /**
+     * @brief Load a track the caller hands over (no clone). Same steps as above:
+     * load(), analyze_beatgrid(), sync and deck switch.
+     * @return Deck index, or -1 if the wrapper is empty
+     */
+    int loadTrackToDeck(PointerWrapper<AudioTrack>&& track);
+
+    /**
+     * @brief Play a cached track in place through its shared read-only handle (no copy,
+     * no allocation). The cache prepared the track, so load() and analyze_beatgrid()
+     * are skipped. If can_borrow() is false the track is cloned as in the first overload.
+     * @return Deck index, or -1 if the handle is empty
+     */
+    int loadTrackToDeck(TrackHandle track);
+
+    /**
+     * @brief Whether the next load may borrow this track instead of owning a copy:
+     * it has been loaded and analyzed (it has a beat grid), and auto_sync will not
+     * change its BPM against the active deck
+     */
+    bool can_borrow(const AudioTrack& track) const;
+
     // Display deck status
     void displayDeckStatus() const;
 
+    /**
+     * @brief Set the number of decks (at least 1). Unloads all decks and stops the mixer thread.
+     */
+    void set_deck_count(size_t count);
+    size_t get_deck_count() const { return decks.size(); }
+
+    /**
+     * @brief Select the deck selection policy by name (round_robin, lru or explicit)
+     * @return false if the name is unknown (the current policy is kept)
+     */
+    bool set_deck_policy(const std::string& name);
+    std::string get_deck_policy() const { return policy->name(); }
+
+    /**
+     * @brief Choose the deck for the following loads (explicit policy only)
+     * @return false if the deck does not exist or the policy picks decks itself
+     */
+    bool cue_deck(size_t deck) { return policy->cue(deck); }
+
     /**
      * Contract: Determine if decks A and the given track can be mixed
      * @return true if mixable by BPM/key criteria; false otherwise
+     * BPM: difference within bpm_tolerance. Key: the Camelot keys detected by
+     * analyze_beatgrid() are compatible (KeyDetector::compatible, a table lookup);
+     * a track whose key is unknown is judged on BPM alone.
      */
     bool can_mix_tracks(const PointerWrapper<AudioTrack>& track) const;
 
@@ -41,6 +143,7 @@ public:
      * Contract: Synchronize BPM between active deck and given track.
      * - @param track: Pointer to the track to sync with the currently active deck
      * - @brief This function calculates average BPM between active deck and given track, then sets the given track's BPM to the average
+     *   (loadTrackToDeck then time-stretches a streaming deck's audio to match the new BPM)
      * - @attention What should be the preconditions of this function? What this method modifies?
      */
     void sync_bpm(const PointerWrapper<AudioTrack>& track) const;
@@ -61,6 +164,81 @@ public:
         bpm_tolerance = tolerance;
     }
 
+    /**
+     * @brief Stream decks through a bounded chunk buffer instead of whole-track loads
+     * Applies to tracks loaded afterwards.
+     */
+    void set_streaming(bool enabled) {
+        streaming = enabled;
+    }
+
+    /**
+     * @brief Consume up to frames of decoded PCM from a streaming deck (non-blocking)
+     * @return Frames copied; 0 if the deck is empty, not streaming or underrunning,
+     *         or while the mixer thread runs
+     */
+    size_t read_deck(size_t deck, double* out, size_t frames);
+
+    /**
+     * @brief A streaming deck's decoder (nullptr if none). While the mixer thread runs
+     * only its atomic counters (decoded_frames, played_frames) may be read.
+     */
+    const StreamingDecoder* get_stream(size_t deck) const {
+        return deck < decks.size() ? decks[deck].stream : nullptr;
+    }
+
+    /**
+     * @brief Crossfade length and curve for transitions started by later loads
+     */
+    void set_crossfade(int seconds, CrossfadeRenderer::Curve curve);
+
+    /**
+     * @brief Render up to frames of the mix (active deck, summed with the decks fading
+     * out during a transition) into out. Requires streaming decks; never blocks.
+     * @return Frames rendered; fewer than requested when the active deck's decoder is
+     *         behind or its track has ended (the caller pads an audio callback with silence);
+     *         0 while the mixer thread runs, as it renders instead
+     */
+    size_t render(double* out, size_t frames);
+
+    bool in_transition() const { return !mixer_thread && mixer.in_transition(); }
+
+    /**
+     * @brief Retime a streaming deck to tempo (x the recorded speed, pitch unchanged)
+     * from where it is playing. A new decoder is cued at the deck's position on this
+     * thread and swapped in by a sync command, which skips what the deck played meanwhile.
+     * @return false if the deck does not stream
+     */
+    bool set_deck_tempo(size_t deck, double tempo);
+
+    /**
+     * @brief Empty a deck. Its decoder is freed here, or by the mixer thread's next
+     * collect() once the thread has let go of it.
+     * @return false if the deck does not exist or is already empty
+     */
+    bool unload_deck(size_t deck);
+
+    /**
+     * @brief Render on a dedicated real-time thread (see MixerThread) into sink, one
+     * block of callback_frames frames every callback_frames / sample_rate seconds.
+     * Loads, syncs, unloads and crossfader changes become commands queued to the
+     * thread; render() and read_deck() return 0 until stop_mixer_thread().
+     * @return false if decks do not stream or the thread already runs
+     */
+    bool start_mixer_thread(double sample_rate, size_t callback_frames,
+                            const MixerThread::Sink& sink = MixerThread::Sink(), bool paced = true);
+    void stop_mixer_thread();
+    const MixerThread* get_mixer_thread() const { return mixer_thread ? mixer_thread.get() : nullptr; }
+
+    /**
+     * @brief Track on a deck (nullptr if empty) and the tempo it plays at (see sync_bpm)
+     */
+    const AudioTrack* get_deck_track(size_t deck) const {
+        return deck < decks.size() ? decks[deck].get() : nullptr;
+    }
+    double get_deck_tempo(size_t deck) const { return deck < decks.size() ? decks[deck].tempo : 1.0; }
+    size_t get_active_deck() const { return active_deck; }
+
 };
 
 #endif // MIXINGENGINESERVICE_H
@@ -0,0 +1,138 @@
+#ifndef MP3FILE_H
+#define MP3FILE_H
+
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Read-only memory-mapped MPEG audio Layer III file with a frame seek table
+ *
+ * Opening maps the file, skips ID3v2/ID3v1 tags and indexes every frame: one
+ * 32-bit byte offset per frame. Every frame holds the same number of samples,
+ * even in VBR files, so the frame at any time is found by index arithmetic and
+ * seeking is O(1). A Xing/Info header (the first, silent frame of most VBR
+ * files) is recognized and kept out of the index; its 100-entry TOC is exposed
+ * for coarse seeks.
+ *
+ * Building the index reads each frame's 4-byte header once. When index_path is
+ * given, the table is loaded from there if it still matches the file (size and
+ * modification time) and written there after a scan otherwise.
+ *
+ * Nothing is decoded up front. Callers pull only the frames they touch: the
+ * side information of a frame (quantizer gains, coded bit counts) is parsed
+ * on demand, and decode_range() returns the frames a PCM decoder would need
+ * for a time span, including the earlier frames that hold the bit reservoir.
+ */
+class Mp3File {
+public:
+    /**
+     * @brief Frames [first, end) to decode for a span; [begin, end) produce its samples
+     * Frames first..begin-1 only supply bit-reservoir bytes (main_data_begin).
+     */
+    struct FrameRange {
+        uint32_t first;
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    /**
+     * @brief Map and index the file at path
+     * A missing, truncated or non-Layer III file yields is_open() == false and error().
+     */
+    explicit Mp3File(const std::string& path, const std::string& index_path = "");
+
+    Mp3File(const Mp3File&) = delete;
+    Mp3File& operator=(const Mp3File&) = delete;
+
+    bool is_open() const { return mapped.is_open(); }
+    const std::string& error() const { return failure; }
+    const std::string& path() const { return file_path; }
+
+    unsigned sample_rate() const { return rate; }
+    unsigned channels() const { return channel_count; }
+    unsigned samples_per_frame() const { return frame_samples; }
+    uint32_t frame_count() const { return static_cast<uint32_t>(offsets.size()); }
+    double frame_duration() const { return rate ? static_cast<double>(frame_samples) / rate : 0.0; }
+    double duration() const { return frame_count() * frame_duration(); }
+    bool has_id3() const { return id3; }
+    bool has_toc() const { return toc_present; }
+    bool index_loaded() const { return loaded; }    // true: read from index_path, false: scanned
+    bool index_saved() const { return saved; }
+
+    /**
+     * @brief Bytes of audio frames (tags and the Xing frame excluded)
+     */
+    uint64_t data_bytes() const { return audio_bytes; }
+
+    /**
+     * @brief Average bitrate over all frames in kbps
+     */
+    int average_kbps() const;
+
+    /**
+     * @brief Bytes held by the seek table
+     */
+    size_t index_bytes() const { return offsets.size() * sizeof(uint32_t); }
+
+    /**
+     * @brief Frame containing time seconds (clamped to the last frame), O(1)
+     */
+    uint32_t frame_at(double seconds) const;
+
+    /**
+     * @brief Encoded bytes of frame index (header included)
+     */
+    const unsigned char* frame_data(uint32_t index) const;
+    size_t frame_size(uint32_t index) const;
+
+    /**
+     * @brief Frames needed to decode [start_seconds, end_seconds)
+     */
+    FrameRange decode_range(double start_seconds, double end_seconds) const;
+
+    /**
+     * @brief Coarse byte offset of time seconds from the Xing TOC (or the average bitrate)
+     */
+    uint64_t toc_offset(double seconds) const;
+
+    /**
+     * @brief Granules (half frames in MPEG-1, whole frames in MPEG-2/2.5) per frame
+     */
+    unsigned granules_per_frame() const { return frame_samples / 576; }
+
+    /**
+     * @brief Compressed-domain energy of each granule in frames [first, first + count)
+     * Estimated from the side information only: the squared global quantizer step
+     * (2^((global_gain - 210) / 2)) times the granule's coded bit count, summed over
+     * channels. Writes count * granules_per_frame() values to out.
+     */
+    void granule_energy(uint32_t first, uint32_t count, double* out) const;
+
+private:
+    bool parse();
+    bool load_index(const std::string& index_path, uint64_t file_size, int64_t modified);
+    bool save_index(const std::string& index_path, uint64_t file_size, int64_t modified) const;
+    size_t side_info_offset(const unsigned char* frame) const;
+    void unmap();
+
+    std::string file_path;
+    MappedFile mapped;
+    std::vector<uint32_t> offsets;   // Byte offset of each audio frame in the file
+    size_t audio_end;                // One past the last frame's last byte
+    uint64_t audio_bytes;
+    unsigned rate;
+    unsigned channel_count;
+    unsigned frame_samples;
+    bool mpeg1;
+    bool id3;
+    bool toc_present;
+    unsigned char toc[100];
+    bool loaded;
+    bool saved;
+    std::string failure;
+};
+
+#endif // MP3FILE_H
@@ -0,0 +1,76 @@
+#ifndef PCMRINGBUFFER_H
+#define PCMRINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Bounded single-producer/single-consumer ring of fixed-size PCM chunks
+ *
+ * All chunk storage is allocated up front, so memory is chunk_frames * chunks
+ * samples however long the stream is. The producer fills the slot returned by
+ * write_slot() and publishes it; the consumer reads any number of frames,
+ * across chunk boundaries. Neither side locks or allocates: slots are handed
+ * over through two atomic counters, so the consumer is safe to call from an
+ * audio callback.
+ */
+class PcmRingBuffer {
+public:
+    PcmRingBuffer(size_t chunk_frames, size_t chunks);
+
+    PcmRingBuffer(const PcmRingBuffer&) = delete;
+    PcmRingBuffer& operator=(const PcmRingBuffer&) = delete;
+
+    size_t chunk_frames() const { return chunk_size; }
+    size_t capacity() const { return slots.size(); }
+    size_t bytes() const { return samples.size() * sizeof(double); }
+
+    // ---- Producer ----
+
+    /**
+     * @brief Storage for the next chunk (chunk_frames() samples), or nullptr if the ring is full
+     */
+    double* write_slot();
+
+    /**
+     * @brief Hand the chunk from write_slot() to the consumer (frames <= chunk_frames())
+     */
+    void publish(size_t frames);
+
+    // ---- Consumer ----
+
+    /**
+     * @brief Copy up to frames buffered samples into out
+     * @return Frames copied (less than requested when the producer is behind)
+     */
+    size_t read(double* out, size_t frames);
+
+    /**
+     * @brief Drop up to frames buffered samples without copying them
+     * @return Frames dropped
+     */
+    size_t discard(size_t frames);
+
+    /**
+     * @brief Frames published and not yet read
+     */
+    size_t buffered() const;
+
+    /**
+     * @brief Drop everything buffered (consumer side; e.g. on seek)
+     */
+    void clear();
+
+private:
+    size_t consume(double* out, size_t frames);   // out may be null (discard)
+
+    size_t chunk_size;
+    std::vector<double> samples;    // capacity() chunks, back to back
+    std::vector<size_t> slots;      // Frames in each published chunk
+    std::atomic<size_t> written;    // Chunks published (producer)
+    std::atomic<size_t> consumed;   // Chunks fully read (consumer)
+    size_t read_offset;             // Frames already read from the oldest chunk (consumer only)
+};
+
+#endif // PCMRINGBUFFER_H
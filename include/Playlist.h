@@ -28,6 +28,12 @@ private:
     PlaylistNode* head;
     std::string playlist_name;
     int track_count;
+    std::vector<AudioTrack*> by_id;  // TrackId -> first track in list order with that ID (or nullptr)
+
+    /**
+     * Rebuild by_id from the list (after copying, or removing the indexed track)
+     */
+    void rebuild_id_index();
 
 public:
     /**
@@ -91,6 +97,19 @@ public:
      */
     AudioTrack* find_track(const std::string& title) const;
 
+    /**
+     * @param id Interned library ID of the track to find
+     * @brief Find a track by ID in O(1): IDs are dense, so they index a vector
+     * @return Pointer to the found track, or nullptr if not found
+     */
+    AudioTrack* find_track(TrackId id) const;
+
+    /**
+     * Size the ID index for every ID below id_count up front (e.g. the library
+     * size), so adding tracks never regrows it
+     */
+    void reserve_ids(size_t id_count);
+
     /**
      * Check if playlist is empty
      */
@@ -21,6 +21,7 @@ struct SessionConfig {
         int bpm;
         int extra_param1;        // bitrate for MP3, sample_rate for WAV
         int extra_param2;        // has_tags for MP3, bit_depth for WAV
+        std::string file_path;   // Optional audio file backing the track ("" = none)
         
         TrackInfo() 
             : type(""), 
@@ -29,18 +30,33 @@ struct SessionConfig {
               duration_seconds(0), 
               bpm(0), 
               extra_param1(0), 
-              extra_param2(0) {}
+              extra_param2(0), 
+              file_path("") {}
     };
     
     std::vector<TrackInfo> library_tracks;
     
     // Cache settings
     int controller_cache_size;
+    std::string controller_cache_policy;  // LRU, LFU, 2Q, ARC or W-TinyLFU
+    int controller_cache_shards;          // > 1 selects the sharded concurrent cache
+    size_t controller_cache_bytes;        // Byte budget by track footprint (0 = slots only)
+    int prefetch_lookahead;               // Upcoming tracks warmed in the background (0 = off)
+    std::string controller_cache_snapshot;  // Warm-start snapshot file ("" = off)
+    std::string waveform_format;          // float64, float32, int16 or int8
     
     // Mixing settings
     int default_crossfade_time;
     int bpm_tolerance;
     bool auto_sync;
+    bool deck_streaming;                  // Decks play from a chunked decoder stream
+    std::string crossfade_curve;          // linear, equal_power or s_curve
+    int deck_count;                       // Decks in the mixer
+    std::string deck_policy;              // round_robin, lru or explicit
+    int mixdown_sample_rate;              // Output rate of dj_manager -R and of the mixer thread
+    int mixdown_threads;                  // Render threads of dj_manager -R (0 = one per core)
+    bool realtime_mixer;                  // Streaming decks are rendered on a real-time thread
+    int mixer_callback_frames;            // Frames per mixer thread callback
     
     // Playlists - name mapped to list of track indices
     std::map<std::string, std::vector<int>> playlists;
@@ -49,9 +65,23 @@ struct SessionConfig {
           version(""), 
           library_tracks(), 
           controller_cache_size(8), 
+          controller_cache_policy("LRU"), 
+          controller_cache_shards(1), 
+          controller_cache_bytes(0), 
+          prefetch_lookahead(0), 
+          controller_cache_snapshot(""), 
+          waveform_format("float64"), 
           default_crossfade_time(5), 
           bpm_tolerance(10), 
           auto_sync(true), 
+          deck_streaming(false), 
+          crossfade_curve("equal_power"), 
+          deck_count(2), 
+          deck_policy("round_robin"), 
+          mixdown_sample_rate(44100), 
+          mixdown_threads(0), 
+          realtime_mixer(false), 
+          mixer_callback_frames(256), 
           playlists() {}
 };
 
@@ -80,8 +110,9 @@ struct PlaylistData {
  * 
  * This helper class handles parsing of the file formats.
  * Phase 4 note: Playlists are discovered under ./playlists (interactive selection).
- * The app uses bpm_tolerance and auto_sync settings; default_crossfade_time is ignored
- * for logging/behavior in the instant-transition model.
+ * The app uses bpm_tolerance and auto_sync settings. default_crossfade_time and
+ * crossfade_curve shape the transitions rendered by streaming decks; without
+ * deck_streaming the model stays instant-transition.
  */
 class SessionFileParser {
 public:
@@ -95,11 +126,26 @@ public:
      * # Comments start with #
      * app_name=DJ Track Library Manager
      * version=2.0
-     * library_track_1=MP3,title,{artist1;artist2;},duration,bpm,bitrate,has_tags
-     * library_track_2=WAV,title,{artist1;artist2;},duration,bpm,sample_rate,bit_depth
+     * library_track_1=MP3,title,{artist1;artist2;},duration,bpm,bitrate,has_tags[,file.mp3]
+     * library_track_2=WAV,title,{artist1;artist2;},duration,bpm,sample_rate,bit_depth[,file.wav]
      * controller_cache_size=8
+     * controller_cache_policy=LRU
+     * controller_cache_shards=1
+     * controller_cache_bytes=0
+     * prefetch_lookahead=0
+     * controller_cache_snapshot=bin/controller_cache.snap
+     * waveform_format=float64
      * bpm_tolerance=10
      * auto_sync=true
+     * deck_streaming=false
+     * default_crossfade_time=5
+     * crossfade_curve=equal_power
+     * deck_count=2
+     * deck_policy=round_robin
+     * mixdown_sample_rate=44100
+     * mixdown_threads=0
+     * realtime_mixer=false
+     * mixer_callback_frames=256
      * playlistname=1,2,3
      */
     static bool parse_config_file(const std::string& config_path, SessionConfig& config);
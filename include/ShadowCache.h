@@ -0,0 +1,68 @@
+#ifndef SHADOWCACHE_H
+#define SHADOWCACHE_H
+
+#include "AudioTrack.h"
+#include "CachePolicy.h"
+#include "PointerWrapper.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief ID-only cache used to measure an eviction policy without holding tracks
+ *
+ * Replays the same access stream the controller cache sees through any
+ * CachePolicy at a given capacity and counts hits and misses. Nothing is
+ * cloned, loaded or analyzed, so several shadows can run side by side to
+ * compare policies on a live session. Tracks are identified by their dense
+ * TrackId, so the index is a plain vector and no title is hashed or copied.
+ *
+ * With a byte budget the shadow limits itself as LRUCache does: each key
+ * weighs the footprint passed to access(), victims are evicted until the
+ * newcomer fits, and a key heavier than the whole budget is never stored.
+ * Like DJControllerService, the last such key is held aside and hits when it
+ * is requested again.
+ */
+class ShadowCache {
+public:
+    /**
+     * @param policy Eviction strategy (transfers ownership)
+     * @param capacity Number of keys the shadow may hold
+     * @param byte_budget Total weight the shadow may hold (0 = slot count only)
+     */
+    ShadowCache(PointerWrapper<CachePolicy> policy, size_t capacity, size_t byte_budget = 0);
+
+    /**
+     * @brief Access a track, inserting it on a miss
+     * @param id Interned ID of the track (must be valid)
+     * @param weight Bytes the track weighs under a byte budget (ignored without one)
+     * @return true on HIT, false on MISS
+     */
+    bool access(TrackId id, size_t weight = 0);
+
+    std::string policyName() const { return policy->name(); }
+    size_t capacity() const { return keys.size(); }
+    size_t byteBudget() const { return max_bytes; }
+    size_t hits() const { return hit_count; }
+    size_t misses() const { return miss_count; }
+
+    /**
+     * @brief Fraction of accesses that were hits (0 if nothing was accessed)
+     */
+    double hitRatio() const;
+
+private:
+    PointerWrapper<CachePolicy> policy;
+    std::vector<size_t> index;      // id -> slot (CacheSlot::npos if absent), grown on demand
+    std::vector<TrackId> keys;      // slot -> id
+    std::vector<size_t> weights;    // slot -> weight
+    std::vector<size_t> free_slots;
+    size_t resident;                // Number of occupied slots
+    TrackId oversized;              // Last track over the byte budget
+    size_t max_bytes;
+    size_t used_bytes;
+    size_t hit_count;
+    size_t miss_count;
+};
+
+#endif // SHADOWCACHE_H
@@ -0,0 +1,39 @@
+#ifndef SHAREDFILE_H
+#define SHAREDFILE_H
+
+#include <memory>
+#include <mutex>
+
+/**
+ * @brief Backing audio file of a track, opened at most once for the track and all its copies
+ *
+ * A file-backed track creates one of these when it is constructed and copies
+ * share it, so the library track, its playlist clones and every replay use a
+ * single mapping (and AnalysisCache, which keys on the mapping, analyzes it
+ * once). The first open() opens the file, on whichever copy loads first;
+ * later calls from any copy, on any thread, return the same object. A file
+ * that failed to open is kept too, for its error(), and not retried.
+ */
+template <typename File>
+class SharedFile {
+public:
+    SharedFile() : opened(), file() {}
+
+    SharedFile(const SharedFile&) = delete;
+    SharedFile& operator=(const SharedFile&) = delete;
+
+    /**
+     * @brief The file, opened by make() on the first call
+     */
+    template <typename Make>
+    std::shared_ptr<const File> open(Make make) {
+        std::call_once(opened, [this, &make] { file = make(); });
+        return file;
+    }
+
+private:
+    std::once_flag opened;
+    std::shared_ptr<const File> file;
+};
+
+#endif // SHAREDFILE_H
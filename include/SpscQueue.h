@@ -0,0 +1,72 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Bounded single-producer/single-consumer queue of movable items
+ *
+ * All slots are allocated up front. Items are moved in by push() and moved
+ * out by pop(), handed over through two atomic counters as in PcmRingBuffer,
+ * so neither side locks or allocates and either may be a real-time thread.
+ * A slot that has been popped holds a moved-from item, so the producer's next
+ * push into it destroys nothing but an empty shell.
+ */
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity) : slots(capacity ? capacity : 1), pushed(0), popped(0) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    size_t capacity() const { return slots.size(); }
+
+    /**
+     * @brief Producer: move item into the queue
+     * @return false if the queue is full (item is left untouched)
+     */
+    bool push(T&& item) {
+        const size_t head = pushed.load(std::memory_order_relaxed);
+        if (head - popped.load(std::memory_order_acquire) >= slots.size()) {
+            return false;
+        }
+        slots[head % slots.size()] = std::move(item);
+        pushed.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Consumer: move the oldest item out into item
+     * @return false if the queue is empty
+     */
+    bool pop(T& item) {
+        const size_t tail = popped.load(std::memory_order_relaxed);
+        if (tail == pushed.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = std::move(slots[tail % slots.size()]);
+        popped.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Items queued (exact on either side for its own operations, a snapshot otherwise)
+     */
+    size_t size() const {
+        const size_t tail = popped.load(std::memory_order_acquire);
+        return pushed.load(std::memory_order_acquire) - tail;
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    std::vector<T> slots;
+    std::atomic<size_t> pushed;   // Items pushed (producer)
+    std::atomic<size_t> popped;   // Items popped (consumer)
+};
+
+#endif // SPSCQUEUE_H
@@ -0,0 +1,90 @@
+#ifndef STREAMINGDECODER_H
+#define STREAMINGDECODER_H
+
+#include "PcmRingBuffer.h"
+#include "PointerWrapper.h"
+#include "TrackStream.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+/**
+ * @brief Decoder stage of a streaming deck
+ *
+ * Owns a TrackStream and a producer thread that decodes it chunk by chunk
+ * into a bounded PcmRingBuffer. The producer runs ahead of the consumer by at
+ * most the ring's capacity and then sleeps until a chunk is drained, so a
+ * deck's memory is fixed (chunk_frames * chunks samples) for any track length,
+ * and playback can start as soon as the first chunk is published.
+ *
+ * read() is the consumer side (one thread, never blocks); wait_ready() is for
+ * the loader. The destructor stops and joins the producer.
+ */
+class StreamingDecoder {
+public:
+    static constexpr size_t DEFAULT_CHUNK_FRAMES = 4096;
+    static constexpr size_t DEFAULT_CHUNKS = 8;
+
+    explicit StreamingDecoder(PointerWrapper<TrackStream> stream, size_t chunk_frames = DEFAULT_CHUNK_FRAMES,
+                              size_t chunks = DEFAULT_CHUNKS);
+    ~StreamingDecoder();
+
+    StreamingDecoder(const StreamingDecoder&) = delete;
+    StreamingDecoder& operator=(const StreamingDecoder&) = delete;
+
+    /**
+     * @brief Block until the first chunk is buffered (or the stream turned out empty)
+     * @return false on timeout
+     */
+    bool wait_ready(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Consume up to frames decoded samples (non-blocking)
+     * @return Frames copied; fewer than requested on underrun or at the end
+     */
+    size_t read(double* out, size_t frames);
+
+    /**
+     * @brief Drop up to frames decoded samples, as if played (consumer side, non-blocking)
+     * @return Frames dropped
+     */
+    size_t skip(size_t frames);
+
+    /**
+     * @brief The whole track has been decoded and consumed
+     */
+    bool finished() const;
+
+    size_t buffered() const { return ring.buffered(); }
+    size_t buffer_bytes() const { return ring.bytes(); }
+    size_t chunk_frames() const { return ring.chunk_frames(); }
+    size_t chunks() const { return ring.capacity(); }
+    double sample_rate() const { return rate; }
+    uint64_t length() const { return total_frames; }
+    uint64_t decoded_frames() const { return decoded.load(); }
+    uint64_t played_frames() const { return played.load(std::memory_order_relaxed); }   // Read or skipped
+
+private:
+    void run();
+    void release_space();   // Consumer: wake the producer if it waits for the room just freed
+
+    PointerWrapper<TrackStream> stream;   // Used by the producer thread only
+    PcmRingBuffer ring;
+    double rate;
+    uint64_t total_frames;
+    std::atomic<uint64_t> decoded;
+    std::atomic<uint64_t> played;     // Written by the consumer, readable from any thread
+    std::atomic<bool> end_of_stream;
+    std::atomic<bool> stopping;
+    std::atomic<bool> producer_waiting;   // Ring was full when the producer last looked
+    std::mutex mutex;
+    std::condition_variable space;   // Producer waits for a free slot
+    std::condition_variable ready;   // Loader waits for the first chunk
+    std::thread producer;
+};
+
+#endif // STREAMINGDECODER_H
@@ -0,0 +1,110 @@
+#ifndef TIMESTRETCHER_H
+#define TIMESTRETCHER_H
+
+#include "PointerWrapper.h"
+#include "TrackStream.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Tempo change without pitch change (WSOLA: waveform-similarity overlap-add)
+ *
+ * Output is built from Hann-windowed frames of FRAME samples (about 23 ms at
+ * 44.1 kHz) overlapped by half. Frame k is taken near input position
+ * k * hop * ratio, shifted by up to a quarter frame to the offset whose
+ * samples best match the natural continuation of frame k - 1 (cross-correlation
+ * on a 4x decimated signal, then refined at full rate). The output therefore
+ * plays ratio times faster (ratio = target BPM / track BPM) at the original
+ * pitch, and is 1 / ratio times as long.
+ *
+ * Streaming: write() appends input, read() takes whatever output is ready, and
+ * finish() flushes the tail. needed() tells how much more input the next hop
+ * requires. Correlation and overlap-add use SSE2 when available.
+ */
+class TimeStretcher {
+public:
+    static constexpr double MIN_RATIO = 0.5;
+    static constexpr double MAX_RATIO = 2.0;
+
+    /**
+     * @param ratio Playback speed factor, clamped to [MIN_RATIO, MAX_RATIO]
+     */
+    TimeStretcher(double sample_rate, double ratio);
+
+    double ratio() const { return speed; }
+    size_t frame_size() const { return frame; }
+
+    /**
+     * @brief Input frames still missing before the next hop can be produced
+     */
+    size_t needed() const;
+
+    void write(const double* in, size_t frames);
+
+    /**
+     * @brief No more input: the remaining output is produced, padded with silence
+     */
+    void finish();
+
+    /**
+     * @brief Take up to frames of output
+     * @return Frames copied; fewer than requested when more input is needed or at the end
+     */
+    size_t read(double* out, size_t frames);
+
+    /**
+     * @brief finish() was called and all output has been read
+     */
+    bool done() const;
+
+private:
+    int64_t nominal(uint64_t k) const;
+    int64_t input_end() const { return base + static_cast<int64_t>(input.size()); }
+    int64_t best_start(int64_t target, int64_t natural);
+    bool step();
+
+    double speed;
+    size_t frame;                    // Window length (power of two)
+    size_t hop;                      // Output hop: frame / 2
+    size_t tolerance;                // Largest shift from the nominal position: frame / 4
+    std::vector<double> window;      // Periodic Hann: overlapping halves sum to 1
+    std::vector<double> input;       // Input samples [base, base + size), after hop leading zeros
+    int64_t base;
+    uint64_t frames_done;            // Frames overlap-added so far
+    int64_t previous;                // Input start of the last frame
+    std::vector<double> overlap;     // Overlap-add accumulator (one frame)
+    std::vector<double> output;      // Finished output not yet read
+    size_t output_read;
+    size_t skip;                     // Leading output samples still to drop (the zero padding)
+    bool flushing;
+    uint64_t output_total;           // Output length once the input length is known
+    uint64_t output_emitted;
+    std::vector<double> coarse_natural;  // Decimated search scratch
+    std::vector<double> coarse_region;
+};
+
+/**
+ * @brief TrackStream that plays another stream time-stretched by a TimeStretcher
+ * Same sample rate as the source; length is the source length / ratio.
+ */
+class TimeStretchStream : public TrackStream {
+public:
+    TimeStretchStream(PointerWrapper<TrackStream> source, double ratio);
+
+    size_t read(double* out, size_t frames) override;
+    double sample_rate() const override { return source->sample_rate(); }
+    uint64_t length() const override { return total; }
+    uint64_t position() const override { return next; }
+
+    double ratio() const { return stretcher.ratio(); }
+
+private:
+    PointerWrapper<TrackStream> source;
+    TimeStretcher stretcher;
+    std::vector<double> chunk;   // Source read buffer
+    uint64_t total;
+    uint64_t next;
+};
+
+#endif // TIMESTRETCHER_H
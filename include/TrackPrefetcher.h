@@ -0,0 +1,95 @@
+#ifndef TRACKPREFETCHER_H
+#define TRACKPREFETCHER_H
+
+#include "AudioTrack.h"
+#include "DJControllerService.h"
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Background worker that warms upcoming playlist tracks into the controller cache
+ *
+ * The playlist order is known in advance, so while the session works on the
+ * current track the prefetcher clones, loads and analyzes the next K tracks
+ * on its own thread through DJControllerService::prefetchTrackToCache.
+ *
+ * Capacity contract: a prefetch never evicts the track currently playing or
+ * any track due before the one being warmed; if it would have to, it is
+ * skipped. The lookahead is clamped so that the current track and its K
+ * successors fit in the cache at once.
+ *
+ * The source tracks handed to schedule() must stay alive until cancel()
+ * returns (the session cancels before switching playlists).
+ *
+ * The worker never writes std::cout: what a prefetch prints goes to the log
+ * sink handed to prefetchTrackToCache, and the session prints it with
+ * flush_log() between its own messages.
+ */
+class TrackPrefetcher {
+public:
+    explicit TrackPrefetcher(DJControllerService& controller);
+    ~TrackPrefetcher();
+
+    TrackPrefetcher(const TrackPrefetcher&) = delete;
+    TrackPrefetcher& operator=(const TrackPrefetcher&) = delete;
+
+    /**
+     * @brief Set how many upcoming tracks to warm (0 disables prefetching)
+     * @param tracks Requested lookahead K
+     * @param cache_capacity Slot capacity of the controller cache, used to clamp K
+     */
+    void set_lookahead(size_t tracks, size_t cache_capacity);
+    size_t get_lookahead() const { return lookahead; }
+    bool enabled() const { return lookahead > 0; }
+
+    /**
+     * @brief Queue the tracks following position `current` that are not queued yet
+     * Pending work for tracks at or before `current` is dropped.
+     * @param tracks Playlist tracks in play order (nullptr entries are skipped)
+     * @param current Index of the track now playing
+     */
+    void schedule(const std::vector<AudioTrack*>& tracks, size_t current);
+
+    /**
+     * @brief Drop pending work and wait until the worker is idle
+     */
+    void cancel();
+
+    /**
+     * @brief Print the worker's buffered output on the calling (session) thread
+     */
+    void flush_log();
+
+    size_t get_warmed() const;
+    size_t get_skipped() const;
+
+private:
+    struct Job {
+        AudioTrack* source;
+        size_t position;                // Index of the track in the playlist
+        std::vector<TrackId> keep;      // IDs of tracks that must survive this prefetch
+    };
+
+    void run();
+
+    DJControllerService& controller;
+    size_t lookahead;
+    std::deque<Job> jobs;   // Ordered by position
+    size_t queued_upto;     // Highest position ever queued since the last cancel()
+    bool busy;
+    bool stopping;
+    size_t warmed;
+    size_t skipped;
+    std::string log;        // Worker output not yet flushed
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::thread worker;
+};
+
+#endif // TRACKPREFETCHER_H
@@ -0,0 +1,44 @@
+#ifndef TRACKREGISTRY_H
+#define TRACKREGISTRY_H
+
+#include "AudioTrack.h"
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Library-wide interning table between track titles and dense TrackIds
+ *
+ * IDs are assigned in first-seen order starting at 0, so they can index
+ * plain vectors. Titles are stored once here; everything behind the UI
+ * boundary (playlist, cache, session) compares IDs instead of strings.
+ */
+class TrackRegistry {
+public:
+    TrackRegistry() : titles(), ids() {}
+
+    /**
+     * @brief Get the ID of a title, assigning the next free ID on first sight
+     */
+    TrackId intern(const std::string& title);
+
+    /**
+     * @return The ID of title, or INVALID_TRACK_ID if it was never interned
+     */
+    TrackId find(const std::string& title) const;
+
+    /**
+     * @brief Title of an interned ID (id must be valid)
+     */
+    const std::string& title(TrackId id) const { return titles[id]; }
+
+    size_t size() const { return titles.size(); }
+    void clear();
+
+private:
+    std::vector<std::string> titles;                 // id -> title
+    std::unordered_map<std::string, TrackId> ids;    // title -> id
+};
+
+#endif // TRACKREGISTRY_H
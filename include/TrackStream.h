@@ -0,0 +1,60 @@
+#ifndef TRACKSTREAM_H
+#define TRACKSTREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+struct TrackPayload;
+
+/**
+ * @brief Sequential mono PCM reader over one track's audio
+ *
+ * Opened per deck by AudioTrack::open_stream(); each stream keeps its own
+ * position and owns (shares) the audio it reads, so it stays valid after the
+ * track that opened it is gone. A stream is used by one thread at a time
+ * (the StreamingDecoder producer), and produces samples in [-1, 1].
+ */
+class TrackStream {
+public:
+    virtual ~TrackStream() {}
+
+    /**
+     * @brief Decode the next frames into out
+     * @return Frames written, less than frames only at the end of the track (0 once done)
+     */
+    virtual size_t read(double* out, size_t frames) = 0;
+
+    virtual double sample_rate() const = 0;
+
+    /**
+     * @brief Total frames of the track
+     */
+    virtual uint64_t length() const = 0;
+
+    /**
+     * @brief Frames read so far
+     */
+    virtual uint64_t position() const = 0;
+};
+
+/**
+ * @brief Stream over a track's waveform buffer (tracks without an audio file)
+ * The waveform spans the whole track, so it plays at waveform_size / duration frames per second.
+ */
+class WaveformStream : public TrackStream {
+public:
+    WaveformStream(const std::shared_ptr<const TrackPayload>& payload, double duration_seconds);
+
+    size_t read(double* out, size_t frames) override;
+    double sample_rate() const override { return rate; }
+    uint64_t length() const override;
+    uint64_t position() const override { return next; }
+
+private:
+    std::shared_ptr<const TrackPayload> payload;
+    double rate;
+    uint64_t next;
+};
+
+#endif // TRACKSTREAM_H
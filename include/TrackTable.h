@@ -0,0 +1,87 @@
+#ifndef TRACKTABLE_H
+#define TRACKTABLE_H
+
+#include "AudioTrack.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Columnar (struct-of-arrays) copy of the library's scalar metadata
+ *
+ * Built once from the library; row i describes library track i. Each field
+ * lives in its own contiguous array, so a query streams only the columns it
+ * needs instead of chasing AudioTrack pointers and making virtual calls.
+ * A million-row scan of one int32 column touches 4 MB.
+ *
+ * Filters, aggregates and top-k run 4 or 16 rows per step with SSE2 (scalar
+ * on other targets) and return row indices in ascending order unless stated.
+ */
+class TrackTable {
+public:
+    enum Format : uint8_t { FORMAT_OTHER = 0, FORMAT_MP3 = 1, FORMAT_WAV = 2 };
+
+    struct Summary {
+        size_t count;
+        uint64_t total_duration;   // seconds
+        int min_bpm;
+        int max_bpm;
+        double mean_quality;
+        Summary() : count(0), total_duration(0), min_bpm(0), max_bpm(0), mean_quality(0.0) {}
+    };
+
+    TrackTable() : ids(), bpms(), durations(), qualities(), formats(), rates() {}
+
+    /**
+     * @brief Rebuild the columns from the library (one virtual call per track, once)
+     */
+    void build(const std::vector<AudioTrack*>& library);
+
+    size_t size() const { return ids.size(); }
+    void clear();
+
+    // ========== ROW ACCESS ==========
+    TrackId id(size_t row) const { return ids[row]; }
+    int bpm(size_t row) const { return bpms[row]; }
+    int duration(size_t row) const { return durations[row]; }
+    float quality(size_t row) const { return qualities[row]; }
+    Format format(size_t row) const { return static_cast<Format>(formats[row]); }
+    int rate(size_t row) const { return rates[row]; }  // Bitrate (MP3) or sample rate (WAV)
+
+    // ========== QUERIES ==========
+
+    /**
+     * @brief Rows whose BPM lies in [min_bpm, max_bpm]
+     */
+    std::vector<uint32_t> filterBpm(int min_bpm, int max_bpm) const;
+
+    /**
+     * @brief Rows within +-tolerance BPM of target (e.g. mix candidates)
+     */
+    std::vector<uint32_t> nearBpm(int target, int tolerance) const {
+        return filterBpm(target - tolerance, target + tolerance);
+    }
+
+    size_t countFormat(Format format) const;
+
+    /**
+     * @brief Count, total duration, BPM range and mean quality of all rows
+     */
+    Summary summarize() const;
+
+    /**
+     * @brief The k rows with the highest quality score, best first
+     * (ties keep the lower row first)
+     */
+    std::vector<uint32_t> topQuality(size_t k) const;
+
+private:
+    std::vector<TrackId> ids;
+    std::vector<int32_t> bpms;
+    std::vector<int32_t> durations;
+    std::vector<float> qualities;      // Scores are 0-100; float halves the scan bandwidth
+    std::vector<uint8_t> formats;
+    std::vector<int32_t> rates;
+};
+
+#endif // TRACKTABLE_H
@@ -2,6 +2,10 @@
 #define WAVTRACK_H
 
 #include "AudioTrack.h"
+#include "SharedFile.h"
+#include "WavFile.h"
+#include <memory>
+#include <string>
 
 /**
  * WAVTrack - Represents a WAV audio file with high-quality uncompressed audio
@@ -9,7 +13,10 @@
  * Students must implement all virtual functions from AudioTrack
  * 
  * Phase 4 contracts:
- * - load(): simulate deck preparation for WAV (often faster due to no decompression).
+ * - load(): simulate deck preparation for WAV (often faster due to no decompression);
+ *   a track backed by a .wav file maps it (WavFile) on first load and exposes the PCM
+ *   in place through get_pcm(). The file is mapped once for the library track and all
+ *   its clones (see SharedFile), by whichever copy loads first.
  * - analyze_beatgrid(): run immediately after load() in this assignment; can be more precise.
  * - get_quality_score(): derived from sample_rate and bit_depth (higher => better).
  * - clone(): return a deep polymorphic copy used by the mixer; source remains unchanged.
@@ -19,13 +26,16 @@ class WAVTrack : public AudioTrack {
 private:
     int sample_rate;    // Samples per second: 44100 (CD), 48000 (pro), 96000+ (hi-res)
     int bit_depth;      // Bits per sample: 16 (CD), 24 (pro), 32 (float)
+    std::string file_path;                  // Backing .wav file ("" = none)
+    std::shared_ptr<SharedFile<WavFile>> mapping;   // Shared by every copy (null without a file)
+    std::shared_ptr<const WavFile> audio;   // Mapped by load() (null until then)
 
 public:
     /**
      * Constructor for WAVTrack
      */
     WAVTrack(const std::string& title, const std::vector<std::string>& artists, 
-             int duration, int bpm, int sample_rate, int bit_depth);
+             int duration, int bpm, int sample_rate, int bit_depth, const std::string& file_path = "");
 
     // ========== TODO: IMPLEMENT VIRTUAL FUNCTIONS ==========
 
@@ -33,13 +43,15 @@ public:
      * TODO: Implement load function for WAV files
      * HINT: WAV files are uncompressed, so loading might be faster
      */
-    void load() override;
+    void load(std::ostream& out) override;
+    using AudioTrack::load;
 
     /**
      * TODO: Implement beat grid analysis for WAV
      * HINT: Uncompressed audio allows more precise beat detection
      */
-    void analyze_beatgrid() override;
+    void analyze_beatgrid(std::ostream& out) override;
+    using AudioTrack::analyze_beatgrid;
 
     /**
      * TODO: Implement quality score calculation
@@ -47,15 +59,32 @@ public:
      */
     double get_quality_score() const override;
 
+    /**
+     * Memory footprint: uncompressed stereo PCM (sample_rate * bit_depth * duration) plus waveform buffer
+     */
+    size_t get_memory_footprint() const override;
+
     /**
      * TODO: Implement clone function
      * HINT: Return a unique_ptr to a new WAVTrack with same properties
      */
     PointerWrapper<AudioTrack> clone() const override;
 
+    /**
+     * Stream of the mapped PCM once loaded, else of the waveform
+     */
+    PointerWrapper<TrackStream> open_stream() const override;
+
     // Getters
     int get_sample_rate() const { return sample_rate; }
     int get_bit_depth() const { return bit_depth; }
+    const std::string& get_file_path() const { return file_path; }
+    const WavFile* get_audio() const { return audio.get(); }
+
+    /**
+     * Read-only view of the mapped PCM (empty before load() or without a file)
+     */
+    WavFile::PcmView get_pcm() const { return audio ? audio->pcm() : WavFile::PcmView(); }
 };
 
 #endif // WAVTRACK_H
\ No newline at end of file
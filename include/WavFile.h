@@ -0,0 +1,94 @@
+#ifndef WAVFILE_H
+#define WAVFILE_H
+
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Read-only memory-mapped RIFF/WAVE (and RF64) file
+ *
+ * The whole file is mapped once; parsing only walks the chunk headers, and
+ * the PCM region is exposed in place through a PcmView, so nothing is copied
+ * and files larger than RAM are paged in on demand (the mapping is advised
+ * as sequential). RF64's ds64 chunk provides 64-bit sizes for files beyond
+ * 4 GB, and a data size of 0xFFFFFFFF (streamed recordings) runs to the end
+ * of the file.
+ *
+ * Supported encodings: integer PCM at 16, 24 and 32 bits and 32-bit IEEE
+ * float, plain or WAVE_FORMAT_EXTENSIBLE, any channel count.
+ */
+class WavFile {
+public:
+    enum Encoding { PCM_INT = 1, PCM_FLOAT = 3 };
+
+    /**
+     * @brief Typed read-only view of interleaved samples inside the mapping
+     */
+    struct PcmView {
+        const unsigned char* data;   // First byte of the first frame (nullptr if empty)
+        uint64_t frames;
+        unsigned channels;
+        unsigned bits;               // Container bits per sample: 16, 24 or 32
+        unsigned sample_rate;
+        Encoding encoding;
+
+        PcmView() : data(nullptr), frames(0), channels(0), bits(0), sample_rate(0), encoding(PCM_INT) {}
+        PcmView(const PcmView&) = default;
+        PcmView& operator=(const PcmView&) = default;
+
+        bool empty() const { return frames == 0; }
+        size_t frame_bytes() const { return static_cast<size_t>(channels) * (bits / 8); }
+        double duration() const { return sample_rate ? static_cast<double>(frames) / sample_rate : 0.0; }
+
+        /**
+         * @brief Direct typed access when the layout and alignment allow it
+         * @return nullptr for other encodings/depths or a misaligned data chunk
+         */
+        const int16_t* int16() const;
+        const int32_t* int32() const;
+        const float* float32() const;
+
+        /**
+         * @brief One sample scaled to [-1, 1)
+         */
+        double sample(uint64_t frame, unsigned channel) const;
+
+        /**
+         * @brief Average of all channels for count frames starting at first, scaled to [-1, 1)
+         * 16-bit and 32-bit mono/stereo convert with SSE2.
+         */
+        void read_mono(uint64_t first, size_t count, double* out) const;
+    };
+
+    /**
+     * @brief Map and parse the file at path
+     * A missing, truncated or unsupported file yields is_open() == false and error().
+     */
+    explicit WavFile(const std::string& path);
+
+    WavFile(const WavFile&) = delete;
+    WavFile& operator=(const WavFile&) = delete;
+
+    bool is_open() const { return mapped.is_open(); }
+    const std::string& error() const { return failure; }
+    const std::string& path() const { return file_path; }
+    const PcmView& pcm() const { return view; }
+
+    /**
+     * @brief Bytes of PCM data (the part of the mapping that holds audio)
+     */
+    uint64_t data_bytes() const { return view.frames * view.frame_bytes(); }
+
+private:
+    bool parse();
+    void unmap();
+
+    std::string file_path;
+    MappedFile mapped;
+    PcmView view;
+    std::string failure;
+};
+
+#endif // WAVFILE_H
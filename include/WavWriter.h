@@ -0,0 +1,65 @@
+#ifndef WAVWRITER_H
+#define WAVWRITER_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Buffered writer of a 16-bit mono PCM WAV file
+ *
+ * Samples collect in one large block (4 MB by default) that is handed to the
+ * stream in a single write when full, so a render spends its time producing
+ * audio rather than in small I/O calls. The file is written under a temporary
+ * name and moved into place by close(), once the header sizes are patched; a
+ * writer destroyed without close() removes its partial file.
+ */
+class WavWriter {
+public:
+    static constexpr size_t DEFAULT_BLOCK_BYTES = 4 << 20;
+
+    WavWriter(const std::string& path, unsigned sample_rate, size_t block_bytes = DEFAULT_BLOCK_BYTES);
+    ~WavWriter();
+
+    WavWriter(const WavWriter&) = delete;
+    WavWriter& operator=(const WavWriter&) = delete;
+
+    bool is_open() const { return open; }
+
+    /**
+     * @brief Convert samples in [-1, 1] to 16-bit PCM, saturating outside it (SSE2 when available)
+     */
+    static void encode(const double* in, int16_t* out, size_t count);
+
+    void write(const double* samples, size_t count);
+    void write(const int16_t* samples, size_t count);
+
+    /**
+     * @brief Flush, patch the header and move the file into place
+     * @return false on an I/O error or a file beyond the 4 GB RIFF limit
+     */
+    bool close();
+
+    uint64_t frames() const { return written; }
+    size_t blocks() const { return flushes; }
+    double write_ms() const { return std::chrono::duration<double, std::milli>(io_time).count(); }
+
+private:
+    void flush();
+
+    std::string path;
+    std::string temp_path;
+    std::ofstream out;
+    unsigned rate;
+    std::vector<int16_t> block;
+    size_t filled;
+    uint64_t written;
+    size_t flushes;
+    std::chrono::steady_clock::duration io_time;   // Spent inside stream writes
+    bool open;
+};
+
+#endif // WAVWRITER_H
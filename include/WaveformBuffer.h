@@ -0,0 +1,106 @@
+#ifndef WAVEFORMBUFFER_H
+#define WAVEFORMBUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Waveform samples stored in a selectable sample format
+ *
+ * Analysis works on doubles, but storing 8 bytes per sample is wasteful when
+ * 16 bits of precision are enough. Samples are kept as float64, float32,
+ * int16 or int8; the integer formats map [-scale, scale] linearly onto the
+ * full integer range. store() quantizes and load() dequantizes whole ranges
+ * with SSE2 kernels (scalar code on other targets).
+ *
+ * Sample arrays come from a counting allocator, so allocations() tells how
+ * many waveforms the process has materialized, copies included.
+ */
+class WaveformBuffer {
+public:
+    enum Format { FLOAT64 = 0, FLOAT32 = 1, INT16 = 2, INT8 = 3 };
+
+    WaveformBuffer();
+
+    /**
+     * @brief Allocate count zero samples in format
+     * @param scale Largest magnitude the integer formats must represent
+     */
+    void reset(Format format, size_t count, double scale);
+
+    /**
+     * @brief Quantize n samples into positions [offset, offset + n)
+     * Values beyond +-scale are clamped in the integer formats.
+     */
+    void store(size_t offset, const double* samples, size_t n);
+
+    /**
+     * @brief Dequantize positions [offset, offset + n) into out
+     */
+    void load(size_t offset, double* out, size_t n) const;
+
+    Format format() const { return sample_format; }
+    size_t size() const { return count; }
+    double scale() const { return sample_scale; }
+    size_t bytes() const { return count * bytesPerSample(sample_format); }
+
+    static size_t bytesPerSample(Format format);
+    static const char* formatName(Format format);
+
+    /**
+     * @brief Parse "float64", "float32", "int16" or "int8" (case-insensitive)
+     * @return false (format unchanged) if the name is unknown
+     */
+    static bool parseFormat(const std::string& name, Format& format);
+
+    /**
+     * @brief Format given to tracks created from now on (float64 unless changed)
+     */
+    static Format defaultFormat();
+    static void setDefaultFormat(Format format);
+
+    /**
+     * @brief Sample arrays allocated by every WaveformBuffer so far (a reset or a copy allocates one)
+     */
+    static uint64_t allocations();
+
+private:
+    static void countAllocation();
+
+    // std::allocator that counts its allocations
+    template <typename T>
+    struct Allocator {
+        typedef T value_type;
+
+        Allocator() {}
+        template <typename U>
+        Allocator(const Allocator<U>&) {}
+
+        T* allocate(size_t n) {
+            countAllocation();
+            return std::allocator<T>().allocate(n);
+        }
+        void deallocate(T* block, size_t n) { std::allocator<T>().deallocate(block, n); }
+
+        template <typename U>
+        bool operator==(const Allocator<U>&) const { return true; }
+        template <typename U>
+        bool operator!=(const Allocator<U>&) const { return false; }
+    };
+
+    template <typename T>
+    using Samples = std::vector<T, Allocator<T>>;
+
+    Format sample_format;
+    size_t count;
+    double sample_scale;
+    Samples<double> f64;
+    Samples<float> f32;
+    Samples<int16_t> i16;
+    Samples<int8_t> i8;
+};
+
+#endif // WAVEFORMBUFFER_H
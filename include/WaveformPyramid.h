@@ -0,0 +1,62 @@
+#ifndef WAVEFORMPYRAMID_H
+#define WAVEFORMPYRAMID_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Multi-resolution min/max/RMS summary of a waveform
+ *
+ * Level k summarizes consecutive blocks of 2^(k+1) samples (level 0: pairs),
+ * halving in size up to a single block for the whole waveform, so the
+ * pyramid costs about as many entries as the waveform has samples. A view
+ * that needs W columns, or an analysis that needs one value per N samples,
+ * reads the matching level in O(W) or O(samples / N) instead of rescanning
+ * every sample.
+ *
+ * Values are stored as float (an overview does not need double precision).
+ * Mean squares rather than RMS are kept so levels merge exactly; a partial
+ * tail block is weighted by the samples it actually covers.
+ */
+class WaveformPyramid {
+public:
+    struct Level {
+        size_t block;                    // Samples per entry
+        std::vector<float> min;
+        std::vector<float> max;
+        std::vector<float> mean_square;
+        Level() : block(0), min(), max(), mean_square() {}
+        size_t size() const { return min.size(); }
+    };
+
+    WaveformPyramid() : levels(), sample_count(0) {}
+
+    /**
+     * @brief Build every level from the samples (O(count), SSE2 reductions)
+     */
+    void build(const double* samples, size_t count);
+
+    size_t level_count() const { return levels.size(); }
+    const Level& level(size_t k) const { return levels[k]; }
+    size_t samples() const { return sample_count; }
+    size_t bytes() const;
+
+    /**
+     * @brief The coarsest level whose blocks are at most max_block samples
+     * @return nullptr if max_block < 2 (no level is fine enough)
+     */
+    const Level* coarsestAtMost(size_t max_block) const;
+
+    /**
+     * @brief Per-column min, max and RMS for a view width columns wide
+     * Reads the coarsest level that still gives each column at least one
+     * entry, so the cost is O(width) plus at most 2 entries per column.
+     */
+    void overview(size_t width, std::vector<float>& min, std::vector<float>& max, std::vector<float>& rms) const;
+
+private:
+    std::vector<Level> levels;
+    size_t sample_count;
+};
+
+#endif // WAVEFORMPYRAMID_H
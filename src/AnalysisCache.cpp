@@ -0,0 +1,119 @@
+#include "AnalysisCache.h"
+#include "BeatGridAnalyzer.h"
+#include "KeyDetector.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+
+AnalysisCache& AnalysisCache::shared() {
+    static AnalysisCache cache;
+    return cache;
+}
+
+std::shared_ptr<const BeatGrid> AnalysisCache::beatGrid(const AudioTrack& track) {
+    return beatGrid(track.get_payload(), track.get_duration(), track.get_bpm(),
+                    [&track] { return BeatGridAnalyzer::analyze(track); });
+}
+
+std::shared_ptr<const BeatGrid> AnalysisCache::beatGrid(const std::shared_ptr<const void>& source, int duration, int bpm,
+                                                        const std::function<std::shared_ptr<const BeatGrid>()>& analyze) {
+    Key key = {source.get(), duration, bpm};
+    return memo(key, source, &Entry::beat_grid, analyze, true);
+}
+
+std::shared_ptr<const HarmonicKey> AnalysisCache::harmonicKey(const AudioTrack& track) {
+    return harmonicKey(track.get_payload(), [&track] { return KeyDetector::detect(track); });
+}
+
+std::shared_ptr<const HarmonicKey> AnalysisCache::harmonicKey(
+        const std::shared_ptr<const void>& source, const std::function<std::shared_ptr<const HarmonicKey>()>& detect) {
+    Key key = {source.get(), -1, -1};   // No beat-grid entry has a negative duration
+    return memo(key, source, &Entry::harmonic_key, detect, false);
+}
+
+template <typename Result>
+std::shared_ptr<const Result> AnalysisCache::memo(const Key& key, const std::shared_ptr<const void>& source,
+                                                  std::shared_ptr<const Result> Entry::*field,
+                                                  const std::function<std::shared_ptr<const Result>()>& analyze,
+                                                  bool counted) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(key);
+        if (it != entries.end() && it->second.source.lock() == source && it->second.*field) {
+            reused += counted;
+            return it->second.*field;
+        }
+    }
+    std::shared_ptr<const Result> result = analyze();
+    std::lock_guard<std::mutex> lock(mutex);
+    computed += counted;
+    if (!result || !settled(*result)) {
+        return result;
+    }
+    Entry& entry = entries[key];
+    if (entry.source.lock() == source && entry.*field) {
+        return entry.*field;  // Another thread finished first
+    }
+    entry.source = source;
+    entry.*field = result;
+    if (entries.size() >= prune_at) {
+        pruneLocked();
+    }
+    return result;
+}
+
+void AnalysisCache::pruneLocked() {
+    for (auto it = entries.begin(); it != entries.end(); ) {
+        if (it->second.source.expired()) {
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    prune_at = std::max<size_t>(64, 2 * entries.size());
+}
+
+void AnalysisCache::setStoreDirectory(const std::string& directory) {
+    std::lock_guard<std::mutex> lock(mutex);
+    store_directory = directory;
+}
+
+std::string AnalysisCache::seekTablePath(const std::string& audio_path) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (store_directory.empty()) {
+        return "";
+    }
+    // FNV-1a of the full path: stable across runs, unlike std::hash
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : audio_path) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+    }
+    char suffix[24];
+    std::snprintf(suffix, sizeof(suffix), ".%016llx", static_cast<unsigned long long>(hash));
+    size_t slash = audio_path.find_last_of("/\\");
+    std::string name = slash == std::string::npos ? audio_path : audio_path.substr(slash + 1);
+    return store_directory + "/" + name + suffix + ".seek";
+}
+
+size_t AnalysisCache::analysesRun() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return computed;
+}
+
+size_t AnalysisCache::analysesSkipped() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return reused;
+}
+
+size_t AnalysisCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+void AnalysisCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    prune_at = 64;
+    computed = 0;
+    reused = 0;
+}
@@ -1,24 +1,92 @@
 #include "AudioTrack.h"
 #include <iostream>
-#include <cstring>
-#include <random>
+#include <algorithm>
+#include <cmath>
 
-AudioTrack::AudioTrack(const std::string& title, const std::vector<std::string>& artists, 
-                      int duration, int bpm, size_t waveform_samples)
-    : title(title), artists(artists), duration_seconds(duration), bpm(bpm), 
-      waveform_data(nullptr), waveform_size(waveform_samples) {
-
-    // Allocate memory for waveform analysis
-    waveform_data = new double[waveform_size];
+namespace {
 
-    // Generate some dummy waveform data for testing
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<double> dis(-1.0, 1.0);
+// FNV-1a, folded over every byte of the track's identifying metadata
+uint64_t fnv1a(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
 
-    for (size_t i = 0; i < waveform_size; ++i) {
-        waveform_data[i] = dis(gen);
+uint64_t track_seed(const std::string& title, const std::vector<std::string>& artists, int duration, int bpm) {
+    uint64_t hash = 14695981039346656037ULL;
+    hash = fnv1a(hash, title.data(), title.size());
+    for (const std::string& artist : artists) {
+        hash = fnv1a(hash, "\0", 1);
+        hash = fnv1a(hash, artist.data(), artist.size());
     }
+    hash = fnv1a(hash, &duration, sizeof(duration));
+    return fnv1a(hash, &bpm, sizeof(bpm));
+}
+
+// Counter-based generator (SplitMix64 finalizer): sample i depends only on (seed, i),
+// so the fill loop carries no generator state between samples.
+inline double sample_at(uint64_t seed, uint64_t i) {
+    uint64_t z = seed + (i + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    return static_cast<double>(z >> 11) * (2.0 / 9007199254740992.0) - 1.0;  // [-1, 1)
+}
+
+} // namespace
+
+void TrackPayload::read(size_t first, double* out, size_t count) const {
+    std::call_once(waveform_ready, [this] {
+        // Synthesized samples lie in [-1, 1), so the integer formats use scale 1
+        waveform.reset(waveform_format, waveform_size, 1.0);
+        const size_t batch = 64;
+        double block[batch];
+        for (size_t start = 0; start < waveform_size; start += batch) {
+            size_t end = start + batch < waveform_size ? start + batch : waveform_size;
+            for (size_t i = start; i < end; ++i) {
+                block[i - start] = sample_at(waveform_seed, i);
+            }
+            waveform.store(start, block, end - start);
+        }
+    });
+    waveform.load(first, out, count);
+}
+
+void TrackPayload::assign(const double* data, size_t count) {
+    std::call_once(waveform_ready, [this, data, count] {
+        double peak = 0.0;
+        for (size_t i = 0; i < count; ++i) {
+            peak = std::max(peak, std::fabs(data[i]));
+        }
+        waveform.reset(waveform_format, count, peak);
+        waveform.store(0, data, count);
+        waveform_size = count;
+    });
+    synthesized = false;
+}
+
+const WaveformPyramid& TrackPayload::pyramid() const {
+    std::call_once(levels_ready, [this] {
+        std::vector<double> samples(waveform_size);
+        read(samples.data(), samples.size());
+        levels.build(samples.data(), samples.size());
+    });
+    return levels;
+}
+
+AudioTrack::AudioTrack(const std::string& title, const std::vector<std::string>& artists, 
+                      int duration, int bpm, size_t waveform_samples)
+    : title(title), payload(), duration_seconds(duration), bpm(bpm), id(INVALID_TRACK_ID), beat_grid(),
+      camelot_key(HarmonicKey::UNKNOWN) {
+
+    // The waveform itself is synthesized on first read (see TrackPayload::read)
+    std::shared_ptr<TrackPayload> block = std::make_shared<TrackPayload>();
+    block->artists = artists;
+    block->waveform_size = waveform_samples;
+    block->waveform_seed = track_seed(title, artists, duration, bpm);
+    payload = block;
     #ifdef DEBUG
     std::cout << "AudioTrack created: " << title << " by " << std::endl;
     for (const auto& artist : artists) {
@@ -34,28 +102,15 @@ AudioTrack::~AudioTrack() {
     #ifdef DEBUG
     std::cout << "AudioTrack destructor called for: " << title << std::endl;
     #endif
-    delete[] waveform_data;
-    waveform_data = nullptr;
-    title.clear();
-    artists.clear();
-    duration_seconds = 0;
-    bpm = 0; 
-    waveform_size = 0;
 }
 //copy constructor
-AudioTrack::AudioTrack(const AudioTrack& other) : title(other.title), artists(other.artists),
-        duration_seconds(other.duration_seconds), bpm(other.bpm), waveform_data(nullptr), waveform_size(other.waveform_size)
+AudioTrack::AudioTrack(const AudioTrack& other) : title(other.title), payload(other.payload),
+        duration_seconds(other.duration_seconds), bpm(other.bpm), id(other.id), beat_grid(other.beat_grid),
+        camelot_key(other.camelot_key)
 {
     #ifdef DEBUG
     std::cout << "AudioTrack copy constructor called for: " << other.title << std::endl;
     #endif
-    if(other.waveform_data != nullptr && other.waveform_size > 0){
-        waveform_data = new double[other.waveform_size]; 
-        for(size_t i=0; i<other.waveform_size; i++){
-            waveform_data[i] = other.waveform_data[i];
-        }
-    }
- 
 }
 
 AudioTrack& AudioTrack::operator=(const AudioTrack& other) {
@@ -63,35 +118,27 @@ AudioTrack& AudioTrack::operator=(const AudioTrack& other) {
     std::cout << "AudioTrack copy assignment called for: " << other.title << std::endl;
     #endif
     if(this != &other){
-        delete[] waveform_data;
         title = other.title;
-        artists = other.artists;
+        payload = other.payload;
         duration_seconds = other.duration_seconds;
         bpm = other.bpm;
-        if(other.waveform_data != nullptr && other.waveform_size > 0){
-            waveform_data = new double[other.waveform_size]; 
-            for(size_t i=0; i<other.waveform_size; i++){
-                waveform_data[i] = other.waveform_data[i];
-            }
-            waveform_size = other.waveform_size;
-        }
-        else{
-            waveform_data = nullptr;
-            waveform_size = 0;
-        }    
+        id = other.id;
+        beat_grid = other.beat_grid;
+        camelot_key = other.camelot_key;
     }
     return *this;
 }
 
-AudioTrack::AudioTrack(AudioTrack&& other) noexcept : title(std::move(other.title)), artists(std::move(other.artists)),
-        duration_seconds(other.duration_seconds), bpm(other.bpm), waveform_data(other.waveform_data), waveform_size(other.waveform_size){
+// The payload pointer is copied rather than stolen so the moved-from track keeps a
+// valid (shared) payload; that costs one reference count increment.
+AudioTrack::AudioTrack(AudioTrack&& other) noexcept : title(std::move(other.title)), payload(other.payload),
+        duration_seconds(other.duration_seconds), bpm(other.bpm), id(other.id),
+        beat_grid(std::move(other.beat_grid)), camelot_key(other.camelot_key){
     #ifdef DEBUG
     std::cout << "AudioTrack move constructor called for: " << other.title << std::endl;
     #endif
     other.duration_seconds = 0;
     other.bpm = 0;
-    other.waveform_data = nullptr;
-    other.waveform_size = 0; 
 }
 
 AudioTrack& AudioTrack::operator=(AudioTrack&& other) noexcept {
@@ -99,25 +146,69 @@ AudioTrack& AudioTrack::operator=(AudioTrack&& other) noexcept {
     std::cout << "AudioTrack move assignment called for: " << other.title << std::endl;
     #endif
     if (this != &other){
-        delete[] waveform_data;
-
         title = std::move(other.title);
-        artists = std::move(other.artists);
+        payload = other.payload;
         duration_seconds = other.duration_seconds;
         bpm = other.bpm;
-        waveform_data = other.waveform_data;
-        waveform_size = other.waveform_size; 
+        id = other.id;
+        beat_grid = std::move(other.beat_grid);
+        camelot_key = other.camelot_key;
 
         other.duration_seconds = 0;
         other.bpm = 0;
-        other.waveform_data = nullptr;
-        other.waveform_size = 0; 
     }
     return *this;
 }
 
+void AudioTrack::load() {
+    load(std::cout);
+}
+
+void AudioTrack::analyze_beatgrid() {
+    analyze_beatgrid(std::cout);
+}
+
+size_t AudioTrack::get_memory_footprint() const {
+    // Counted in full for every copy: the cache budget is per entry, not per unique payload
+    return payload->waveform_size * WaveformBuffer::bytesPerSample(payload->waveform_format);
+}
+
+void AudioTrack::set_waveform(const double* samples, size_t sample_count) {
+    // Copy-on-write: other copies keep the old block
+    std::shared_ptr<TrackPayload> block = std::make_shared<TrackPayload>();
+    block->artists = payload->artists;
+    block->waveform_format = payload->waveform_format;
+    block->assign(samples, sample_count);
+    payload = block;
+    beat_grid.reset();  // Describes the old samples
+    camelot_key = HarmonicKey::UNKNOWN;
+}
+
+void AudioTrack::set_analysis(const std::shared_ptr<const BeatGrid>& grid, int key) {
+    beat_grid = grid;
+    camelot_key = key;
+}
+
+void AudioTrack::set_waveform_format(WaveformBuffer::Format format) {
+    if (format == payload->waveform_format) {
+        return;
+    }
+    std::shared_ptr<TrackPayload> block = std::make_shared<TrackPayload>();
+    block->artists = payload->artists;
+    block->waveform_size = payload->waveform_size;
+    block->waveform_seed = payload->waveform_seed;
+    block->waveform_format = format;
+    if (!payload->synthesized) {
+        // Installed samples cannot be regenerated from the seed: re-encode them
+        std::vector<double> samples(payload->waveform_size);
+        payload->read(samples.data(), samples.size());
+        block->assign(samples.data(), samples.size());
+    }
+    payload = block;
+}
+
 void AudioTrack::get_waveform_copy(double* buffer, size_t buffer_size) const {
-    if (buffer && waveform_data && buffer_size <= waveform_size) {
-        std::memcpy(buffer, waveform_data, buffer_size * sizeof(double));
+    if (buffer && buffer_size <= payload->waveform_size) {
+        payload->read(buffer, buffer_size);
     }
 }
\ No newline at end of file
@@ -0,0 +1,290 @@
+#include "BeatGridAnalyzer.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+constexpr double BeatGridAnalyzer::MIN_BPM;
+constexpr double BeatGridAnalyzer::MAX_BPM;
+constexpr double BeatGridAnalyzer::FRAME_RATE;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+std::atomic<long long> time_budget_us(100000);   // Per minute of audio
+
+// The half-period tempo wins if its autocorrelation is at least this share of the peak
+const double OCTAVE_PREFERENCE = 0.8;
+
+// ---- Kernels: vector body + scalar tail ----
+
+double sum_of_squares(const double* x, size_t n) {
+    double total = 0.0;
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128d acc = _mm_setzero_pd();
+    for (; i + 2 <= n; i += 2) {
+        __m128d v = _mm_loadu_pd(x + i);
+        acc = _mm_add_pd(acc, _mm_mul_pd(v, v));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, acc);
+    total = lanes[0] + lanes[1];
+#endif
+    for (; i < n; ++i) {
+        total += x[i] * x[i];
+    }
+    return total;
+}
+
+// out[t] = max(0, e[t] - e[t-1]) for t >= 1, out[0] = 0
+void rectified_difference(const double* e, double* out, size_t n) {
+    if (n == 0) return;
+    out[0] = 0.0;
+    size_t t = 1;
+#if defined(__SSE2__)
+    const __m128d zero = _mm_setzero_pd();
+    for (; t + 2 <= n; t += 2) {
+        __m128d d = _mm_sub_pd(_mm_loadu_pd(e + t), _mm_loadu_pd(e + t - 1));
+        _mm_storeu_pd(out + t, _mm_max_pd(d, zero));
+    }
+#endif
+    for (; t < n; ++t) {
+        out[t] = std::max(0.0, e[t] - e[t - 1]);
+    }
+}
+
+void subtract(double* x, size_t n, double value) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128d v = _mm_set1_pd(value);
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd(x + i, _mm_sub_pd(_mm_loadu_pd(x + i), v));
+    }
+#endif
+    for (; i < n; ++i) {
+        x[i] -= value;
+    }
+}
+
+double dot(const double* a, const double* b, size_t n) {
+    double total = 0.0;
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    for (; i + 4 <= n; i += 4) {
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+    total = lanes[0] + lanes[1];
+#endif
+    for (; i < n; ++i) {
+        total += a[i] * b[i];
+    }
+    return total;
+}
+
+// Beats every 60/bpm seconds starting at offset, up to duration
+void lay_out_beats(BeatGrid& grid, double offset, double duration) {
+    grid.beats.clear();
+    if (grid.bpm <= 0.0) return;
+    double period = 60.0 / grid.bpm;
+    grid.beats.reserve(static_cast<size_t>(duration / period) + 1);
+    for (double t = offset; t < duration; t += period) {
+        grid.beats.push_back(t);
+    }
+}
+
+// Vertex of the parabola through ac[lag - 1], ac[lag], ac[lag + 1]: a beat period that
+// falls between two lags splits its peak, and the vertex recovers its height and position
+double refine_peak(const std::vector<double>& ac, size_t lag, size_t min_lag, size_t max_lag, double& position) {
+    position = static_cast<double>(lag);
+    if (lag <= min_lag || lag >= max_lag) {
+        return ac[lag];
+    }
+    double left = ac[lag - 1], center = ac[lag], right = ac[lag + 1];
+    double curvature = left - 2.0 * center + right;
+    if (curvature >= 0.0) {
+        return center;
+    }
+    double offset = 0.5 * (left - right) / curvature;
+    position += offset;
+    return center - 0.25 * (left - right) * offset;
+}
+
+// Tempo and beats from per-frame energies (energy is used as scratch)
+std::shared_ptr<const BeatGrid> detect(std::vector<double>& energy, double frame_rate, double duration,
+                                       double fallback_bpm, Clock::time_point deadline) {
+    std::shared_ptr<BeatGrid> grid = std::make_shared<BeatGrid>();
+    grid->bpm = fallback_bpm;
+    const size_t frames = energy.size();
+    const size_t min_lag = static_cast<size_t>(std::ceil(frame_rate * 60.0 / BeatGridAnalyzer::MAX_BPM));
+    const size_t max_lag = std::min(static_cast<size_t>(frame_rate * 60.0 / BeatGridAnalyzer::MIN_BPM), frames / 2);
+    if (min_lag < 2 || max_lag < min_lag + 2) {
+        // Too few frames per beat (or per track) to resolve 60-200 BPM
+        lay_out_beats(*grid, 0.0, duration);
+        return grid;
+    }
+
+    // 1. Onset strength envelope
+    std::vector<double> onset(frames);
+    rectified_difference(energy.data(), onset.data(), frames);
+    // [1 2 1] smoothing (in place, energy reused as scratch) widens the onset peaks,
+    // so beat periods that are not whole frames still line up in the autocorrelation
+    std::copy(onset.begin(), onset.end(), energy.begin());
+    for (size_t f = 1; f + 1 < frames; ++f) {
+        onset[f] = 0.25 * energy[f - 1] + 0.5 * energy[f] + 0.25 * energy[f + 1];
+    }
+    double mean = 0.0;
+    for (double value : onset) mean += value;
+    subtract(onset.data(), frames, mean / frames);
+
+    // 2. Tempo: normalized (unbiased) autocorrelation over the beat-period lags
+    const double power = dot(onset.data(), onset.data(), frames) / frames;
+    std::vector<double> ac(max_lag + 1, 0.0);
+    size_t best = 0;
+    for (size_t lag = min_lag; lag <= max_lag; ++lag) {
+        if (Clock::now() > deadline) {
+            grid->complete = false;
+            lay_out_beats(*grid, 0.0, duration);
+            return grid;
+        }
+        ac[lag] = power > 0.0 ? dot(onset.data(), onset.data() + lag, frames - lag) / (frames - lag) / power : 0.0;
+        if (best == 0 || ac[lag] > ac[best]) best = lag;
+    }
+    double period;
+    double strength = refine_peak(ac, best, min_lag, max_lag, period);
+    // The double tempo (half the lag, +-1 for rounding) is preferred when nearly as strong
+    size_t half = best / 2;
+    for (size_t lag = best / 2 + 1; lag <= (best + 2) / 2 && lag <= max_lag; ++lag) {
+        if (ac[lag] > ac[half]) half = lag;
+    }
+    if (half >= min_lag) {
+        double half_period;
+        double half_strength = refine_peak(ac, half, min_lag, max_lag, half_period);
+        if (half_strength >= OCTAVE_PREFERENCE * strength) {
+            best = half;
+            period = half_period;
+            strength = half_strength;
+        }
+    }
+    grid->confidence = std::max(0.0, std::min(1.0, strength));
+    if (!grid->confident()) {
+        lay_out_beats(*grid, 0.0, duration);
+        return grid;
+    }
+    grid->bpm = 60.0 * frame_rate / period;
+
+    // 3. Beat phase: the comb offset collecting the most onset strength
+    size_t best_phase = 0;
+    double best_score = -1.0;
+    for (size_t phase = 0; phase < best; ++phase) {
+        double score = 0.0;
+        for (double t = static_cast<double>(phase); t < frames; t += period) {
+            score += onset[static_cast<size_t>(t)];
+        }
+        if (score > best_score) {
+            best_score = score;
+            best_phase = phase;
+        }
+    }
+    lay_out_beats(*grid, best_phase / frame_rate, duration);
+    return grid;
+}
+
+} // namespace
+
+std::chrono::microseconds BeatGridAnalyzer::timeBudget() {
+    return std::chrono::microseconds(time_budget_us.load());
+}
+
+std::chrono::microseconds BeatGridAnalyzer::timeBudget(double duration_seconds) {
+    const double minutes = std::max(1.0, duration_seconds / 60.0);
+    return std::chrono::microseconds(static_cast<long long>(minutes * time_budget_us.load()));
+}
+
+void BeatGridAnalyzer::setTimeBudget(std::chrono::microseconds per_minute) {
+    time_budget_us.store(per_minute.count());
+}
+
+std::shared_ptr<const BeatGrid> BeatGridAnalyzer::analyze(const AudioTrack& track) {
+    const size_t count = track.get_waveform_size();
+    const double duration = std::max(0, track.get_duration());
+    const double sample_rate = duration > 0.0 ? count / duration : 0.0;
+    // Frame energies straight from a pyramid level: O(frames) instead of O(samples).
+    // Blocks are powers of two, so take the coarsest level at or above FRAME_RATE / 2
+    // (the autocorrelation costs grow with the square of the frame rate)
+    const WaveformPyramid::Level* level = count >= 2 && sample_rate / FRAME_RATE >= 1.0
+        ? track.get_waveform_pyramid().coarsestAtMost(static_cast<size_t>(2.0 * sample_rate / FRAME_RATE)) : nullptr;
+    if (!level) {
+        std::vector<double> samples(count);
+        track.get_waveform_copy(samples.data(), samples.size());
+        return analyze(samples.data(), samples.size(), duration, track.get_bpm(), timeBudget(duration));
+    }
+    // The clock starts once the pyramid is built
+    const Clock::time_point deadline = Clock::now() + timeBudget(duration);
+    std::vector<double> energy(count / level->block);  // Whole blocks only
+    for (size_t f = 0; f < energy.size(); ++f) {
+        energy[f] = level->mean_square[f] * static_cast<double>(level->block);
+    }
+    return detect(energy, sample_rate / level->block, duration, track.get_bpm(), deadline);
+}
+
+std::shared_ptr<const BeatGrid> BeatGridAnalyzer::analyze(const double* samples, size_t count, double duration_seconds,
+                                                          double fallback_bpm, std::chrono::microseconds budget) {
+    const Clock::time_point deadline = Clock::now() + budget;
+    const double duration = std::max(0.0, duration_seconds);
+    // Frame layout: hop samples per onset frame, aiming at FRAME_RATE frames/s
+    const double sample_rate = duration > 0.0 ? count / duration : 0.0;
+    const size_t hop = std::max<size_t>(1, static_cast<size_t>(sample_rate / FRAME_RATE));
+    std::vector<double> energy(count / hop);
+    for (size_t f = 0; f < energy.size(); ++f) {
+        energy[f] = sum_of_squares(samples + f * hop, hop);
+    }
+    return detect(energy, sample_rate / hop, duration, fallback_bpm, deadline);
+}
+
+std::shared_ptr<const BeatGrid> BeatGridAnalyzer::analyze(const WavFile::PcmView& pcm, double fallback_bpm,
+                                                          std::chrono::microseconds budget) {
+    const Clock::time_point deadline = Clock::now() + budget;
+    const size_t hop = std::max<size_t>(1, static_cast<size_t>(pcm.sample_rate / FRAME_RATE));
+    std::vector<double> energy(static_cast<size_t>(pcm.frames / hop));
+    std::vector<double> block(hop);   // The only copy: one hop of mono samples
+    for (size_t f = 0; f < energy.size(); ++f) {
+        if (f % 256 == 0 && Clock::now() > deadline) {
+            std::shared_ptr<BeatGrid> grid = std::make_shared<BeatGrid>();
+            grid->bpm = fallback_bpm;
+            grid->complete = false;
+            lay_out_beats(*grid, 0.0, pcm.duration());
+            return grid;
+        }
+        pcm.read_mono(static_cast<uint64_t>(f) * hop, hop, block.data());
+        energy[f] = sum_of_squares(block.data(), hop);
+    }
+    return detect(energy, static_cast<double>(pcm.sample_rate) / hop, pcm.duration(), fallback_bpm, deadline);
+}
+
+std::shared_ptr<const BeatGrid> BeatGridAnalyzer::analyze(const Mp3File& file, double fallback_bpm,
+                                                          std::chrono::microseconds budget) {
+    const Clock::time_point deadline = Clock::now() + budget;
+    const unsigned granules = file.granules_per_frame();
+    std::vector<double> energy(static_cast<size_t>(file.frame_count()) * granules);
+    const uint32_t batch = 256;   // Frames between deadline checks
+    for (uint32_t first = 0; first < file.frame_count(); first += batch) {
+        if (Clock::now() > deadline) {
+            std::shared_ptr<BeatGrid> grid = std::make_shared<BeatGrid>();
+            grid->bpm = fallback_bpm;
+            grid->complete = false;
+            lay_out_beats(*grid, 0.0, file.duration());
+            return grid;
+        }
+        file.granule_energy(first, std::min(batch, file.frame_count() - first), energy.data() + first * granules);
+    }
+    return detect(energy, file.sample_rate() / 576.0, file.duration(), fallback_bpm, deadline);
+}
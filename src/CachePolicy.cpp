@@ -0,0 +1,398 @@
+#include "CachePolicy.h"
+#include "CacheSlot.h"
+#include <algorithm>
+#include <cctype>
+#include <functional>
+#include <iterator>
+
+// ========== FACTORY ==========
+
+PointerWrapper<CachePolicy> CachePolicy::create(const std::string& name) {
+    std::string upper = name;
+    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+    if (upper == "LRU") return PointerWrapper<CachePolicy>(new LRUPolicy());
+    if (upper == "LFU") return PointerWrapper<CachePolicy>(new LFUPolicy());
+    if (upper == "2Q") return PointerWrapper<CachePolicy>(new TwoQueuePolicy());
+    if (upper == "ARC") return PointerWrapper<CachePolicy>(new ARCPolicy());
+    if (upper == "W-TINYLFU" || upper == "TINYLFU") return PointerWrapper<CachePolicy>(new TinyLFUPolicy());
+    return PointerWrapper<CachePolicy>();
+}
+
+std::vector<std::string> CachePolicy::names() {
+    return {"LRU", "LFU", "2Q", "ARC", "W-TinyLFU"};
+}
+
+// ========== SlotList ==========
+
+SlotList::SlotList()
+    : prev(), next(), member(), head(CacheSlot::npos), tail(CacheSlot::npos), count(0) {}
+
+void SlotList::reset(size_t capacity) {
+    prev.assign(capacity, CacheSlot::npos);
+    next.assign(capacity, CacheSlot::npos);
+    member.assign(capacity, false);
+    head = tail = CacheSlot::npos;
+    count = 0;
+}
+
+void SlotList::pushFront(size_t slot) {
+    prev[slot] = CacheSlot::npos;
+    next[slot] = head;
+    if (head != CacheSlot::npos) prev[head] = slot; else tail = slot;
+    head = slot;
+    member[slot] = true;
+    count++;
+}
+
+void SlotList::remove(size_t slot) {
+    if (!contains(slot)) return;
+    if (prev[slot] != CacheSlot::npos) next[prev[slot]] = next[slot]; else head = next[slot];
+    if (next[slot] != CacheSlot::npos) prev[next[slot]] = prev[slot]; else tail = prev[slot];
+    prev[slot] = next[slot] = CacheSlot::npos;
+    member[slot] = false;
+    count--;
+}
+
+// ========== GhostList ==========
+
+GhostList::GhostList(const GhostList& other) : order(other.order), where() {
+    // The index must point into this list, not the other one
+    for (auto it = order.begin(); it != order.end(); ++it) {
+        where[*it] = it;
+    }
+}
+
+void GhostList::pushFront(CacheKey key) {
+    remove(key);
+    order.push_front(key);
+    where[key] = order.begin();
+}
+
+bool GhostList::remove(CacheKey key) {
+    auto it = where.find(key);
+    if (it == where.end()) return false;
+    order.erase(it->second);
+    where.erase(it);
+    return true;
+}
+
+void GhostList::popBack() {
+    if (order.empty()) return;
+    where.erase(order.back());
+    order.pop_back();
+}
+
+// ========== LRU ==========
+
+void LRUPolicy::onInsert(size_t slot, CacheKey key) {
+    (void)key;
+    recency.pushFront(slot);
+}
+
+size_t LRUPolicy::victim(CacheKey incoming) const {
+    (void)incoming;
+    return recency.back();
+}
+
+void LRUPolicy::onEvict(size_t slot, CacheKey key) {
+    (void)key;
+    recency.remove(slot);
+}
+
+// ========== LFU ==========
+
+LFUPolicy::LFUPolicy(const LFUPolicy& other)
+    : CachePolicy(other), buckets(other.buckets), bucket_of(other.bucket_of.size()), pos(other.pos.size()) {
+    // Iterators must point into this policy's buckets, not the other one's
+    for (auto bucket = buckets.begin(); bucket != buckets.end(); ++bucket) {
+        for (auto it = bucket->slots.begin(); it != bucket->slots.end(); ++it) {
+            bucket_of[*it] = bucket;
+            pos[*it] = it;
+        }
+    }
+}
+
+void LFUPolicy::reset(size_t capacity) {
+    buckets.clear();
+    bucket_of.assign(capacity, std::list<Bucket>::iterator());
+    pos.assign(capacity, std::list<size_t>::iterator());
+}
+
+void LFUPolicy::unlinkSlot(size_t slot) {
+    auto bucket = bucket_of[slot];
+    bucket->slots.erase(pos[slot]);
+    if (bucket->slots.empty()) {
+        buckets.erase(bucket);
+    }
+}
+
+void LFUPolicy::onHit(size_t slot) {
+    auto bucket = bucket_of[slot];
+    auto next = std::next(bucket);
+    if (next == buckets.end() || next->freq != bucket->freq + 1) {
+        next = buckets.insert(next, Bucket{bucket->freq + 1, std::list<size_t>()});
+    }
+    // splice keeps pos[slot] valid; it now points into next's list
+    next->slots.splice(next->slots.begin(), bucket->slots, pos[slot]);
+    bucket_of[slot] = next;
+    if (bucket->slots.empty()) {
+        buckets.erase(bucket);
+    }
+}
+
+void LFUPolicy::onInsert(size_t slot, CacheKey key) {
+    (void)key;
+    if (buckets.empty() || buckets.front().freq != 1) {
+        buckets.push_front(Bucket{1, std::list<size_t>()});
+    }
+    buckets.front().slots.push_front(slot);
+    bucket_of[slot] = buckets.begin();
+    pos[slot] = buckets.front().slots.begin();
+}
+
+size_t LFUPolicy::victim(CacheKey incoming) const {
+    (void)incoming;
+    return buckets.empty() ? CacheSlot::npos : buckets.front().slots.back();
+}
+
+void LFUPolicy::onEvict(size_t slot, CacheKey key) {
+    (void)key;
+    unlinkSlot(slot);
+}
+
+// ========== 2Q ==========
+
+void TwoQueuePolicy::reset(size_t capacity) {
+    a1in.reset(capacity);
+    am.reset(capacity);
+    a1out.clear();
+    kin = std::max<size_t>(1, capacity / 4);
+    kout = std::max<size_t>(1, capacity / 2);
+}
+
+void TwoQueuePolicy::onHit(size_t slot) {
+    // Hits inside A1in are deliberately ignored: correlated re-references
+    // should not promote a track on their own.
+    if (am.contains(slot)) {
+        am.moveToFront(slot);
+    }
+}
+
+void TwoQueuePolicy::onInsert(size_t slot, CacheKey key) {
+    if (a1out.remove(key)) {
+        am.pushFront(slot);
+    } else {
+        a1in.pushFront(slot);
+    }
+}
+
+size_t TwoQueuePolicy::victim(CacheKey incoming) const {
+    (void)incoming;
+    if (!a1in.empty() && (a1in.size() > kin || am.empty())) {
+        return a1in.back();
+    }
+    return am.back();
+}
+
+void TwoQueuePolicy::onEvict(size_t slot, CacheKey key) {
+    if (a1in.contains(slot)) {
+        a1in.remove(slot);
+        a1out.pushFront(key);
+        while (a1out.size() > kout) {
+            a1out.popBack();
+        }
+    } else {
+        am.remove(slot);
+    }
+}
+
+// ========== ARC ==========
+
+void ARCPolicy::reset(size_t new_capacity) {
+    t1.reset(new_capacity);
+    t2.reset(new_capacity);
+    b1.clear();
+    b2.clear();
+    capacity = new_capacity;
+    target_t1 = 0;
+}
+
+void ARCPolicy::onMiss(CacheKey key) {
+    if (b1.contains(key)) {
+        size_t delta = std::max<size_t>(1, b2.size() / b1.size());
+        target_t1 = std::min(capacity, target_t1 + delta);
+    } else if (b2.contains(key)) {
+        size_t delta = std::max<size_t>(1, b1.size() / b2.size());
+        target_t1 = target_t1 > delta ? target_t1 - delta : 0;
+    }
+}
+
+void ARCPolicy::onHit(size_t slot) {
+    t1.remove(slot);
+    t2.remove(slot);
+    t2.pushFront(slot);
+}
+
+void ARCPolicy::onInsert(size_t slot, CacheKey key) {
+    bool seen_before = b1.remove(key);
+    seen_before = b2.remove(key) || seen_before;
+    if (seen_before) {
+        t2.pushFront(slot);
+    } else {
+        t1.pushFront(slot);
+    }
+    trimGhosts();
+}
+
+size_t ARCPolicy::victim(CacheKey incoming) const {
+    // ARC's REPLACE(x)
+    if (!t1.empty() && (t1.size() > target_t1 || (b2.contains(incoming) && t1.size() == target_t1))) {
+        return t1.back();
+    }
+    return t2.empty() ? t1.back() : t2.back();
+}
+
+void ARCPolicy::onEvict(size_t slot, CacheKey key) {
+    if (t1.contains(slot)) {
+        t1.remove(slot);
+        b1.pushFront(key);
+    } else {
+        t2.remove(slot);
+        b2.pushFront(key);
+    }
+    trimGhosts();
+}
+
+void ARCPolicy::trimGhosts() {
+    // Invariants: |T1| + |B1| <= c and |T1| + |T2| + |B1| + |B2| <= 2c
+    while (b1.size() > 0 && t1.size() + b1.size() > capacity) {
+        b1.popBack();
+    }
+    while (t1.size() + t2.size() + b1.size() + b2.size() > 2 * capacity) {
+        if (b2.size() > 0) b2.popBack(); else if (b1.size() > 0) b1.popBack(); else break;
+    }
+}
+
+// ========== W-TinyLFU ==========
+
+void FrequencySketch::reset(size_t capacity) {
+    size_t width = 16;
+    while (width < capacity * 4) {
+        width <<= 1;
+    }
+    table.assign(width * 4, 0);
+    mask = width - 1;
+    additions = 0;
+    sample_size = std::max<size_t>(16, capacity * 10);
+}
+
+size_t FrequencySketch::indexOf(size_t hash, size_t row) const {
+    static const uint64_t seeds[4] = {
+        0x9E3779B97F4A7C15ULL, 0xC2B2AE3D27D4EB4FULL, 0x165667B19E3779F9ULL, 0x27D4EB2F165667C5ULL};
+    uint64_t h = (static_cast<uint64_t>(hash) + seeds[row]) * seeds[(row + 1) & 3];
+    h ^= h >> 32;
+    return row * (mask + 1) + (static_cast<size_t>(h) & mask);
+}
+
+void FrequencySketch::increment(size_t hash) {
+    if (table.empty()) return;
+    for (size_t row = 0; row < 4; ++row) {
+        uint8_t& counter = table[indexOf(hash, row)];
+        if (counter < 15) counter++;
+    }
+    // Aging: halve every counter once per sample period so stale popularity fades
+    if (++additions >= sample_size) {
+        for (uint8_t& counter : table) {
+            counter >>= 1;
+        }
+        additions /= 2;
+    }
+}
+
+unsigned FrequencySketch::frequency(size_t hash) const {
+    if (table.empty()) return 0;
+    unsigned result = 15;
+    for (size_t row = 0; row < 4; ++row) {
+        result = std::min<unsigned>(result, table[indexOf(hash, row)]);
+    }
+    return result;
+}
+
+void TinyLFUPolicy::reset(size_t capacity) {
+    window.reset(capacity);
+    probation.reset(capacity);
+    protected_.reset(capacity);
+    hashes.assign(capacity, 0);
+    sketch.reset(capacity);
+    window_cap = std::max<size_t>(1, capacity / 100);
+    main_cap = capacity > window_cap ? capacity - window_cap : 0;
+    protected_cap = main_cap * 4 / 5;
+}
+
+void TinyLFUPolicy::onMiss(CacheKey key) {
+    sketch.increment(std::hash<CacheKey>()(key));
+}
+
+void TinyLFUPolicy::onHit(size_t slot) {
+    sketch.increment(hashes[slot]);
+    if (window.contains(slot)) {
+        window.moveToFront(slot);
+    } else if (probation.contains(slot)) {
+        probation.remove(slot);
+        protected_.pushFront(slot);
+        if (protected_.size() > protected_cap) {
+            size_t demoted = protected_.back();
+            protected_.remove(demoted);
+            probation.pushFront(demoted);
+        }
+    } else {
+        protected_.moveToFront(slot);
+    }
+}
+
+void TinyLFUPolicy::onInsert(size_t slot, CacheKey key) {
+    hashes[slot] = std::hash<CacheKey>()(key);
+    window.pushFront(slot);
+    // While the main area has room, window overflow simply migrates to probation
+    while (window.size() > window_cap && main_cap > 0) {
+        size_t migrated = window.back();
+        window.remove(migrated);
+        probation.pushFront(migrated);
+    }
+}
+
+size_t TinyLFUPolicy::victim(CacheKey incoming) const {
+    (void)incoming;
+    if (main_cap == 0 || (probation.empty() && protected_.empty())) {
+        return window.back();
+    }
+    if (window.empty() || window.size() < window_cap) {
+        return probation.empty() ? protected_.back() : probation.back();
+    }
+    // The incoming track will push the window's LRU entry into the main area;
+    // admit it only if it is more popular than the main area's victim.
+    size_t candidate = window.back();
+    size_t main_victim = probation.empty() ? protected_.back() : probation.back();
+    if (sketch.frequency(hashes[candidate]) > sketch.frequency(hashes[main_victim])) {
+        return main_victim;
+    }
+    return candidate;
+}
+
+void TinyLFUPolicy::commitVictim(size_t slot) {
+    // victim() only picks a main-area slot over a full window when it admitted
+    // the window's candidate: move the candidate now that the eviction is certain
+    if (main_cap == 0 || window.contains(slot) || window.empty() || window.size() < window_cap) {
+        return;
+    }
+    size_t candidate = window.back();
+    window.remove(candidate);
+    probation.pushFront(candidate);
+}
+
+void TinyLFUPolicy::onEvict(size_t slot, CacheKey key) {
+    (void)key;
+    window.remove(slot);
+    probation.remove(slot);
+    protected_.remove(slot);
+}
@@ -0,0 +1,126 @@
+#include "CacheSimulator.h"
+#include "CachePolicy.h"
+#include "ShadowCache.h"
+#include <algorithm>
+#include <iomanip>
+#include <set>
+#include <utility>
+
+std::vector<std::string> CacheSimulator::buildTrace(const SessionConfig& config) {
+    // std::map iterates playlists in name order, the order play-all uses
+    std::vector<std::string> trace;
+    for (const auto& playlist : config.playlists) {
+        for (int index : playlist.second) {
+            if (index < 1 || index > static_cast<int>(config.library_tracks.size())) {
+                continue;
+            }
+            trace.push_back(config.library_tracks[index - 1].title);
+        }
+    }
+    return trace;
+}
+
+CacheSimulator::CacheSimulator(const std::vector<std::string>& trace)
+    : trace(trace), ids(), registry() {
+    ids.reserve(trace.size());
+    for (const std::string& key : trace) {
+        ids.push_back(registry.intern(key));
+    }
+}
+
+double CacheSimulator::missRatio(const std::string& policy_name, size_t capacity) const {
+    if (trace.empty()) {
+        return 0.0;
+    }
+    ShadowCache shadow(CachePolicy::create(policy_name), capacity);
+    for (TrackId id : ids) {
+        shadow.access(id);
+    }
+    return 1.0 - shadow.hitRatio();
+}
+
+double CacheSimulator::optimalMissRatio(size_t capacity) const {
+    if (ids.empty()) {
+        return 0.0;
+    }
+    const size_t never = ids.size();
+    // next_use[i] = position of the next access to ids[i], or `never`
+    std::vector<size_t> next_use(ids.size());
+    std::vector<size_t> upcoming(registry.size(), never);
+    for (size_t i = ids.size(); i-- > 0; ) {
+        next_use[i] = upcoming[ids[i]];
+        upcoming[ids[i]] = i;
+    }
+    std::vector<size_t> cached_until(registry.size(), never);  // next use of a cached track
+    std::vector<bool> cached(registry.size(), false);
+    std::set<std::pair<size_t, TrackId>> by_next_use;
+    size_t misses = 0;
+    for (size_t i = 0; i < ids.size(); ++i) {
+        TrackId id = ids[i];
+        if (cached[id]) {
+            by_next_use.erase(std::make_pair(cached_until[id], id));
+        } else {
+            misses++;
+            if (capacity == 0) {
+                continue;
+            }
+            if (by_next_use.size() == capacity) {
+                auto farthest = std::prev(by_next_use.end());
+                cached[farthest->second] = false;
+                by_next_use.erase(farthest);
+            }
+            cached[id] = true;
+        }
+        cached_until[id] = next_use[i];
+        by_next_use.insert(std::make_pair(next_use[i], id));
+    }
+    return static_cast<double>(misses) / ids.size();
+}
+
+std::vector<size_t> CacheSimulator::reuseDistances() const {
+    std::vector<size_t> counts;
+    std::vector<TrackId> stack;  // most recently used first
+    for (TrackId id : ids) {
+        auto it = std::find(stack.begin(), stack.end(), id);
+        if (it != stack.end()) {
+            size_t distance = static_cast<size_t>(it - stack.begin());
+            if (counts.size() <= distance) {
+                counts.resize(distance + 1, 0);
+            }
+            counts[distance]++;
+            stack.erase(it);
+        }
+        stack.insert(stack.begin(), id);
+    }
+    return counts;
+}
+
+void CacheSimulator::writeMissRatioCurves(std::ostream& out, const std::vector<size_t>& capacities) const {
+    std::vector<std::string> policies = CachePolicy::names();
+    out << "capacity";
+    for (const std::string& name : policies) {
+        out << "," << name;
+    }
+    out << ",OPT\n";
+    out << std::fixed << std::setprecision(4);
+    for (size_t capacity : capacities) {
+        out << capacity;
+        for (const std::string& name : policies) {
+            out << "," << missRatio(name, capacity);
+        }
+        out << "," << optimalMissRatio(capacity) << "\n";
+    }
+}
+
+void CacheSimulator::writeReuseHistogram(std::ostream& out) const {
+    std::vector<size_t> counts = reuseDistances();
+    out << "reuse_distance,accesses,lru_hit_ratio\n";
+    out << std::fixed << std::setprecision(4);
+    // An LRU cache of capacity d + 1 hits every re-access at distance <= d
+    size_t hits = 0;
+    for (size_t d = 0; d < counts.size(); ++d) {
+        hits += counts[d];
+        out << d << "," << counts[d] << "," << (trace.empty() ? 0.0 : static_cast<double>(hits) / trace.size()) << "\n";
+    }
+    out << "cold," << coldMisses() << ",\n";
+}
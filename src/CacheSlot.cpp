@@ -1,13 +1,19 @@
 #include "CacheSlot.h"
 
+const size_t CacheSlot::npos;
+
 CacheSlot::CacheSlot() : 
     track(nullptr), 
     last_access_time(0), 
-    occupied(false){
+    occupied(false),
+    bytes(0),
+    prev(npos),
+    next(npos){
 }
 
 void CacheSlot::store(PointerWrapper<AudioTrack> track_ptr, uint64_t access_time) {
-    track = std::move(track_ptr);
+    track.reset(track_ptr.release());
+    bytes = track ? track->get_memory_footprint() : 0;
     last_access_time = access_time;
     occupied = true;
 }
@@ -22,7 +28,8 @@ AudioTrack* CacheSlot::access(uint64_t access_time) {
 }
 
 void CacheSlot::clear() {
-    track.reset(nullptr);
+    track.reset();
     occupied = false;
+    bytes = 0;
     last_access_time = 0;
 }
\ No newline at end of file
@@ -0,0 +1,175 @@
+#include "CacheSnapshot.h"
+#include "MP3Track.h"
+#include "WAVTrack.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+const char MAGIC[4] = {'D', 'J', 'C', 'S'};
+const uint32_t VERSION = 2;
+
+// EntryHeader::flags
+const uint32_t ANALYZED = 1;      // The beat grid and key fields are set
+const uint32_t COMPLETE = 2;      // BeatGrid::complete
+const uint32_t SYNTHESIZED = 4;   // The waveform is the seed's
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+struct EntryHeader {
+    uint32_t title_length;
+    uint32_t format;
+    int32_t duration;
+    int32_t bpm;
+    uint64_t waveform_seed;
+    uint64_t waveform_size;
+    double grid_bpm;
+    double confidence;
+    double first_beat;
+    uint32_t beat_count;
+    int32_t camelot_key;
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+// Beats every 60/bpm seconds from the first, accumulated as BeatGridAnalyzer lays them out
+std::shared_ptr<const BeatGrid> rebuild_grid(const EntryHeader& entry) {
+    std::shared_ptr<BeatGrid> grid = std::make_shared<BeatGrid>();
+    grid->bpm = entry.grid_bpm;
+    grid->confidence = entry.confidence;
+    grid->complete = (entry.flags & COMPLETE) != 0;
+    grid->beats.reserve(entry.beat_count);
+    const double period = 60.0 / entry.grid_bpm;
+    double t = entry.first_beat;
+    for (uint32_t i = 0; i < entry.beat_count; ++i, t += period) {
+        grid->beats.push_back(t);
+    }
+    return grid;
+}
+
+size_t padded(size_t bytes) {
+    return (bytes + 7) & ~static_cast<size_t>(7);
+}
+
+} // namespace
+
+constexpr uint32_t CacheSnapshot::MAX_BEATS;
+
+uint32_t CacheSnapshot::formatOf(const AudioTrack& track) {
+    if (dynamic_cast<const MP3Track*>(&track)) return FORMAT_MP3;
+    if (dynamic_cast<const WAVTrack*>(&track)) return FORMAT_WAV;
+    return FORMAT_OTHER;
+}
+
+bool CacheSnapshot::save(const std::string& path, const std::vector<TrackHandle>& tracks) {
+    std::string temp_path = path + ".tmp";
+    std::ofstream out(temp_path.c_str(), std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+    FileHeader header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.count = static_cast<uint32_t>(tracks.size());
+    header.reserved = 0;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    const char zeros[8] = {0};
+    for (const TrackHandle& track : tracks) {
+        const std::string& title = track->get_title();
+        const TrackPayload& payload = *track->get_payload();
+        const BeatGrid* grid = track->get_beat_grid();
+        EntryHeader entry;
+        std::memset(&entry, 0, sizeof(entry));
+        entry.title_length = static_cast<uint32_t>(title.size());
+        entry.format = formatOf(*track);
+        entry.duration = track->get_duration();
+        entry.bpm = track->get_bpm();
+        entry.waveform_seed = payload.waveform_seed;
+        entry.waveform_size = payload.waveform_size;
+        entry.camelot_key = track->get_camelot_key();
+        entry.flags = payload.synthesized ? SYNTHESIZED : 0;
+        // An unfinished grid (the time budget ran out) is left for the next session to redo
+        if (grid && grid->complete && grid->beats.size() <= MAX_BEATS) {
+            entry.grid_bpm = grid->bpm;
+            entry.confidence = grid->confidence;
+            entry.first_beat = grid->beats.empty() ? 0.0 : grid->beats.front();
+            entry.beat_count = static_cast<uint32_t>(grid->beats.size());
+            entry.flags |= ANALYZED | (grid->complete ? COMPLETE : 0);
+        }
+        out.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        out.write(title.data(), title.size());
+        out.write(zeros, padded(title.size()) - title.size());
+    }
+    out.close();
+    if (!out || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+CacheSnapshot::CacheSnapshot(const std::string& path)
+    : mapped(path, sizeof(FileHeader)), parsed() {
+    if (mapped.is_open() && !parse()) {
+        unmap();
+    }
+}
+
+bool CacheSnapshot::parse() {
+    const char* base = static_cast<const char*>(mapped.data());
+    const size_t mapped_size = mapped.size();
+    FileHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) {
+        return false;
+    }
+    size_t offset = sizeof(FileHeader);
+    // Every entry takes at least its header, so a larger count is corrupt; check before reserving
+    if (header.count > (mapped_size - offset) / sizeof(EntryHeader)) {
+        return false;
+    }
+    parsed.reserve(header.count);
+    for (uint32_t i = 0; i < header.count; ++i) {
+        EntryHeader entry;
+        if (mapped_size - offset < sizeof(entry)) {
+            return false;
+        }
+        std::memcpy(&entry, base + offset, sizeof(entry));
+        offset += sizeof(entry);
+        size_t title_bytes = padded(entry.title_length);
+        if (mapped_size - offset < title_bytes) {
+            return false;
+        }
+        const bool analyzed = (entry.flags & ANALYZED) != 0;
+        if (analyzed && (entry.beat_count > MAX_BEATS || (entry.beat_count > 0 && !(entry.grid_bpm > 0.0)))) {
+            return false;
+        }
+        Entry view;
+        view.title.assign(base + offset, entry.title_length);
+        view.format = entry.format;
+        view.duration = entry.duration;
+        view.bpm = entry.bpm;
+        view.waveform_seed = entry.waveform_seed;
+        view.waveform_size = static_cast<size_t>(entry.waveform_size);
+        view.synthesized = (entry.flags & SYNTHESIZED) != 0;
+        if (analyzed && (entry.flags & COMPLETE)) {
+            view.beat_grid = rebuild_grid(entry);
+            view.camelot_key = entry.camelot_key;
+        }
+        offset += title_bytes;
+        parsed.push_back(view);
+    }
+    return true;
+}
+
+void CacheSnapshot::unmap() {
+    mapped.reset();
+    parsed.clear();
+}
@@ -0,0 +1,151 @@
+#include "ConcurrentTrackCache.h"
+#include <algorithm>
+#include <iostream>
+
+constexpr int ConcurrentTrackCache::ALREADY_CACHED;
+
+ConcurrentTrackCache::ConcurrentTrackCache(size_t capacity, size_t shard_count)
+    : shards(), total_capacity(capacity) {
+    // Every shard needs at least one slot, otherwise keys hashing to it could never be cached
+    size_t count = std::max<size_t>(1, std::min(shard_count, capacity));
+    for (size_t i = 0; i < count; ++i) {
+        size_t share = capacity / count + (i < capacity % count ? 1 : 0);
+        shards.push_back(PointerWrapper<Shard>(new Shard(share)));
+    }
+}
+
+ConcurrentTrackCache::Shard& ConcurrentTrackCache::shardFor(TrackId id) const {
+    return *shards[id % shards.size()];
+}
+
+bool ConcurrentTrackCache::contains(TrackId id) const {
+    Shard& shard = shardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.index.count(id) != 0;
+}
+
+TrackHandle ConcurrentTrackCache::get(TrackId id) {
+    Shard& shard = shardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(id);
+    if (it == shard.index.end()) {
+        return TrackHandle();
+    }
+    Entry& entry = shard.ring[it->second];
+    entry.referenced = true;
+    return entry.track;
+}
+
+bool ConcurrentTrackCache::put(PointerWrapper<AudioTrack> track) {
+    return insert(std::move(track), nullptr) == 1;
+}
+
+int ConcurrentTrackCache::tryPut(PointerWrapper<AudioTrack> track) {
+    return insert(std::move(track), nullptr);
+}
+
+bool ConcurrentTrackCache::putUnless(PointerWrapper<AudioTrack> track, const std::vector<TrackId>& keep) {
+    int result = insert(std::move(track), &keep);
+    return result == 0 || result == 1;
+}
+
+int ConcurrentTrackCache::insert(PointerWrapper<AudioTrack> track, const std::vector<TrackId>* keep) {
+    if (!track || track->get_id() == INVALID_TRACK_ID) {
+        return -1;
+    }
+    const TrackId key = track->get_id();
+    Shard& shard = shardFor(key);
+    std::shared_ptr<AudioTrack> owned(track.release());
+    // Whatever we displace is released after the lock is dropped, so a
+    // destructor never runs inside the critical section.
+    std::shared_ptr<AudioTrack> displaced;
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.ring.empty()) {
+        return -1;
+    }
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        if (!keep) {
+            shard.ring[it->second].referenced = true;
+        }
+        displaced = std::move(owned);
+        return ALREADY_CACHED;
+    }
+    size_t pos;
+    int evicted = 0;
+    if (shard.used < shard.ring.size()) {
+        pos = shard.used++;
+    } else {
+        // CLOCK sweep: clear reference bits until an unreferenced entry is found.
+        // Kept entries are passed over; two full turns without a candidate means
+        // every entry is kept.
+        size_t steps = 0;
+        while (shard.ring[shard.hand].referenced ||
+               (keep && std::find(keep->begin(), keep->end(), shard.ring[shard.hand].key) != keep->end())) {
+            shard.ring[shard.hand].referenced = false;
+            shard.hand = (shard.hand + 1) % shard.ring.size();
+            if (++steps > 2 * shard.ring.size()) {
+                displaced = std::move(owned);
+                return -1;
+            }
+        }
+        pos = shard.hand;
+        shard.hand = (shard.hand + 1) % shard.ring.size();
+        shard.index.erase(shard.ring[pos].key);
+        displaced = std::move(shard.ring[pos].track);
+        evicted = 1;
+    }
+    Entry& entry = shard.ring[pos];
+    entry.track = std::move(owned);
+    entry.key = key;
+    entry.referenced = false;
+    shard.index[key] = pos;
+    return evicted;
+}
+
+size_t ConcurrentTrackCache::size() const {
+    size_t total = 0;
+    for (const PointerWrapper<Shard>& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        total += shard->used;
+    }
+    return total;
+}
+
+std::vector<TrackHandle> ConcurrentTrackCache::entries() const {
+    std::vector<TrackHandle> tracks;
+    for (const PointerWrapper<Shard>& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (size_t i = 0; i < shard->used; ++i) {
+            tracks.push_back(shard->ring[i].track);
+        }
+    }
+    return tracks;
+}
+
+void ConcurrentTrackCache::clear() {
+    for (PointerWrapper<Shard>& shard : shards) {
+        std::vector<Entry> released(shard->ring.size());
+        {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            shard->ring.swap(released);
+            shard->index.clear();
+            shard->hand = 0;
+            shard->used = 0;
+        }
+    }
+}
+
+void ConcurrentTrackCache::displayStatus() const {
+    std::cout << "[ConcurrentTrackCache] Status: " << size() << "/" << total_capacity
+              << " slots used in " << shards.size() << " shards\n";
+    for (size_t s = 0; s < shards.size(); ++s) {
+        const Shard& shard = *shards[s];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        std::cout << "  Shard " << s << " (" << shard.used << "/" << shard.ring.size() << "):";
+        for (size_t i = 0; i < shard.used; ++i) {
+            std::cout << " \"" << shard.ring[i].track->get_title() << "\"" << (shard.ring[i].referenced ? "*" : "");
+        }
+        std::cout << "\n";
+    }
+}
@@ -0,0 +1,138 @@
+#include "CrossfadeRenderer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+constexpr size_t CrossfadeRenderer::BLOCK_FRAMES;
+
+namespace {
+
+const double HALF_PI = 1.57079632679489661923;
+
+} // namespace
+
+bool CrossfadeRenderer::parseCurve(const std::string& name, Curve& curve) {
+    if (name == "linear") {
+        curve = LINEAR;
+    } else if (name == "equal_power") {
+        curve = EQUAL_POWER;
+    } else if (name == "s_curve") {
+        curve = S_CURVE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* CrossfadeRenderer::curveName(Curve curve) {
+    switch (curve) {
+        case LINEAR: return "linear";
+        case S_CURVE: return "s_curve";
+        default: return "equal_power";
+    }
+}
+
+void CrossfadeRenderer::gains(Curve curve, double t, double& out_gain, double& in_gain) {
+    t = std::max(0.0, std::min(1.0, t));
+    switch (curve) {
+        case LINEAR:
+            in_gain = t;
+            break;
+        case S_CURVE:
+            in_gain = t * t * (3.0 - 2.0 * t);
+            break;
+        default:
+            out_gain = std::cos(t * HALF_PI);
+            in_gain = std::sin(t * HALF_PI);
+            return;
+    }
+    out_gain = 1.0 - in_gain;
+}
+
+void CrossfadeRenderer::mix(const double* a, double ga0, double ga1, const double* b, double gb0, double gb1,
+                            double* out, size_t n) {
+    if (n == 0) return;
+    const double da = (ga1 - ga0) / n;
+    const double db = (gb1 - gb0) / n;
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128d ga = _mm_set_pd(ga0 + da, ga0);
+    __m128d gb = _mm_set_pd(gb0 + db, gb0);
+    const __m128d step_a = _mm_set1_pd(2.0 * da);
+    const __m128d step_b = _mm_set1_pd(2.0 * db);
+    for (; i + 2 <= n; i += 2) {
+        __m128d sum = _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(a + i), ga), _mm_mul_pd(_mm_loadu_pd(b + i), gb));
+        _mm_storeu_pd(out + i, sum);
+        ga = _mm_add_pd(ga, step_a);
+        gb = _mm_add_pd(gb, step_b);
+    }
+#endif
+    for (; i < n; ++i) {
+        out[i] = a[i] * (ga0 + da * i) + b[i] * (gb0 + db * i);
+    }
+}
+
+void CrossfadeRenderer::mix(const double* const* sources, const double* gain0, const double* gain1, size_t count,
+                            double* out, size_t n) {
+    if (n == 0) return;
+    const double step = 1.0 / n;
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128d t = _mm_set_pd(step, 0.0);
+    const __m128d t_step = _mm_set1_pd(2.0 * step);
+    for (; i + 2 <= n; i += 2) {
+        __m128d sum = _mm_setzero_pd();
+        for (size_t s = 0; s < count; ++s) {
+            const __m128d g0 = _mm_set1_pd(gain0[s]);
+            const __m128d gain = _mm_add_pd(g0, _mm_mul_pd(_mm_sub_pd(_mm_set1_pd(gain1[s]), g0), t));
+            sum = _mm_add_pd(sum, _mm_mul_pd(_mm_loadu_pd(sources[s] + i), gain));
+        }
+        _mm_storeu_pd(out + i, sum);
+        t = _mm_add_pd(t, t_step);
+    }
+#endif
+    for (; i < n; ++i) {
+        double sum = 0.0;
+        for (size_t s = 0; s < count; ++s) {
+            sum += sources[s][i] * (gain0[s] + (gain1[s] - gain0[s]) * (i * step));
+        }
+        out[i] = sum;
+    }
+}
+
+CrossfadeRenderer::CrossfadeRenderer() : fade_curve(EQUAL_POWER), length(0), position(0) {}
+
+void CrossfadeRenderer::start(size_t fade_frames) {
+    length = fade_frames;
+    position = 0;
+}
+
+size_t CrossfadeRenderer::advance(size_t frames, double& out0, double& in0, double& out1, double& in1) {
+    size_t n = std::min(BLOCK_FRAMES, frames);
+    if (!active()) {
+        out0 = out1 = 0.0;
+        in0 = in1 = 1.0;
+        return n;
+    }
+    n = std::min(n, length - position);
+    gains(fade_curve, static_cast<double>(position) / length, out0, in0);
+    gains(fade_curve, static_cast<double>(position + n) / length, out1, in1);
+    position += n;
+    return n;
+}
+
+void CrossfadeRenderer::render(const double* outgoing, const double* incoming, double* out, size_t frames) {
+    size_t done = 0;
+    while (done < frames && active()) {
+        double out0, in0, out1, in1;
+        const size_t n = advance(frames - done, out0, in0, out1, in1);
+        mix(outgoing + done, out0, out1, incoming + done, in0, in1, out + done, n);
+        done += n;
+    }
+    if (done < frames && out + done != incoming + done) {
+        std::memmove(out + done, incoming + done, (frames - done) * sizeof(double));
+    }
+}
@@ -1,45 +1,284 @@
 #include "DJControllerService.h"
+#include "CacheSnapshot.h"
 #include "MP3Track.h"
 #include "WAVTrack.h"
 #include <iostream>
+#include <cmath>
 #include <memory>
+#include <unordered_map>
 
 DJControllerService::DJControllerService(size_t cache_size)
-    : cache(cache_size) {}
+    : cache(cache_size), sharded(), oversized(), prefetched(), shadows(), cache_mutex(), shadow_mutex(),
+      prefetch_mutex() {
+    resetShadows();
+}
 /**
  * TODO: Implement loadTrackToCache method
  */
 int DJControllerService::loadTrackToCache(AudioTrack& track) {
-    bool found = cache.contains(track.get_title());
-    if(found){
-        cache.get(track.get_title());
-        return 1;
+    const TrackId id = track.get_id();
+    if (id != INVALID_TRACK_ID) {
+        std::lock_guard<std::mutex> lock(shadow_mutex);
+        // Weighed as the cache weighs its clone: a playlist track is already loaded
+        const size_t weight = !shadows.empty() && shadows.front().byteBudget() ? track.get_memory_footprint() : 0;
+        for (ShadowCache& shadow : shadows) {
+            shadow.access(id, weight);
+        }
     }
-    else{
-        PointerWrapper<AudioTrack> clone = track.clone();
-        if (!clone.get()){
-            std::cout << "[ERROR] Track: \"" << track.get_title() << "\" failed to clone" << std::endl;
-            return 0;
+    int result = acquireTrack(track) ? 1 : cacheClone(track);
+    // Checked only once the outcome is known: a prefetch marks its track before the
+    // entry becomes visible, so a HIT on it always finds the mark; a MISS clears a
+    // mark left by a prefetched entry that was evicted before it was requested.
+    bool was_prefetched = false;
+    if (id != INVALID_TRACK_ID) {
+        std::lock_guard<std::mutex> lock(prefetch_mutex);
+        if (id < prefetched.size() && prefetched[id]) {
+            prefetched[id] = false;
+            was_prefetched = true;
+        }
+    }
+    return result == 1 && was_prefetched ? 2 : result;
+}
+
+int DJControllerService::cacheClone(AudioTrack& track) {
+    const std::string& key = track.get_title();
+    PointerWrapper<AudioTrack> clone = track.clone();
+    if (!clone){
+        std::cout << "[ERROR] Track: \"" << key << "\" failed to clone" << std::endl;
+        return 0;
+    }
+    clone->load();
+    clone->analyze_beatgrid();
+    bool evicted;
+    if (sharded) {
+        // One shard-locked step, so a racing insert of the same title is seen here
+        int stored = sharded->tryPut(std::move(clone));
+        if (stored == ConcurrentTrackCache::ALREADY_CACHED) {
+            return 1;
         }
-        clone->load();
-        clone->analyze_beatgrid();
-        bool evicted = cache.put(std::move(clone));
-        if(evicted){
-            return -1;
+        evicted = stored == 1;
+    } else {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        if (acquireLocked(track)) {
+            return 1;
         }
-        else{
+        if (!cache.admits(*clone)) {
+            std::cout << "[Cache] \"" << key << "\" (" << clone->get_memory_footprint()
+                      << " bytes) exceeds the " << cache.byte_budget() << " byte budget; bypassing cache" << std::endl;
+            oversized = TrackHandle(clone.release());
             return 0;
         }
+        evicted = cache.put(std::move(clone));
+    }
+    if(evicted){
+        return -1;
+    }
+    else{
+        return 0;
     }
 }
 
+bool DJControllerService::prefetchTrackToCache(AudioTrack& track, const std::vector<TrackId>& keep,
+                                               std::ostream& log) {
+    const TrackId id = track.get_id();
+    if (id == INVALID_TRACK_ID) {
+        return false;   // Only library tracks are prefetched; their marks are indexed by ID
+    }
+    bool cached;
+    if (sharded) {
+        cached = sharded->contains(id);
+    } else {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        cached = cache.contains(id);
+    }
+    if (cached) {
+        return false;
+    }
+    PointerWrapper<AudioTrack> clone = track.clone();
+    if (!clone) {
+        return false;
+    }
+    clone->load(log);
+    clone->analyze_beatgrid(log);
+    {
+        std::lock_guard<std::mutex> lock(prefetch_mutex);
+        if (id >= prefetched.size()) {
+            prefetched.resize(id + 1, false);
+        }
+        prefetched[id] = true;
+    }
+    bool stored;
+    if (sharded) {
+        stored = sharded->putUnless(std::move(clone), keep);
+    } else {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        stored = cache.putUnless(std::move(clone), keep);
+    }
+    log << "[Prefetch] \"" << track.get_title() << "\" " << (stored ? "warmed" : "skipped (no room)") << std::endl;
+    if (!stored) {
+        std::lock_guard<std::mutex> lock(prefetch_mutex);
+        prefetched[id] = false;
+    }
+    return stored;
+}
+
+bool DJControllerService::saveCacheSnapshot(const std::string& path) const {
+    std::vector<TrackHandle> tracks;
+    if (sharded) {
+        tracks = sharded->entries();
+    } else {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        tracks = cache.entries();
+    }
+    if (!CacheSnapshot::save(path, tracks)) {
+        std::cout << "[ERROR] Failed to write cache snapshot: " << path << std::endl;
+        return false;
+    }
+    std::cout << "[Snapshot] Saved " << tracks.size() << " cached tracks to " << path << std::endl;
+    return true;
+}
+
+size_t DJControllerService::restoreCacheSnapshot(const std::string& path, const std::vector<AudioTrack*>& library) {
+    CacheSnapshot snapshot(path);
+    if (!snapshot.is_open()) {
+        return 0;
+    }
+    std::unordered_map<std::string, const AudioTrack*> by_title;
+    for (const AudioTrack* track : library) {
+        by_title[track->get_title()] = track;
+    }
+    size_t restored = 0;
+    size_t stale = 0;
+    for (const CacheSnapshot::Entry& entry : snapshot.entries()) {
+        auto it = by_title.find(entry.title);
+        const AudioTrack* source = it == by_title.end() ? nullptr : it->second;
+        // Same seed and length: the library track synthesizes the audio the entry was analyzed from
+        if (!source || CacheSnapshot::formatOf(*source) != entry.format ||
+            source->get_duration() != entry.duration || source->get_bpm() != entry.bpm ||
+            source->get_waveform_size() != entry.waveform_size || !entry.synthesized ||
+            !source->get_payload()->synthesized || source->get_payload()->waveform_seed != entry.waveform_seed) {
+            stale++;
+            continue;
+        }
+        PointerWrapper<AudioTrack> clone = source->clone();
+        if (!clone) {
+            stale++;
+            continue;
+        }
+        if (entry.beat_grid) {
+            clone->set_analysis(entry.beat_grid, entry.camelot_key);
+        }
+        if (sharded) {
+            sharded->put(std::move(clone));
+        } else {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            if (!cache.admits(*clone)) {
+                stale++;
+                continue;
+            }
+            cache.put(std::move(clone));
+        }
+        restored++;
+    }
+    std::cout << "[Snapshot] Restored " << restored << " cached tracks from " << path
+              << " (" << stale << " stale dropped)" << std::endl;
+    return restored;
+}
+
+TrackHandle DJControllerService::acquireLocked(const AudioTrack& track) {
+    TrackId id = track.get_id();
+    if (oversized && (id != INVALID_TRACK_ID ? oversized->get_id() == id
+                                             : oversized->get_title() == track.get_title())) {
+        return oversized;
+    }
+    return id != INVALID_TRACK_ID ? cache.acquire(id) : cache.acquire(track.get_title());
+}
+
 void DJControllerService::set_cache_size(size_t new_size) {
-    cache.set_capacity(new_size);
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        cache.set_capacity(new_size);
+        if (sharded) {
+            sharded.reset(new ConcurrentTrackCache(new_size, sharded->shard_count()));
+        }
+    }
+    resetShadows();
+}
+
+void DJControllerService::set_cache_bytes(size_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        cache.set_byte_budget(bytes);
+    }
+    resetShadows();
+}
+
+bool DJControllerService::set_cache_policy(const std::string& policy_name) {
+    PointerWrapper<CachePolicy> policy = CachePolicy::create(policy_name);
+    if (!policy) {
+        return false;
+    }
+    // LRU is the cache's built-in recency order; no strategy object is needed
+    if (policy->name() == "LRU") {
+        policy.reset();
+    }
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    cache.set_policy(std::move(policy));
+    return true;
+}
+
+std::string DJControllerService::getCachePolicyName() const {
+    if (sharded) {
+        return "CLOCK";
+    }
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    return cache.policy_name();
+}
+
+void DJControllerService::set_cache_shards(size_t shards) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    if (shards <= 1) {
+        sharded.reset();
+    } else {
+        sharded.reset(new ConcurrentTrackCache(cache.capacity(), shards));
+    }
+}
+
+size_t DJControllerService::getCacheShardCount() const {
+    return sharded ? sharded->shard_count() : 1;
+}
+
+void DJControllerService::resetShadows() {
+    std::lock_guard<std::mutex> lock(shadow_mutex);
+    shadows.clear();
+    for (const std::string& name : CachePolicy::names()) {
+        shadows.emplace_back(CachePolicy::create(name), cache.capacity(), cache.byte_budget());
+    }
+}
+
+void DJControllerService::displayPolicyHitRatios() const {
+    std::string active = getCachePolicyName();
+    std::lock_guard<std::mutex> lock(shadow_mutex);
+    std::cout << "Policy hit ratios (" << cache.capacity() << " slots";
+    if (cache.byte_budget()) {
+        std::cout << ", " << cache.byte_budget() << " bytes";
+    }
+    std::cout << "):" << std::endl;
+    for (const ShadowCache& shadow : shadows) {
+        std::cout << "  " << shadow.policyName() << ": " << std::round(shadow.hitRatio() * 1000.0) / 10.0 << "% ("
+                  << shadow.hits() << "/" << shadow.hits() + shadow.misses() << ")"
+                  << (shadow.policyName() == active ? " <- active" : "") << std::endl;
+    }
 }
 //implemented
 void DJControllerService::displayCacheStatus() const {
     std::cout << "\n=== Cache Status ===\n";
-    cache.displayStatus();
+    if (sharded) {
+        sharded->displayStatus();
+    } else {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        cache.displayStatus();
+    }
     std::cout << "====================\n";
 }
 
@@ -47,5 +286,38 @@ void DJControllerService::displayCacheStatus() const {
  * TODO: Implement getTrackFromCache method
  */
 AudioTrack* DJControllerService::getTrackFromCache(const std::string& track_title) {
+    if (sharded) {
+        // Another thread may evict the track as soon as get() returns; only a handle is safe
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    if (oversized && oversized->get_title() == track_title) {
+        return const_cast<AudioTrack*>(oversized.get());
+    }
     return cache.get(track_title);
 }
+
+TrackHandle DJControllerService::acquireTrack(const std::string& track_title) {
+    if (sharded) {
+        // The shards are keyed by ID: resolve the title by scanning (UI lookups only)
+        for (const TrackHandle& entry : sharded->entries()) {
+            if (entry->get_title() == track_title) {
+                return sharded->get(entry->get_id());
+            }
+        }
+        return TrackHandle();
+    }
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    if (oversized && oversized->get_title() == track_title) {
+        return oversized;
+    }
+    return cache.acquire(track_title);
+}
+
+TrackHandle DJControllerService::acquireTrack(const AudioTrack& track) {
+    if (sharded) {
+        return sharded->get(track.get_id());
+    }
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    return acquireLocked(track);
+}
@@ -5,10 +5,12 @@
 #include <iostream>
 #include <memory>
 #include <filesystem>
+#include <algorithm>
+#include <cstdlib>
 
 //constructor
 DJLibraryService::DJLibraryService(const Playlist& playlist) 
-    : playlist(playlist), library() {}
+    : playlist(playlist), library(), registry(), table() {}
 
 //destructor
 DJLibraryService::~DJLibraryService(){
@@ -19,13 +21,16 @@ DJLibraryService::~DJLibraryService(){
 }
 
 // copy constructor
-DJLibraryService::DJLibraryService(const DJLibraryService& other): playlist(other.playlist),library(other.library){
+DJLibraryService::DJLibraryService(const DJLibraryService& other): playlist(other.playlist),library(other.library),
+    registry(other.registry), table(other.table){
 }
 //copy assigment operator
 DJLibraryService& DJLibraryService::operator=(const DJLibraryService& other) {
     if (this != &other){
         playlist = other.playlist;
         library = other.library;
+        registry = other.registry;
+        table = other.table;
     }
     return *this;
 }
@@ -38,13 +43,17 @@ void DJLibraryService::buildLibrary(const std::vector<SessionConfig::TrackInfo>&
         std::string type = library_tracks[i].type;
         if(type == "MP3"){
             library.push_back(new MP3Track(library_tracks[i].title,library_tracks[i].artists, 
-                library_tracks[i].duration_seconds, library_tracks[i].bpm, library_tracks[i].extra_param1, library_tracks[i].extra_param2));
+                library_tracks[i].duration_seconds, library_tracks[i].bpm, library_tracks[i].extra_param1, library_tracks[i].extra_param2,
+                library_tracks[i].file_path));
         }
         else{
             library.push_back(new WAVTrack(library_tracks[i].title,library_tracks[i].artists, 
-                library_tracks[i].duration_seconds, library_tracks[i].bpm, library_tracks[i].extra_param1, library_tracks[i].extra_param2));
+                library_tracks[i].duration_seconds, library_tracks[i].bpm, library_tracks[i].extra_param1, library_tracks[i].extra_param2,
+                library_tracks[i].file_path));
         }
+        library.back()->set_id(registry.intern(library_tracks[i].title));
     }
+    table.build(library);
     std::cout << "[INFO] Track library built: " << library_tracks.size() << " tracks loaded" << std::endl;
 }
 
@@ -81,14 +90,32 @@ Playlist& DJLibraryService::getPlaylist() {
  * 
  * HINT: Leverage Playlist's find_track method
  */
+std::vector<const AudioTrack*> DJLibraryService::findMixCandidates(int bpm, int tolerance) const {
+    std::vector<uint32_t> rows = table.nearBpm(bpm, tolerance);
+    std::stable_sort(rows.begin(), rows.end(), [this, bpm](uint32_t a, uint32_t b) {
+        return std::abs(table.bpm(a) - bpm) < std::abs(table.bpm(b) - bpm);
+    });
+    std::vector<const AudioTrack*> candidates;
+    candidates.reserve(rows.size());
+    for (uint32_t row : rows) {
+        candidates.push_back(library[row]);
+    }
+    return candidates;
+}
+
 AudioTrack* DJLibraryService::findTrack(const std::string& track_title) {
     return playlist.find_track(track_title);
 }
 
+AudioTrack* DJLibraryService::findTrack(TrackId track_id) {
+    return playlist.find_track(track_id);
+}
+
 void DJLibraryService::loadPlaylistFromIndices(const std::string& playlist_name, 
                                                 const std::vector<int>& track_indices) {
     std::cout << "[INFO] Loading playlist: " << playlist_name << std::endl;
     playlist = Playlist(playlist_name);
+    playlist.reserve_ids(registry.size());
     for (int index : track_indices){
         if ((index-1) < 0 || (index-1) >= (int)library.size()){
             std::cout << "[WARNING] Invalid track index: " << index << std::endl;
@@ -117,3 +144,12 @@ std::vector<std::string> DJLibraryService::getTrackTitles() const {
     }
     return tracks_titles;
 }
+
+std::vector<TrackId> DJLibraryService::getTrackIds() const {
+    std::vector<TrackId> track_ids;
+    track_ids.reserve(playlist.get_track_count());
+    for (AudioTrack* track : playlist.getTracks()){
+        track_ids.push_back(track->get_id());
+    }
+    return track_ids;
+}
@@ -1,7 +1,10 @@
 #include "DJSession.h"
+#include "AnalysisCache.h"
 #include <iostream>
 #include <algorithm>
 #include <sstream>
+#include <cmath>
+#include <cstdlib>
 #include <dirent.h>
 
 // ========== CONSTRUCTORS & RULE OF 5 ==========
@@ -12,10 +15,12 @@ DJSession::DJSession(const std::string& name, bool play_all)
     library_service(),
     controller_service(),
     mixing_service(),
+    prefetcher(controller_service),
     config_manager(),
     session_config(),
-    track_titles(),
+    track_ids(),
     play_all(play_all),
+    mixdown_only(false),
     stats()
       {
     std::cout << "DJ Session System initialized: " << session_name << std::endl;
@@ -23,6 +28,10 @@ DJSession::DJSession(const std::string& name, bool play_all)
 
 // destructor
 DJSession::~DJSession() {
+    if (!session_config.controller_cache_snapshot.empty() && !mixdown_only) {
+        prefetcher.cancel();
+        controller_service.saveCacheSnapshot(session_config.controller_cache_snapshot);
+    }
     std::cout << "Shutting down DJ Session System: " << session_name << std::endl;
 }
 
@@ -44,7 +53,7 @@ bool DJSession::load_playlist(const std::string& playlist_name)  {
         return false;
     }
     
-    track_titles = library_service.getTrackTitles();
+    track_ids = library_service.getTrackIds();
     return true;
 }
 
@@ -63,25 +72,30 @@ bool DJSession::load_playlist(const std::string& playlist_name)  {
  * 
  * 3. Return Values
  *    1: Cache HIT
+ *    2: Cache HIT on a prefetched track
  *    0: Cache MISS (or error)
  *   -1: Cache MISS with eviction
  * 
- * @param track_name: Name of track to load
+ * @param track_id: Interned ID of track to load
  * @return: Cache operation result code
 
  */
-int DJSession::load_track_to_controller(const std::string& track_name) {
-    AudioTrack* track = library_service.findTrack(track_name);
+int DJSession::load_track_to_controller(TrackId track_id) {
+    AudioTrack* track = library_service.findTrack(track_id);
     if(!track){
-        std::cout<< "[ERROR] Track: \"" << track_name << "\" not found in library" << std::endl;
+        std::cout<< "[ERROR] Track: \"" << library_service.getTrackTitle(track_id) << "\" not found in library" << std::endl;
         stats.errors++;
         return 0;
     }
-    std::cout<< "[System] Loading track \'" << track_name << "\' to controller..." << std::endl;
+    std::cout<< "[System] Loading track \'" << track->get_title() << "\' to controller..." << std::endl;
     int res = controller_service.loadTrackToCache(*track);
     if(res == 1){
         stats.cache_hits++;
     }
+    else if(res == 2){
+        stats.cache_hits++;
+        stats.prefetch_hits++;
+    }
     else if(res == 0){
         stats.cache_misses++;
     }
@@ -95,24 +109,34 @@ int DJSession::load_track_to_controller(const std::string& track_name) {
 /**
  * TODO: Implement load_track_to_mixer_deck method
  * 
- * @param track_title: Title of track to load to mixer
+ * @param track_id: Interned ID of track to load to mixer
  * @return: Whether track was successfully loaded to a deck
  */
-bool DJSession::load_track_to_mixer_deck(const std::string& track_title) {
+bool DJSession::load_track_to_mixer_deck(TrackId track_id) {
+    const std::string& track_title = library_service.getTrackTitle(track_id);
     std::cout << "[System] Delegating track transfer to MixingEngineService for: " << track_title << std::endl;
-    AudioTrack* track = controller_service.getTrackFromCache(track_title);
+    AudioTrack* source = library_service.findTrack(track_id);
+    TrackHandle track = source ? controller_service.acquireTrack(*source) : TrackHandle();
     if(!track){
         std::cout<< "[ERROR] Track: \"" << track_title << "\" not found in cache" << std::endl;
         stats.errors++;
         return false;
     }
-    int res = mixing_service.loadTrackToDeck(*track);
-    if(res == 0){
-        stats.deck_loads_a++;
-        stats.transitions++;
+    if (!session_config.auto_sync) {
+        suggest_mix_candidates(*track);
     }
-    else if(res == 1){
-        stats.deck_loads_b++;
+    // Cheapest legal path: play the pinned cache entry in place unless the deck needs
+    // its own copy (a track auto_sync will retune); then clone
+    bool borrowed = mixing_service.can_borrow(*track);
+    int res = borrowed ? mixing_service.loadTrackToDeck(track) : mixing_service.loadTrackToDeck(*track);
+    if(res >= 0){
+        if (borrowed) {
+            stats.borrowed_loads++;
+        }
+        if (static_cast<size_t>(res) >= stats.deck_loads.size()) {
+            stats.deck_loads.resize(res + 1, 0);
+        }
+        stats.deck_loads[res]++;
         stats.transitions++;
     }
     else{
@@ -140,6 +164,10 @@ void DJSession::simulate_dj_performance() {
     
     // 2. Build track library from config
     library_service.buildLibrary(session_config.library_tracks);
+    if (!session_config.controller_cache_snapshot.empty()) {
+        controller_service.restoreCacheSnapshot(session_config.controller_cache_snapshot,
+                                                library_service.getLibrary());
+    }
     
     // 3. Get available playlists from config
     if (session_config.playlists.empty()) {
@@ -149,7 +177,8 @@ void DJSession::simulate_dj_performance() {
     std::cout << "\nStarting DJ performance simulation..." << std::endl;
     std::cout << "BPM Tolerance: " << session_config.bpm_tolerance << " BPM" << std::endl;
     std::cout << "Auto Sync: " << (session_config.auto_sync ? "enabled" : "disabled") << std::endl;
-    std::cout << "Cache Capacity: " << session_config.controller_cache_size << " slots (LRU policy)" << std::endl;
+    std::cout << "Cache Capacity: " << session_config.controller_cache_size << " slots ("
+              << controller_service.getCachePolicyName() << " policy)" << std::endl;
     std::cout << "\n--- Processing Tracks ---" << std::endl;
 
     if(play_all){
@@ -175,6 +204,43 @@ void DJSession::simulate_dj_performance() {
 }
 
 
+bool DJSession::render_mixdown(const std::string& playlist_name, const std::string& output_path) {
+    std::cout << "=== DJ Mixdown ===" << std::endl;
+    mixdown_only = true;
+    if (!load_configuration()) {
+        std::cerr << "[ERROR] Failed to load configuration. Aborting mixdown." << std::endl;
+        return false;
+    }
+    library_service.buildLibrary(session_config.library_tracks);
+
+    CrossfadeRenderer::Curve curve = CrossfadeRenderer::EQUAL_POWER;
+    CrossfadeRenderer::parseCurve(session_config.crossfade_curve, curve);
+    MixdownRenderer mixdown(static_cast<unsigned>(std::max(1, session_config.mixdown_sample_rate)),
+                            session_config.default_crossfade_time, curve,
+                            static_cast<size_t>(std::max(0, session_config.mixdown_threads)));
+    start_playlist(playlist_name, &mixdown);
+    if (mixdown.track_count() == 0) {
+        std::cerr << "[ERROR] Nothing to render for playlist '" << playlist_name << "'" << std::endl;
+        return false;
+    }
+
+    std::cout << "\n[Mixdown] Rendering " << mixdown.track_count() << " tracks ("
+              << mixdown.track_count() - 1 << " crossfades of " << session_config.default_crossfade_time << " s, "
+              << CrossfadeRenderer::curveName(curve) << ") at " << mixdown.sample_rate() << " Hz on "
+              << mixdown.thread_count() << " threads -> " << output_path << std::endl;
+    if (!mixdown.render(output_path)) {
+        std::cerr << "[ERROR] Could not write mixdown to " << output_path << std::endl;
+        return false;
+    }
+    const double seconds = static_cast<double>(mixdown.frames()) / mixdown.sample_rate();
+    std::cout << "[Mixdown] Wrote " << mixdown.frames() << " frames (" << seconds << " s) in "
+              << mixdown.render_ms() << " ms ("
+              << (mixdown.render_ms() > 0.0 ? seconds * 1000.0 / mixdown.render_ms() : 0.0)
+              << "x real time); file writes took " << mixdown.write_ms() << " ms in "
+              << mixdown.write_blocks() << " blocks" << std::endl;
+    return true;
+}
+
 /* 
  * Helper method to load session configuration from file
  * 
@@ -196,8 +262,74 @@ bool DJSession::load_configuration() {
     std::cout << "Cache Size: " << session_config.controller_cache_size << " slots" << std::endl;
     mixing_service.set_auto_sync(session_config.auto_sync);
     mixing_service.set_bpm_tolerance(session_config.bpm_tolerance);
+    CrossfadeRenderer::Curve curve = CrossfadeRenderer::EQUAL_POWER;
+    if (!CrossfadeRenderer::parseCurve(session_config.crossfade_curve, curve)) {
+        std::cout << "[WARNING] Unknown crossfade curve '" << session_config.crossfade_curve
+                  << "', using equal_power" << std::endl;
+    }
+    mixing_service.set_crossfade(session_config.default_crossfade_time, curve);
+    if (session_config.deck_count < 1) {
+        std::cout << "[WARNING] Invalid deck count " << session_config.deck_count << ", using 2" << std::endl;
+        session_config.deck_count = 2;
+    }
+    mixing_service.set_deck_count(session_config.deck_count);
+    stats.deck_loads.assign(mixing_service.get_deck_count(), 0);
+    if (!mixing_service.set_deck_policy(session_config.deck_policy)) {
+        std::cout << "[WARNING] Unknown deck policy '" << session_config.deck_policy
+                  << "', using " << mixing_service.get_deck_policy() << std::endl;
+    }
+    if (mixing_service.get_deck_count() != 2 || mixing_service.get_deck_policy() != "round_robin") {
+        std::cout << "Decks: " << mixing_service.get_deck_count() << " (" << mixing_service.get_deck_policy()
+                  << ")" << std::endl;
+    }
+    if (session_config.deck_streaming) {
+        mixing_service.set_streaming(true);
+        std::cout << "Deck Streaming: enabled (crossfade " << session_config.default_crossfade_time << " s, "
+                  << CrossfadeRenderer::curveName(curve) << ")" << std::endl;
+    }
+    if (session_config.realtime_mixer) {
+        const size_t frames = static_cast<size_t>(std::max(1, session_config.mixer_callback_frames));
+        const double rate = std::max(1, session_config.mixdown_sample_rate);
+        if (!session_config.deck_streaming) {
+            std::cout << "[WARNING] realtime_mixer needs deck_streaming=true; mixing on the main thread" << std::endl;
+        } else if (mixing_service.start_mixer_thread(rate, frames)) {
+            std::cout << "Mixer Thread: " << frames << " frames per callback at " << rate << " Hz" << std::endl;
+        }
+    }
     //update cache size in LRUCache
     controller_service.set_cache_size(session_config.controller_cache_size);
+    if (session_config.controller_cache_bytes > 0) {
+        controller_service.set_cache_bytes(session_config.controller_cache_bytes);
+        std::cout << "Cache Budget: " << session_config.controller_cache_bytes << " bytes" << std::endl;
+    }
+    // Per-file analysis data (MP3 seek tables) is kept beside the snapshot
+    const std::string& snapshot = session_config.controller_cache_snapshot;
+    const size_t slash = snapshot.find_last_of("/\\");
+    AnalysisCache::shared().setStoreDirectory(
+        snapshot.empty() ? "" : slash == std::string::npos ? "." : snapshot.substr(0, slash));
+    if (session_config.controller_cache_shards > 1) {
+        controller_service.set_cache_shards(session_config.controller_cache_shards);
+        std::cout << "Cache Shards: " << controller_service.getCacheShardCount() << std::endl;
+    }
+    if (!controller_service.set_cache_policy(session_config.controller_cache_policy)) {
+        std::cout << "[WARNING] Unknown cache policy '" << session_config.controller_cache_policy
+                  << "', using " << controller_service.getCachePolicyName() << std::endl;
+    } else if (controller_service.getCacheShardCount() > 1 && session_config.controller_cache_policy != "LRU") {
+        std::cout << "[WARNING] controller_cache_policy is ignored by the sharded cache (CLOCK)" << std::endl;
+    }
+    if (session_config.prefetch_lookahead > 0) {
+        prefetcher.set_lookahead(session_config.prefetch_lookahead, session_config.controller_cache_size);
+        std::cout << "Prefetch Lookahead: " << prefetcher.get_lookahead() << " tracks" << std::endl;
+    }
+    // Must be set before the library is built: tracks take the default format at creation
+    WaveformBuffer::Format format = WaveformBuffer::FLOAT64;
+    if (!WaveformBuffer::parseFormat(session_config.waveform_format, format)) {
+        std::cout << "[WARNING] Unknown waveform format '" << session_config.waveform_format
+                  << "', using float64" << std::endl;
+    } else if (format != WaveformBuffer::FLOAT64) {
+        std::cout << "Waveform Format: " << WaveformBuffer::formatName(format) << std::endl;
+    }
+    WaveformBuffer::setDefaultFormat(format);
     return true;
 }
 
@@ -255,28 +387,96 @@ void DJSession::print_session_summary() const {
     std::cout << "Cache hits: " << stats.cache_hits << std::endl;
     std::cout << "Cache misses: " << stats.cache_misses << std::endl;
     std::cout << "Cache evictions: " << stats.cache_evictions << std::endl;
-    std::cout << "Deck A loads: " << stats.deck_loads_a << std::endl;
-    std::cout << "Deck B loads: " << stats.deck_loads_b << std::endl;
-    std::cout << "Transitions: " << stats.transitions << std::endl;
+    if (prefetcher.enabled()) {
+        std::cout << "Demand hits: " << stats.cache_hits - stats.prefetch_hits << std::endl;
+        std::cout << "Prefetch hits: " << stats.prefetch_hits << " (warmed " << prefetcher.get_warmed()
+                  << ", skipped " << prefetcher.get_skipped() << ")" << std::endl;
+    }
+    size_t cache_requests = stats.cache_hits + stats.cache_misses;
+    std::cout << "Cache hit ratio: "
+              << (cache_requests ? std::round(1000.0 * stats.cache_hits / cache_requests) / 10.0 : 0.0) << "% ("
+              << controller_service.getCachePolicyName() << ")" << std::endl;
+    controller_service.displayPolicyHitRatios();
+    std::cout << "Beat-grid analyses: " << AnalysisCache::shared().analysesRun() << " run, "
+              << AnalysisCache::shared().analysesSkipped() << " reused" << std::endl;
+    for (size_t i = 0; i < stats.deck_loads.size(); ++i) {
+        std::cout << "Deck ";
+        if (i < 26) {
+            std::cout << static_cast<char>('A' + i);
+        } else {
+            std::cout << i;
+        }
+        std::cout << " loads: " << stats.deck_loads[i] << std::endl;
+    }
+    std::cout << "Transitions: " << stats.transitions << " (" << stats.borrowed_loads
+              << " played from the cache without a copy)" << std::endl;
+    if (const MixerThread* mixer = mixing_service.get_mixer_thread()) {
+        std::cout << "Mixer thread: " << mixer->callbacks() << " callbacks, " << mixer->commands_applied()
+                  << " commands, " << mixer->underruns() << " underruns, " << mixer->late_callbacks()
+                  << " late (longest " << mixer->longest_callback_us() << " us)" << std::endl;
+    }
     std::cout << "Errors: " << stats.errors << std::endl;
     std::cout << "=== Session Complete ===" << std::endl;
 }
 
-void DJSession::start_playlist(std::string playlist_name){
+void DJSession::suggest_mix_candidates(const AudioTrack& incoming) const {
+    const AudioTrack* playing = mixing_service.get_deck_track(mixing_service.get_active_deck());
+    const int tolerance = session_config.bpm_tolerance;
+    if (!playing || playing->get_id() == incoming.get_id() ||
+        std::abs(playing->get_bpm() - incoming.get_bpm()) <= tolerance) {
+        return;
+    }
+    const size_t shown_max = 3;
+    size_t shown = 0;
+    std::cout << "[Mix Candidates] '" << incoming.get_title() << "' (" << incoming.get_bpm()
+              << " BPM) is off the playing " << playing->get_bpm() << " BPM; library tracks within "
+              << tolerance << " BPM:";
+    for (const AudioTrack* candidate : library_service.findMixCandidates(playing->get_bpm(), tolerance)) {
+        if (candidate->get_id() == playing->get_id()) {
+            continue;
+        }
+        if (shown == shown_max) {
+            std::cout << " ...";
+            break;
+        }
+        std::cout << (shown ? ", '" : " '") << candidate->get_title() << "'";
+        ++shown;
+    }
+    std::cout << (shown ? "" : " none") << std::endl;
+}
+
+void DJSession::start_playlist(std::string playlist_name, MixdownRenderer* mixdown){
     if(!load_playlist(playlist_name)){
             std::cout<< "[ERROR] playlist: \"" << playlist_name << "\" failed to load to playlist" << std::endl;
             return;
         }
-        std::reverse(track_titles.begin(), track_titles.end());
-        for(std::string track_title: track_titles){
-            std::cout << "\n--- Processing: " << track_title << " ---" << std::endl;
+        std::reverse(track_ids.begin(), track_ids.end());
+        // Resolve upcoming tracks once; the prefetch worker only reads them
+        std::vector<AudioTrack*> upcoming;
+        if (prefetcher.enabled()) {
+            for (TrackId track_id : track_ids) {
+                upcoming.push_back(library_service.findTrack(track_id));
+            }
+        }
+        for(size_t i = 0; i < track_ids.size(); ++i){
+            TrackId track_id = track_ids[i];
+            prefetcher.flush_log();
+            std::cout << "\n--- Processing: " << library_service.getTrackTitle(track_id) << " ---" << std::endl;
             stats.tracks_processed++;
-            load_track_to_controller(track_title);
+            load_track_to_controller(track_id);
+            prefetcher.schedule(upcoming, i);
             controller_service.displayCacheStatus();
-            if (!load_track_to_mixer_deck(track_title)){
+            if (!load_track_to_mixer_deck(track_id)){
                 continue;
             }
+            if (mixdown) {
+                size_t deck = mixing_service.get_active_deck();
+                mixdown->add_track(mixing_service.get_deck_track(deck)->clone(), mixing_service.get_deck_tempo(deck));
+            }
             mixing_service.displayDeckStatus();
         }
+        // The next playlist replaces the tracks the worker reads from
+        prefetcher.cancel();
+        prefetcher.flush_log();
         print_session_summary();
 }
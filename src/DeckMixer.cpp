@@ -0,0 +1,145 @@
+#include "DeckMixer.h"
+#include <algorithm>
+#include <utility>
+
+DeckMixer::Command DeckMixer::Command::load(size_t deck, PointerWrapper<StreamingDecoder> stream, size_t fade_frames) {
+    Command command;
+    command.type = LOAD;
+    command.deck = deck;
+    command.stream = std::move(stream);
+    command.fade_frames = fade_frames;
+    return command;
+}
+
+DeckMixer::Command DeckMixer::Command::crossfader(CrossfadeRenderer::Curve curve) {
+    Command command;
+    command.type = SET_CROSSFADER;
+    command.curve = curve;
+    return command;
+}
+
+DeckMixer::Command DeckMixer::Command::sync(size_t deck, PointerWrapper<StreamingDecoder> stream, uint64_t position,
+                                            double skip_ratio) {
+    Command command;
+    command.type = SYNC;
+    command.deck = deck;
+    command.stream = std::move(stream);
+    command.position = position;
+    command.skip_ratio = skip_ratio;
+    return command;
+}
+
+DeckMixer::Command DeckMixer::Command::unload(size_t deck) {
+    Command command;
+    command.type = UNLOAD;
+    command.deck = deck;
+    return command;
+}
+
+DeckMixer::DeckMixer(size_t count)
+    : decks(), active_deck(0), crossfader(), deck_blocks(), sources(), gain_start(), gain_end() {
+    set_deck_count(count);
+}
+
+void DeckMixer::set_deck_count(size_t count) {
+    count = std::max<size_t>(1, count);
+    decks.clear();
+    decks.resize(count);
+    active_deck = 0;
+    crossfader.start(0);
+    deck_blocks.assign(count * CrossfadeRenderer::BLOCK_FRAMES, 0.0);
+    sources.assign(count, nullptr);
+    gain_start.assign(count, 0.0);
+    gain_end.assign(count, 0.0);
+}
+
+// Gain the deck is playing at right now
+double DeckMixer::gain(size_t deck) const {
+    if (!crossfader.active()) {
+        return deck == active_deck ? 1.0 : 0.0;
+    }
+    double out_gain, in_gain;
+    CrossfadeRenderer::gains(crossfader.curve(), crossfader.progress(), out_gain, in_gain);
+    return deck == active_deck ? in_gain : decks[deck].level * out_gain;
+}
+
+void DeckMixer::apply(Command& command) {
+    if (command.type == Command::SET_CROSSFADER) {
+        crossfader.set_curve(command.curve);
+        return;
+    }
+    if (command.deck >= decks.size()) {
+        return;
+    }
+    Deck& deck = decks[command.deck];
+    switch (command.type) {
+    case Command::LOAD:
+        // Every deck still audible fades out from its current gain under the new one
+        for (size_t i = 0; i < decks.size(); ++i) {
+            decks[i].level = i == command.deck ? 0.0 : gain(i);
+        }
+        crossfader.start(command.fade_frames);
+        active_deck = command.deck;
+        break;
+    case Command::SYNC:
+        if (deck.stream && command.stream) {
+            const uint64_t since = deck.stream->played_frames() - command.position;
+            command.stream->skip(static_cast<size_t>(since * command.skip_ratio));
+        }
+        break;
+    case Command::UNLOAD:
+        deck.level = 0.0;
+        break;
+    case Command::SET_CROSSFADER:
+        break;
+    }
+    deck.stream.swap(command.stream);
+}
+
+size_t DeckMixer::read(size_t deck, double* out, size_t frames) {
+    StreamingDecoder* decoder = stream(deck);
+    return decoder ? decoder->read(out, frames) : 0;
+}
+
+size_t DeckMixer::render(double* out, size_t frames) {
+    const size_t block = CrossfadeRenderer::BLOCK_FRAMES;
+    StreamingDecoder* incoming = stream(active_deck);
+    size_t done = 0;
+    while (incoming && done < frames) {
+        if (!crossfader.active()) {
+            // Only the active deck is audible: decode straight into the output
+            done += incoming->read(out + done, frames - done);
+            break;
+        }
+        // A block never crosses the end of the fade, so one set of gain ramps covers it
+        const size_t want = std::min(std::min(block, frames - done), crossfader.remaining());
+        double* incoming_block = &deck_blocks[active_deck * block];
+        const size_t n = incoming->read(incoming_block, want);
+        if (n == 0) {
+            break;
+        }
+        double out0, in0, out1, in1;
+        crossfader.advance(n, out0, in0, out1, in1);
+
+        // Sources of this block: the active deck, then every deck still fading out
+        size_t count = 0;
+        sources[count] = incoming_block;
+        gain_start[count] = in0;
+        gain_end[count++] = in1;
+        for (size_t i = 0; i < decks.size(); ++i) {
+            if (i == active_deck || decks[i].level <= 0.0 || !decks[i].stream) {
+                continue;
+            }
+            double* samples = &deck_blocks[i * block];
+            // An outgoing track that runs out (or falls behind) fades from silence
+            size_t m = decks[i].stream->read(samples, n);
+            std::fill(samples + m, samples + n, 0.0);
+            sources[count] = samples;
+            gain_start[count] = decks[i].level * out0;
+            gain_end[count++] = decks[i].level * out1;
+        }
+        CrossfadeRenderer::mix(sources.data(), gain_start.data(), gain_end.data(), count, out + done, n);
+        done += n;
+    }
+    return done;
+}
@@ -0,0 +1,67 @@
+#include "DeckPolicy.h"
+#include <algorithm>
+#include <cctype>
+
+const size_t DeckPolicy::NO_DECK;
+
+// ========== FACTORY ==========
+
+PointerWrapper<DeckPolicy> DeckPolicy::create(const std::string& name) {
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    if (lower == "round_robin") return PointerWrapper<DeckPolicy>(new RoundRobinDeckPolicy());
+    if (lower == "lru") return PointerWrapper<DeckPolicy>(new LeastRecentDeckPolicy());
+    if (lower == "explicit") return PointerWrapper<DeckPolicy>(new ExplicitDeckPolicy());
+    return PointerWrapper<DeckPolicy>();
+}
+
+std::vector<std::string> DeckPolicy::names() {
+    return {"round_robin", "lru", "explicit"};
+}
+
+// ========== Round-robin ==========
+
+PointerWrapper<DeckPolicy> RoundRobinDeckPolicy::clone() const {
+    return PointerWrapper<DeckPolicy>(new RoundRobinDeckPolicy(*this));
+}
+
+// ========== Least recently loaded ==========
+
+PointerWrapper<DeckPolicy> LeastRecentDeckPolicy::clone() const {
+    return PointerWrapper<DeckPolicy>(new LeastRecentDeckPolicy(*this));
+}
+
+void LeastRecentDeckPolicy::reset(size_t count) {
+    loaded_at.assign(count ? count : 1, 0);
+    loads = 0;
+}
+
+size_t LeastRecentDeckPolicy::target(size_t active) const {
+    (void)active;
+    return std::min_element(loaded_at.begin(), loaded_at.end()) - loaded_at.begin();
+}
+
+void LeastRecentDeckPolicy::onLoad(size_t deck) {
+    if (deck < loaded_at.size()) {
+        loaded_at[deck] = ++loads;
+    }
+}
+
+// ========== Explicit ==========
+
+PointerWrapper<DeckPolicy> ExplicitDeckPolicy::clone() const {
+    return PointerWrapper<DeckPolicy>(new ExplicitDeckPolicy(*this));
+}
+
+void ExplicitDeckPolicy::reset(size_t count) {
+    decks = count ? count : 1;
+    cued = 0;
+}
+
+bool ExplicitDeckPolicy::cue(size_t deck) {
+    if (deck >= decks) {
+        return false;
+    }
+    cued = deck;
+    return true;
+}
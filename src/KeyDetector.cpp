@@ -0,0 +1,251 @@
+#include "KeyDetector.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+constexpr int HarmonicKey::UNKNOWN;
+constexpr int HarmonicKey::COUNT;
+constexpr double HarmonicKey::MIN_CONFIDENCE;
+constexpr size_t KeyDetector::FRAMES;
+constexpr size_t KeyDetector::FRAME_SIZE;
+constexpr double KeyDetector::ANALYSIS_RATE;
+
+namespace {
+
+const double TWO_PI = 6.28318530717958647692;
+
+const int LOWEST_NOTE = 48;     // C3 (MIDI numbering, A4 = 69 = 440 Hz)
+const int HIGHEST_NOTE = 83;    // B5
+const size_t MIN_NOTES = 24;    // At least two octaves must lie below the analysis Nyquist limit
+
+// Coefficient of variation of the averaged chroma below which it counts as flat (atonal)
+const double MIN_CONTRAST = 0.15;
+
+// Krumhansl-Kessler probe-tone ratings, tonic first
+const double MAJOR_PROFILE[12] = {6.35, 2.23, 3.48, 2.33, 4.38, 4.09, 2.52, 5.19, 2.39, 3.66, 2.29, 2.88};
+const double MINOR_PROFILE[12] = {6.33, 2.68, 3.52, 5.38, 2.60, 3.53, 2.54, 4.75, 3.98, 2.69, 3.34, 3.17};
+
+typedef std::function<void(uint64_t first, size_t count, double* out)> Reader;
+
+// 24x24 Camelot compatibility, built once
+struct CompatibilityTable {
+    bool mixes[HarmonicKey::COUNT][HarmonicKey::COUNT];
+
+    CompatibilityTable() : mixes() {
+        for (int a = 0; a < HarmonicKey::COUNT; ++a) {
+            for (int b = 0; b < HarmonicKey::COUNT; ++b) {
+                const int steps = ((a / 2 - b / 2) % 12 + 12) % 12;
+                const bool same_letter = a % 2 == b % 2;
+                mixes[a][b] = steps == 0 || (same_letter && (steps == 1 || steps == 11));
+            }
+        }
+    }
+};
+
+const CompatibilityTable& compatibility() {
+    static const CompatibilityTable table;
+    return table;
+}
+
+// ---- Kernels: vector body + scalar tail ----
+
+// power[k] = |X(f_k)|^2 of x[0..n) for the Goertzel coefficients coeff[k] = 2 cos(2 pi f_k / rate)
+void goertzel(const double* x, size_t n, const double* coeff, size_t notes, double* power) {
+    size_t k = 0;
+#if defined(__SSE2__)
+    for (; k + 2 <= notes; k += 2) {
+        const __m128d c = _mm_loadu_pd(coeff + k);
+        __m128d s1 = _mm_setzero_pd();
+        __m128d s2 = _mm_setzero_pd();
+        for (size_t i = 0; i < n; ++i) {
+            const __m128d s0 = _mm_sub_pd(_mm_add_pd(_mm_set1_pd(x[i]), _mm_mul_pd(c, s1)), s2);
+            s2 = s1;
+            s1 = s0;
+        }
+        const __m128d cross = _mm_mul_pd(c, _mm_mul_pd(s1, s2));
+        _mm_storeu_pd(power + k, _mm_sub_pd(_mm_add_pd(_mm_mul_pd(s1, s1), _mm_mul_pd(s2, s2)), cross));
+    }
+#endif
+    for (; k < notes; ++k) {
+        double s1 = 0.0, s2 = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            const double s0 = x[i] + coeff[k] * s1 - s2;
+            s2 = s1;
+            s1 = s0;
+        }
+        power[k] = s1 * s1 + s2 * s2 - coeff[k] * s1 * s2;
+    }
+}
+
+// out[j] = mean of in[j * factor .. (j + 1) * factor)
+void decimate(const double* in, size_t factor, double* out, size_t n) {
+    if (factor == 1) {
+        std::copy(in, in + n, out);
+        return;
+    }
+    const double scale = 1.0 / factor;
+    for (size_t j = 0; j < n; ++j) {
+        const double* block = in + j * factor;
+        double total = 0.0;
+        size_t i = 0;
+#if defined(__SSE2__)
+        __m128d acc = _mm_setzero_pd();
+        for (; i + 2 <= factor; i += 2) {
+            acc = _mm_add_pd(acc, _mm_loadu_pd(block + i));
+        }
+        double lanes[2];
+        _mm_storeu_pd(lanes, acc);
+        total = lanes[0] + lanes[1];
+#endif
+        for (; i < factor; ++i) {
+            total += block[i];
+        }
+        out[j] = total * scale;
+    }
+}
+
+// Pearson correlation of a with b (12 pitch classes)
+double correlation(const double* a, const double* b) {
+    double mean_a = 0.0, mean_b = 0.0;
+    for (int i = 0; i < 12; ++i) {
+        mean_a += a[i];
+        mean_b += b[i];
+    }
+    mean_a /= 12.0;
+    mean_b /= 12.0;
+    double cross = 0.0, var_a = 0.0, var_b = 0.0;
+    for (int i = 0; i < 12; ++i) {
+        cross += (a[i] - mean_a) * (b[i] - mean_b);
+        var_a += (a[i] - mean_a) * (a[i] - mean_a);
+        var_b += (b[i] - mean_b) * (b[i] - mean_b);
+    }
+    return var_a > 0.0 && var_b > 0.0 ? cross / std::sqrt(var_a * var_b) : 0.0;
+}
+
+// Best key for an averaged chroma
+std::shared_ptr<const HarmonicKey> classify(const double* chroma) {
+    std::shared_ptr<HarmonicKey> key = std::make_shared<HarmonicKey>();
+    double mean = 0.0, variance = 0.0;
+    for (int i = 0; i < 12; ++i) {
+        mean += chroma[i];
+    }
+    mean /= 12.0;
+    for (int i = 0; i < 12; ++i) {
+        variance += (chroma[i] - mean) * (chroma[i] - mean);
+    }
+    if (mean <= 0.0 || std::sqrt(variance / 12.0) / mean < MIN_CONTRAST) {
+        return key;
+    }
+    double best = -1.0;
+    int best_key = HarmonicKey::UNKNOWN;
+    for (int tonic = 0; tonic < 12; ++tonic) {
+        double rotated[12];
+        for (int minor = 0; minor < 2; ++minor) {
+            const double* profile = minor ? MINOR_PROFILE : MAJOR_PROFILE;
+            for (int i = 0; i < 12; ++i) {
+                rotated[i] = chroma[(tonic + i) % 12];
+            }
+            const double r = correlation(rotated, profile);
+            if (r > best) {
+                best = r;
+                best_key = HarmonicKey::fromTonic(tonic, minor != 0);
+            }
+        }
+    }
+    if (best >= HarmonicKey::MIN_CONFIDENCE) {
+        key->camelot = best_key;
+        key->confidence = best;
+    }
+    return key;
+}
+
+// Chroma of FRAMES frames of audio read through read, then the best key
+std::shared_ptr<const HarmonicKey> detect_key(const Reader& read, uint64_t frames, double sample_rate) {
+    const size_t factor = std::max<size_t>(1, static_cast<size_t>(sample_rate / KeyDetector::ANALYSIS_RATE));
+    const double rate = sample_rate / factor;
+    std::vector<double> coeff;
+    std::vector<int> pitch_class;
+    for (int note = LOWEST_NOTE; note <= HIGHEST_NOTE; ++note) {
+        const double frequency = 440.0 * std::pow(2.0, (note - 69) / 12.0);
+        if (frequency < 0.45 * rate) {
+            coeff.push_back(2.0 * std::cos(TWO_PI * frequency / rate));
+            pitch_class.push_back(note % 12);
+        }
+    }
+    const size_t span = KeyDetector::FRAME_SIZE * factor;   // Input samples per frame
+    if (coeff.size() < MIN_NOTES || frames < span) {
+        return std::make_shared<HarmonicKey>();
+    }
+
+    std::vector<double> window(KeyDetector::FRAME_SIZE);
+    for (size_t i = 0; i < window.size(); ++i) {
+        window[i] = 0.5 - 0.5 * std::cos(TWO_PI * i / window.size());
+    }
+    std::vector<double> input(span), frame(KeyDetector::FRAME_SIZE), power(coeff.size());
+    double chroma[12] = {0.0};
+    for (size_t f = 0; f < KeyDetector::FRAMES; ++f) {
+        const uint64_t first = static_cast<uint64_t>((frames - span) * (f + 0.5) / KeyDetector::FRAMES);
+        read(first, span, input.data());
+        decimate(input.data(), factor, frame.data(), frame.size());
+        double mean = 0.0;
+        for (double sample : frame) {
+            mean += sample;
+        }
+        mean /= frame.size();
+        for (size_t i = 0; i < frame.size(); ++i) {
+            frame[i] = (frame[i] - mean) * window[i];
+        }
+        goertzel(frame.data(), frame.size(), coeff.data(), coeff.size(), power.data());
+
+        double classes[12] = {0.0};
+        double total = 0.0;
+        for (size_t k = 0; k < power.size(); ++k) {
+            const double magnitude = std::sqrt(std::max(0.0, power[k]));
+            classes[pitch_class[k]] += magnitude;
+            total += magnitude;
+        }
+        if (total > 1e-9) {   // Silent frames carry no key
+            for (int i = 0; i < 12; ++i) {
+                chroma[i] += classes[i] / total;
+            }
+        }
+    }
+    return classify(chroma);
+}
+
+} // namespace
+
+std::shared_ptr<const HarmonicKey> KeyDetector::detect(const AudioTrack& track) {
+    const size_t count = track.get_waveform_size();
+    const double duration = std::max(0, track.get_duration());
+    if (duration <= 0.0 || count == 0) {
+        return std::make_shared<HarmonicKey>();
+    }
+    std::shared_ptr<const TrackPayload> payload = track.get_payload();
+    return detect_key([&payload](uint64_t first, size_t n, double* out) {
+        payload->read(static_cast<size_t>(first), out, n);
+    }, count, count / duration);
+}
+
+std::shared_ptr<const HarmonicKey> KeyDetector::detect(const double* samples, size_t count, double sample_rate) {
+    return detect_key([samples](uint64_t first, size_t n, double* out) {
+        std::copy(samples + first, samples + first + n, out);
+    }, count, sample_rate);
+}
+
+std::shared_ptr<const HarmonicKey> KeyDetector::detect(const WavFile::PcmView& pcm) {
+    return detect_key([&pcm](uint64_t first, size_t n, double* out) {
+        pcm.read_mono(first, n, out);
+    }, pcm.frames, pcm.sample_rate);
+}
+
+bool KeyDetector::compatible(int camelot_a, int camelot_b) {
+    if (camelot_a < 0 || camelot_b < 0 || camelot_a >= HarmonicKey::COUNT || camelot_b >= HarmonicKey::COUNT) {
+        return true;
+    }
+    return compatibility().mixes[camelot_a][camelot_b];
+}
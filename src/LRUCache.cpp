@@ -1,16 +1,51 @@
 #include "LRUCache.h"
+#include <algorithm>
+#include <functional>
 #include <iostream>
 
 LRUCache::LRUCache(size_t capacity)
-    : slots(capacity), max_size(capacity), access_counter(0) {}
+    : slots(capacity), index(), id_index(), max_size(capacity), access_counter(0),
+      mru_slot(CacheSlot::npos), lru_slot(CacheSlot::npos), free_slot(CacheSlot::npos), used(0),
+      max_bytes(0), used_bytes(0), policy() {
+    resetSlots();
+}
 
 bool LRUCache::contains(const std::string& track_id) const {
     return findSlot(track_id) != max_size;
 }
 
+bool LRUCache::contains(TrackId id) const {
+    return findSlot(id) != max_size;
+}
+
 AudioTrack* LRUCache::get(const std::string& track_id) {
     size_t idx = findSlot(track_id);
-    if (idx == max_size) return nullptr;
+    return idx == max_size ? nullptr : touchSlot(idx);
+}
+
+AudioTrack* LRUCache::get(TrackId id) {
+    size_t idx = findSlot(id);
+    return idx == max_size ? nullptr : touchSlot(idx);
+}
+
+TrackHandle LRUCache::acquire(const std::string& track_id) {
+    size_t idx = findSlot(track_id);
+    if (idx == max_size) return TrackHandle();
+    touchSlot(idx);
+    return slots[idx].share();
+}
+
+TrackHandle LRUCache::acquire(TrackId id) {
+    size_t idx = findSlot(id);
+    if (idx == max_size) return TrackHandle();
+    touchSlot(idx);
+    return slots[idx].share();
+}
+
+AudioTrack* LRUCache::touchSlot(size_t idx) {
+    unlink(idx);
+    pushFront(idx);
+    if (policy) policy->onHit(idx);
     return slots[idx].access(++access_counter);
 }
 
@@ -18,55 +53,149 @@ AudioTrack* LRUCache::get(const std::string& track_id) {
  * TODO: Implement the put() method for LRUCache
  */
 bool LRUCache::put(PointerWrapper<AudioTrack> track) {
-    if (track.get() == nullptr) {
+    if (!track || max_size == 0 || !admits(*track)) {
         return false;
     }
-    for (size_t i = 0; i < max_size; ++i) {
-        if(slots[i].isOccupied()){
-            if(slots[i].getTrack()->get_title() == track->get_title()){
-                access_counter++;
-                slots[i].access(access_counter);
-                return false;
-            }
-        }
-    }    
+    size_t existing = findSlot(*track);
+    if (existing != max_size) {
+        touchSlot(existing);
+        return false;
+    }
+    const CacheKey key = policyKey(*track);
     bool evicted = false;
     access_counter++;
-    if(findEmptySlot() == max_size){
-        evictLRU();
+    if (policy) policy->onMiss(key);
+    size_t weight = max_bytes ? track->get_memory_footprint() : 0;
+    while(findEmptySlot() == max_size || (max_bytes && used_bytes + weight > max_bytes)){
+        if (!evictVictim(findVictimSlot(key))) break;
         evicted = true;
     }
-    size_t newSlot = findEmptySlot();
-    slots[newSlot].store(std::move(track), access_counter);
+    store(std::move(track));
     return evicted;
 
 }
 
+bool LRUCache::putUnless(PointerWrapper<AudioTrack> track, const std::vector<TrackId>& keep) {
+    if (!track || max_size == 0 || !admits(*track)) {
+        return false;
+    }
+    if (findSlot(*track) != max_size) {
+        return false;
+    }
+    const CacheKey key = policyKey(*track);
+    size_t weight = max_bytes ? track->get_memory_footprint() : 0;
+    // Decide before touching anything: a refused track leaves the entries and the policy as they were
+    if (evictsKept(key, weight, keep)) {
+        return false;
+    }
+    // Same miss as put(): the policy hears of it before it picks any victim
+    access_counter++;
+    if (policy) policy->onMiss(key);
+    while (findEmptySlot() == max_size || (max_bytes && used_bytes + weight > max_bytes)) {
+        if (!evictVictim(findVictimSlot(key))) break;
+    }
+    store(std::move(track));
+    return true;
+}
+
+bool LRUCache::evictsKept(CacheKey incoming, size_t weight, const std::vector<TrackId>& keep) const {
+    bool has_free = findEmptySlot() != max_size;
+    size_t bytes = used_bytes;
+    if (has_free && (!max_bytes || bytes + weight <= max_bytes)) {
+        return false;
+    }
+    // Replay the eviction chain put() would run, on a copy of the policy (or down the recency list)
+    PointerWrapper<CachePolicy> trial;
+    if (policy) {
+        trial = policy->clone();
+        trial->onMiss(incoming);
+    }
+    size_t next = lru_slot;
+    for (size_t left = used; left > 0 && (!has_free || (max_bytes && bytes + weight > max_bytes)); --left) {
+        size_t victim = trial ? trial->victim(incoming) : next;
+        if (victim >= max_size || !slots[victim].isOccupied()) break;
+        const AudioTrack* track = slots[victim].getTrack();
+        if (std::find(keep.begin(), keep.end(), track->get_id()) != keep.end()) {
+            return true;
+        }
+        if (trial) {
+            trial->commitVictim(victim);
+            trial->onEvict(victim, policyKey(*track));
+        } else {
+            next = slots[victim].getPrev();
+        }
+        bytes -= slots[victim].getBytes();
+        has_free = true;
+    }
+    return false;
+}
+
+void LRUCache::store(PointerWrapper<AudioTrack> track) {
+    std::string key = track->get_title();
+    TrackId id = track->get_id();
+    const CacheKey policy_key = policyKey(*track);
+    size_t newSlot = findEmptySlot();
+    free_slot = slots[newSlot].getNext();
+    slots[newSlot].store(std::move(track), access_counter);
+    pushFront(newSlot);
+    index[key] = newSlot;
+    if (id != INVALID_TRACK_ID) id_index[id] = newSlot;
+    used++;
+    used_bytes += slots[newSlot].getBytes();
+    if (policy) policy->onInsert(newSlot, policy_key);
+}
+
 bool LRUCache::evictLRU() {
-    size_t lru = findLRUSlot();
-    if (lru == max_size || !slots[lru].isOccupied()) return false;
-    slots[lru].clear();
+    return evictVictim(findVictimSlot(NO_CACHE_KEY));
+}
+
+bool LRUCache::evictVictim(size_t idx) {
+    if (idx >= max_size || !slots[idx].isOccupied()) return false;
+    if (policy) policy->commitVictim(idx);
+    return evictSlot(idx);
+}
+
+bool LRUCache::evictSlot(size_t idx) {
+    if (idx >= max_size || !slots[idx].isOccupied()) return false;
+    const AudioTrack* track = slots[idx].getTrack();
+    if (policy) policy->onEvict(idx, policyKey(*track));
+    index.erase(track->get_title());
+    if (track->get_id() != INVALID_TRACK_ID) id_index.erase(track->get_id());
+    unlink(idx);
+    used_bytes -= slots[idx].getBytes();
+    slots[idx].clear();
+    slots[idx].setNext(free_slot);
+    free_slot = idx;
+    used--;
     return true;
 }
 
 size_t LRUCache::size() const {
-    size_t count = 0;
-    for (const auto& slot : slots) if (slot.isOccupied()) ++count;
-    return count;
+    return used;
 }
 
 void LRUCache::clear() {
     for (auto& slot : slots) {
         slot.clear();
     }
+    resetSlots();
+    if (policy) policy->reset(max_size);
 }
 
 void LRUCache::displayStatus() const {
     std::cout << "[LRUCache] Status: " << size() << "/" << max_size << " slots used\n";
+    if (max_bytes) {
+        std::cout << "[LRUCache] Memory: " << used_bytes << "/" << max_bytes << " bytes used, "
+                  << max_bytes - used_bytes << " bytes free\n";
+    }
     for (size_t i = 0; i < max_size; ++i) {
         if(slots[i].isOccupied()){
             std::cout << "  Slot " << i << ": " << slots[i].getTrack()->get_title()
-                      << " (last access: " << slots[i].getLastAccessTime() << ")\n";
+                      << " (last access: " << slots[i].getLastAccessTime();
+            if (max_bytes) {
+                std::cout << ", " << slots[i].getBytes() << " bytes";
+            }
+            std::cout << ")\n";
         } else {
             std::cout << "  Slot " << i << ": [EMPTY]\n";
         }
@@ -74,42 +203,138 @@ void LRUCache::displayStatus() const {
 }
 
 size_t LRUCache::findSlot(const std::string& track_id) const {
-    for (size_t i = 0; i < max_size; ++i) {
-        if (slots[i].isOccupied() && slots[i].getTrack()->get_title() == track_id) return i;
-    }
-    return max_size;
+    auto it = index.find(track_id);
+    return it == index.end() ? max_size : it->second;
+}
+
+size_t LRUCache::findSlot(TrackId id) const {
+    auto it = id_index.find(id);
+    return it == id_index.end() ? max_size : it->second;
+}
+
+size_t LRUCache::findSlot(const AudioTrack& track) const {
+    return track.get_id() != INVALID_TRACK_ID ? findSlot(track.get_id()) : findSlot(track.get_title());
+}
 
+CacheKey LRUCache::policyKey(const AudioTrack& track) {
+    if (track.get_id() != INVALID_TRACK_ID) {
+        return track.get_id();
+    }
+    // Bit 32 keeps title hashes clear of every TrackId, bit 63 clear of NO_CACHE_KEY
+    uint64_t hash = std::hash<std::string>()(track.get_title());
+    return (hash | (1ULL << 32)) & ~(1ULL << 63);
 }
 
 /**
  * TODO: Implement the findLRUSlot() method for LRUCache
  */
 size_t LRUCache::findLRUSlot() const {
-    uint64_t min = (uint64_t)-1;
-    size_t lru_idx = max_size;
-    for (size_t i = 0; i < max_size; ++i) {
-        if (slots[i].isOccupied()){
-            if (slots[i].getLastAccessTime() < min){
-                min = slots[i].getLastAccessTime();
-                lru_idx = i;
-            }
-        }
-    }
-    return lru_idx;
+    return lru_slot == CacheSlot::npos ? max_size : lru_slot;
 }
 
 size_t LRUCache::findEmptySlot() const {
-    for (size_t i = 0; i < max_size; ++i) {
-        if (!slots[i].isOccupied()) return i;
-    }
-    return max_size;
+    return free_slot == CacheSlot::npos ? max_size : free_slot;
+}
+
+size_t LRUCache::findVictimSlot(CacheKey incoming) {
+    if (used == 0) return max_size;
+    if (!policy) return findLRUSlot();
+    size_t victim = policy->victim(incoming);
+    return victim < max_size ? victim : findLRUSlot();
 }
 
 void LRUCache::set_capacity(size_t capacity){
     if (max_size == capacity)
         return;
+    // Drain entries MRU -> LRU, keeping as many as the new capacity allows
+    std::vector<CacheSlot> kept;
+    kept.reserve(capacity);
+    for (size_t i = mru_slot; i != CacheSlot::npos && kept.size() < capacity; i = slots[i].getNext()) {
+        kept.push_back(std::move(slots[i]));
+    }
     //udpate max size
     max_size = capacity;
     //update the slots vector
-    slots.resize(capacity);
-}
\ No newline at end of file
+    slots = std::vector<CacheSlot>(capacity);
+    resetSlots();
+    if (policy) policy->reset(capacity);
+    // Re-insert from LRU to MRU so the original order is preserved
+    for (size_t k = kept.size(); k-- > 0; ) {
+        size_t idx = free_slot;
+        free_slot = slots[idx].getNext();
+        slots[idx] = std::move(kept[k]);
+        pushFront(idx);
+        const AudioTrack* track = slots[idx].getTrack();
+        index[track->get_title()] = idx;
+        if (track->get_id() != INVALID_TRACK_ID) id_index[track->get_id()] = idx;
+        used++;
+        used_bytes += slots[idx].getBytes();
+        if (policy) policy->onInsert(idx, policyKey(*track));
+    }
+}
+
+void LRUCache::set_byte_budget(size_t bytes) {
+    max_bytes = bytes;
+    while (max_bytes && used_bytes > max_bytes) {
+        if (!evictSlot(findVictimSlot(NO_CACHE_KEY))) break;
+    }
+}
+
+bool LRUCache::admits(const AudioTrack& track) const {
+    return max_bytes == 0 || track.get_memory_footprint() <= max_bytes;
+}
+
+void LRUCache::set_policy(PointerWrapper<CachePolicy> new_policy) {
+    policy = std::move(new_policy);
+    if (!policy) return;
+    policy->reset(max_size);
+    for (size_t i = lru_slot; i != CacheSlot::npos; i = slots[i].getPrev()) {
+        policy->onInsert(i, policyKey(*slots[i].getTrack()));
+    }
+}
+
+std::string LRUCache::policy_name() const {
+    return policy ? policy->name() : "LRU";
+}
+
+std::vector<TrackHandle> LRUCache::entries() const {
+    std::vector<TrackHandle> tracks;
+    tracks.reserve(used);
+    for (size_t i = lru_slot; i != CacheSlot::npos; i = slots[i].getPrev()) {
+        tracks.push_back(slots[i].share());
+    }
+    return tracks;
+}
+
+void LRUCache::unlink(size_t idx) {
+    size_t prev = slots[idx].getPrev();
+    size_t next = slots[idx].getNext();
+    if (prev != CacheSlot::npos) slots[prev].setNext(next); else mru_slot = next;
+    if (next != CacheSlot::npos) slots[next].setPrev(prev); else lru_slot = prev;
+    slots[idx].setPrev(CacheSlot::npos);
+    slots[idx].setNext(CacheSlot::npos);
+}
+
+void LRUCache::pushFront(size_t idx) {
+    slots[idx].setPrev(CacheSlot::npos);
+    slots[idx].setNext(mru_slot);
+    if (mru_slot != CacheSlot::npos) slots[mru_slot].setPrev(idx);
+    mru_slot = idx;
+    if (lru_slot == CacheSlot::npos) lru_slot = idx;
+}
+
+void LRUCache::resetSlots() {
+    index.clear();
+    id_index.clear();
+    mru_slot = CacheSlot::npos;
+    lru_slot = CacheSlot::npos;
+    used = 0;
+    used_bytes = 0;
+    // Chain free slots in ascending order so the lowest index is filled first
+    free_slot = CacheSlot::npos;
+    for (size_t i = slots.size(); i-- > 0; ) {
+        slots[i].setPrev(CacheSlot::npos);
+        slots[i].setNext(free_slot);
+        free_slot = i;
+    }
+}
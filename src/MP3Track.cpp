@@ -1,39 +1,96 @@
 #include "MP3Track.h"
+#include "AnalysisCache.h"
+#include "BeatGridAnalyzer.h"
+#include "KeyDetector.h"
 #include <iostream>
 #include <cmath>
 #include <algorithm>
 
 MP3Track::MP3Track(const std::string& title, const std::vector<std::string>& artists, 
-                   int duration, int bpm, int bitrate, bool has_tags)
-    : AudioTrack(title, artists, duration, bpm), bitrate(bitrate), has_id3_tags(has_tags) {
+                   int duration, int bpm, int bitrate, bool has_tags, const std::string& file_path)
+    : AudioTrack(title, artists, duration, bpm), bitrate(bitrate), has_id3_tags(has_tags),
+      file_path(file_path),
+      mapping(file_path.empty() ? nullptr : std::make_shared<SharedFile<Mp3File>>()), audio() {
 
     std::cout << "MP3Track created: " << bitrate << " kbps" << std::endl;
 }
 
 // ========== TODO: STUDENTS IMPLEMENT THESE VIRTUAL FUNCTIONS ==========
 
-void MP3Track::load() {
-    std::cout << "[MP3Track::load] Loading MP3: \"" << title
+void MP3Track::load(std::ostream& out) {
+    std::string map_error;
+    if (mapping && !audio) {
+        const std::string& path = file_path;
+        std::shared_ptr<const Mp3File> file = mapping->open([&path] {
+            return std::make_shared<Mp3File>(path, AnalysisCache::shared().seekTablePath(path));
+        });
+        if (file->is_open()) {
+            audio = file;
+            // The file is authoritative over the configured bitrate and tags
+            bitrate = file->average_kbps();
+            has_id3_tags = file->has_id3();
+        } else {
+            map_error = file->error();
+        }
+    }
+    out << "[MP3Track::load] Loading MP3: \"" << title
               << "\" at " << bitrate << " kbps...\n";
     // TODO: Implement MP3 loading with format-specific operations
     // NOTE: Use exactly 2 spaces before the arrow (→) character
     if(has_id3_tags){
-        std::cout <<"  → Processing ID3 metadata (artist info, album art, etc.)..." << std::endl;
+        out <<"  → Processing ID3 metadata (artist info, album art, etc.)..." << std::endl;
     }
     else{
-        std::cout <<"  → No ID3 tags found" <<std::endl;
+        out <<"  → No ID3 tags found" <<std::endl;
+    }
+    if (audio) {
+        const std::string index_path = AnalysisCache::shared().seekTablePath(file_path);
+        out << "  → Indexed " << audio->frame_count() << " frames (" << audio->duration() << " s"
+                  << (audio->has_toc() ? ", VBR TOC" : "") << "), seek table ";
+        if (index_path.empty()) {
+            out << "kept in memory (no analysis store)" << std::endl;
+        } else {
+            out << (audio->index_loaded() ? "loaded from " : audio->index_saved() ? "saved to " : "not saved to ")
+                << "\"" << index_path << "\"" << std::endl;
+        }
+        out << "  → Frames are decoded on demand" << std::endl;
+    } else {
+        if (!map_error.empty()) {
+            out << "  → Could not map \"" << file_path << "\" (" << map_error << ")" << std::endl;
+        }
+        out <<"  → Decoding MP3 frames..." <<std::endl;
     }
-    std::cout <<"  → Decoding MP3 frames..." <<std::endl;
-    std::cout <<"  → Load complete." <<std::endl;
+    out <<"  → Load complete." <<std::endl;
     
 }
 
-void MP3Track::analyze_beatgrid() {
-     std::cout << "[MP3Track::analyze_beatgrid] Analyzing beat grid for: \"" << title << "\"\n";
+void MP3Track::analyze_beatgrid(std::ostream& out) {
+     out << "[MP3Track::analyze_beatgrid] Analyzing beat grid for: \"" << title << "\"\n";
     // NOTE: Use exactly 2 spaces before each arrow (→) character
     int eb = (duration_seconds / 60.0) * bpm;
     double pf = (bitrate / 320.0);
-    std::cout <<"  → Estimated beats: " << eb <<"  → Compression precision factor: " << pf <<std::endl;
+    out <<"  → Estimated beats: " << eb <<"  → Compression precision factor: " << pf <<std::endl;
+    if (audio) {
+        // Granule energies straight from the frames' side information; memoized per file mapping,
+        // which every copy shares
+        std::shared_ptr<const Mp3File> file = audio;
+        int fallback_bpm = bpm;
+        beat_grid = AnalysisCache::shared().beatGrid(file, duration_seconds, bpm, [file, fallback_bpm] {
+            return BeatGridAnalyzer::analyze(*file, fallback_bpm, BeatGridAnalyzer::timeBudget(file->duration()));
+        });
+        // Side information carries no pitch and frames are never decoded to PCM,
+        // so the key stays unknown (the Camelot check then judges on BPM alone)
+        camelot_key = HarmonicKey::UNKNOWN;
+    } else {
+        beat_grid = AnalysisCache::shared().beatGrid(*this);
+        camelot_key = AnalysisCache::shared().harmonicKey(*this)->camelot;
+    }
+    if (beat_grid->confident()) {
+        out << "  → Detected BPM: " << beat_grid->bpm << " (confidence " << beat_grid->confidence << ")" << std::endl;
+    }
+    if (camelot_key != HarmonicKey::UNKNOWN) {
+        out << "  → Detected key: " << HarmonicKey::name(camelot_key) << std::endl;
+    }
 
 }
 
@@ -55,6 +112,24 @@ double MP3Track::get_quality_score() const {
     return base_score;
 }
 
+size_t MP3Track::get_memory_footprint() const {
+    if (audio) {
+        // The mapped frames plus the seek table
+        return static_cast<size_t>(audio->data_bytes()) + audio->index_bytes() + AudioTrack::get_memory_footprint();
+    }
+    // Compressed frames stay in memory and are decoded on the fly
+    size_t frame_bytes = static_cast<size_t>(duration_seconds) * bitrate * 1000 / 8;
+    return frame_bytes + AudioTrack::get_memory_footprint();
+}
+
 PointerWrapper<AudioTrack> MP3Track::clone() const {
     return PointerWrapper<AudioTrack>(new MP3Track(*this));
+}
+
+PointerWrapper<TrackStream> MP3Track::open_stream() const {
+    if (mapping) {
+        // Frames are indexed but never synthesized to PCM; the waveform is not this file's audio
+        return PointerWrapper<TrackStream>();
+    }
+    return PointerWrapper<TrackStream>(new WaveformStream(payload, duration_seconds));
 }
\ No newline at end of file
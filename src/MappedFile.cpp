@@ -0,0 +1,47 @@
+#include "MappedFile.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& path, size_t min_size)
+    : base(nullptr), length(0), mtime_ns(0), failure() {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        failure = "cannot open file";
+        return;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) == 0 && info.st_size > 0 && static_cast<uint64_t>(info.st_size) >= min_size) {
+        void* mapping = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            base = mapping;
+            length = static_cast<size_t>(info.st_size);
+            mtime_ns = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000LL + info.st_mtim.tv_nsec;
+        } else {
+            failure = "cannot map file";
+        }
+    } else {
+        failure = "file too short";
+    }
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+    reset();
+}
+
+void MappedFile::advise_sequential(bool sequential) const {
+    if (base) {
+        ::madvise(base, length, sequential ? MADV_SEQUENTIAL : MADV_NORMAL);
+    }
+}
+
+void MappedFile::reset() {
+    if (base) {
+        ::munmap(base, length);
+    }
+    base = nullptr;
+    length = 0;
+}
@@ -0,0 +1,263 @@
+#include "MixdownRenderer.h"
+#include "TimeStretcher.h"
+#include "WavWriter.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+const size_t CHUNK_FRAMES = 65536;   // Decode granularity of a track body
+
+/**
+ * @brief Linear-interpolation resampler over another stream
+ */
+class ResampleStream : public TrackStream {
+public:
+    ResampleStream(PointerWrapper<TrackStream> source, double output_rate)
+        : source(std::move(source)), rate(output_rate), step(0.0), total(0), next(0), buffer(),
+          buffer_start(0), source_done(false) {
+        step = this->source->sample_rate() / rate;
+        total = static_cast<uint64_t>(std::llround(this->source->length() / step));
+    }
+
+    size_t read(double* out, size_t frames) override {
+        const size_t count = static_cast<size_t>(std::min<uint64_t>(frames, total - next));
+        for (size_t i = 0; i < count; ++i, ++next) {
+            const double position = next * step;
+            const uint64_t index = static_cast<uint64_t>(position);
+            const double frac = position - index;
+            out[i] = sample(index) * (1.0 - frac) + (frac > 0.0 ? sample(index + 1) * frac : 0.0);
+        }
+        return count;
+    }
+
+    double sample_rate() const override { return rate; }
+    uint64_t length() const override { return total; }
+    uint64_t position() const override { return next; }
+
+private:
+    // Source sample at an absolute index (silence past the end); indices only grow
+    double sample(uint64_t index) {
+        while (index >= buffer_start + buffer.size() && !source_done) {
+            const uint64_t keep_from = std::min<uint64_t>(index, buffer_start + buffer.size());
+            buffer.erase(buffer.begin(), buffer.begin() + static_cast<size_t>(keep_from - buffer_start));
+            buffer_start = keep_from;
+            const size_t old_size = buffer.size();
+            buffer.resize(old_size + 4096);
+            const size_t got = source->read(buffer.data() + old_size, 4096);
+            buffer.resize(old_size + got);
+            source_done = got < 4096;
+        }
+        return index < buffer_start + buffer.size() ? buffer[static_cast<size_t>(index - buffer_start)] : 0.0;
+    }
+
+    PointerWrapper<TrackStream> source;
+    double rate;
+    double step;                  // Source frames per output frame
+    uint64_t total;
+    uint64_t next;
+    std::vector<double> buffer;   // Source samples [buffer_start, buffer_start + size)
+    uint64_t buffer_start;
+    bool source_done;
+};
+
+// Read exactly count frames, padding with silence if the stream ends early
+void read_exact(TrackStream& stream, double* out, size_t count) {
+    size_t done = 0;
+    while (done < count) {
+        size_t n = stream.read(out + done, count - done);
+        if (n == 0) {
+            std::fill(out + done, out + count, 0.0);
+            return;
+        }
+        done += n;
+    }
+}
+
+} // namespace
+
+MixdownRenderer::MixdownRenderer(unsigned sample_rate, double crossfade_seconds, CrossfadeRenderer::Curve curve,
+                                 size_t threads)
+    : rate(sample_rate ? sample_rate : 44100), fade_seconds(std::max(0.0, crossfade_seconds)), fade_curve(curve),
+      threads(threads ? threads : std::max(1u, std::thread::hardware_concurrency())), entries(), segments(),
+      mutex(), work(), finished(), tasks(), stopping(false), total_frames(0), wall_ms(0.0), io_ms(0.0),
+      blocks(0) {}
+
+MixdownRenderer::~MixdownRenderer() {}
+
+void MixdownRenderer::add_track(PointerWrapper<AudioTrack> track, double tempo) {
+    if (!track) {
+        return;
+    }
+    Entry entry;
+    entry.track = std::move(track);
+    entry.tempo = tempo;
+    entries.push_back(std::move(entry));
+}
+
+PointerWrapper<TrackStream> MixdownRenderer::open(size_t index) const {
+    const Entry& entry = entries[index];
+    PointerWrapper<TrackStream> stream = entry.track->open_stream();
+    if (stream && entry.tempo != 1.0) {
+        stream = PointerWrapper<TrackStream>(new TimeStretchStream(std::move(stream), entry.tempo));
+    }
+    if (stream && stream->sample_rate() > 0.0 && stream->sample_rate() != rate) {
+        stream = PointerWrapper<TrackStream>(new ResampleStream(std::move(stream), rate));
+    }
+    return stream;
+}
+
+void MixdownRenderer::plan() {
+    for (size_t i = 0; i < entries.size(); ++i) {
+        PointerWrapper<TrackStream> stream = open(i);
+        entries[i].length = stream && stream->sample_rate() > 0.0 ? stream->length() : 0;
+        entries[i].head = entries[i].tail = 0;
+        entries[i].decoded = false;
+    }
+    const uint64_t fade_frames = static_cast<uint64_t>(fade_seconds * rate);
+    for (size_t i = 0; i + 1 < entries.size(); ++i) {
+        const uint64_t fade = std::min(fade_frames, std::min(entries[i].length / 2, entries[i + 1].length / 2));
+        entries[i].tail = entries[i + 1].head = fade;
+    }
+    segments.clear();
+    segments.resize(entries.size() * 2 - 1);
+    total_frames = 0;
+    for (const Entry& entry : entries) {
+        total_frames += entry.length - entry.tail;   // Each fade counted once, with the track it leads to
+    }
+}
+
+void MixdownRenderer::push(Task task) {
+    tasks.push_back(task);
+    work.notify_one();
+}
+
+void MixdownRenderer::worker() {
+    while (true) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            work.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                return;
+            }
+            task = tasks.front();
+            tasks.pop_front();
+        }
+        if (task.kind == DECODE) {
+            decode(task.index);
+        } else {
+            fade(task.index);
+        }
+    }
+}
+
+void MixdownRenderer::decode(size_t index) {
+    Entry& entry = entries[index];
+    Segment& body = segments[2 * index];
+    PointerWrapper<TrackStream> stream = open(index);
+    if (stream) {
+        entry.head_samples.resize(static_cast<size_t>(entry.head));
+        read_exact(*stream, entry.head_samples.data(), entry.head_samples.size());
+        const size_t body_frames = static_cast<size_t>(entry.length - entry.head - entry.tail);
+        body.pcm.resize(body_frames);
+        std::vector<double> chunk(std::min(CHUNK_FRAMES, body_frames));
+        for (size_t done = 0; done < body_frames;) {
+            const size_t n = std::min(chunk.size(), body_frames - done);
+            read_exact(*stream, chunk.data(), n);
+            WavWriter::encode(chunk.data(), body.pcm.data() + done, n);
+            done += n;
+        }
+        entry.tail_samples.resize(static_cast<size_t>(entry.tail));
+        read_exact(*stream, entry.tail_samples.data(), entry.tail_samples.size());
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    entry.decoded = true;
+    body.ready = true;
+    if (index > 0 && entries[index - 1].decoded) {
+        push(Task{FADE, index - 1});
+    }
+    if (index + 1 < entries.size() && entries[index + 1].decoded) {
+        push(Task{FADE, index});
+    }
+    finished.notify_all();
+}
+
+void MixdownRenderer::fade(size_t index) {
+    Entry& outgoing = entries[index];
+    Entry& incoming = entries[index + 1];
+    Segment& segment = segments[2 * index + 1];
+    const size_t frames = outgoing.tail_samples.size();
+    std::vector<double> mixed(frames);
+    CrossfadeRenderer renderer;
+    renderer.set_curve(fade_curve);
+    renderer.start(frames);
+    renderer.render(outgoing.tail_samples.data(), incoming.head_samples.data(), mixed.data(), frames);
+    segment.pcm.resize(frames);
+    WavWriter::encode(mixed.data(), segment.pcm.data(), frames);
+    std::vector<double>().swap(outgoing.tail_samples);
+    std::vector<double>().swap(incoming.head_samples);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    segment.ready = true;
+    finished.notify_all();
+}
+
+bool MixdownRenderer::render(const std::string& path) {
+    total_frames = 0;
+    wall_ms = io_ms = 0.0;
+    blocks = 0;
+    if (entries.empty()) {
+        return false;
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    plan();
+    WavWriter writer(path, rate);
+    if (!writer.is_open()) {
+        return false;
+    }
+
+    // Decoding runs at most threads + 1 tracks ahead of the writer
+    const size_t window = threads + 1;
+    size_t scheduled = 0;
+    stopping = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (; scheduled < std::min(window, entries.size()); ++scheduled) {
+            push(Task{DECODE, scheduled});
+        }
+    }
+    std::vector<std::thread> pool;
+    for (size_t i = 0; i < threads; ++i) {
+        pool.push_back(std::thread(&MixdownRenderer::worker, this));
+    }
+
+    for (size_t s = 0; s < segments.size(); ++s) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            finished.wait(lock, [this, s] { return segments[s].ready; });
+        }
+        writer.write(segments[s].pcm.data(), segments[s].pcm.size());
+        std::vector<int16_t>().swap(segments[s].pcm);
+        if (s % 2 == 0 && scheduled < entries.size()) {
+            std::lock_guard<std::mutex> lock(mutex);
+            push(Task{DECODE, scheduled++});
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    work.notify_all();
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+    const bool written = writer.close();
+    io_ms = writer.write_ms();
+    blocks = writer.blocks();
+    wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return written;
+}
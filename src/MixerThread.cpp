@@ -0,0 +1,117 @@
+#include "MixerThread.h"
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+constexpr size_t MixerThread::DEFAULT_QUEUE;
+
+MixerThread::MixerThread(DeckMixer& mixer, double sample_rate, size_t callback_frames, const Sink& sink, bool paced,
+                         size_t queue_capacity)
+    : mixer(mixer), rate(sample_rate > 0.0 ? sample_rate : 44100.0), sink(sink), paced(paced),
+      commands(queue_capacity), retired(queue_capacity), block(std::max<size_t>(1, callback_frames), 0.0),
+      pending(), held(), stopping(false), callback_count(0), underrun_count(0), late_count(0), applied_count(0),
+      retired_count(0), longest_ns(0), thread() {
+    thread = std::thread(&MixerThread::run, this);
+}
+
+MixerThread::~MixerThread() {
+    stop();
+}
+
+bool MixerThread::post(Command&& command) {
+    return commands.push(std::move(command));
+}
+
+void MixerThread::send(Command&& command) {
+    collect();
+    while (!commands.push(std::move(command))) {
+        std::this_thread::yield();
+        collect();
+    }
+}
+
+size_t MixerThread::collect() {
+    size_t freed = 0;
+    PointerWrapper<StreamingDecoder> decoder;
+    while (retired.pop(decoder)) {
+        decoder.reset();
+        ++freed;
+    }
+    return freed;
+}
+
+void MixerThread::stop() {
+    if (!thread.joinable()) {
+        return;
+    }
+    stopping.store(true, std::memory_order_release);
+    thread.join();
+    // The mixer is ours again: finish what the thread left behind
+    collect();
+    held.reset();
+    while (commands.pop(pending)) {
+        mixer.apply(pending);
+        applied_count.fetch_add(1, std::memory_order_relaxed);
+        pending.stream.reset();
+    }
+}
+
+void MixerThread::drain() {
+    if (held && !retired.push(std::move(held))) {
+        return;
+    }
+    while (commands.pop(pending)) {
+        mixer.apply(pending);
+        applied_count.fetch_add(1, std::memory_order_relaxed);
+        if (!pending.stream) {
+            continue;
+        }
+        retired_count.fetch_add(1, std::memory_order_relaxed);
+        if (!retired.push(std::move(pending.stream))) {
+            held = std::move(pending.stream);
+            return;
+        }
+    }
+}
+
+void MixerThread::run() {
+    typedef std::chrono::steady_clock Clock;
+    const Clock::duration period =
+        std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(block.size() / rate));
+    Clock::time_point deadline = Clock::now();
+    while (!stopping.load(std::memory_order_acquire)) {
+        const Clock::time_point start = Clock::now();
+        drain();
+        const size_t frames = mixer.render(block.data(), block.size());
+        if (frames < block.size()) {
+            std::fill(block.begin() + frames, block.end(), 0.0);
+            // Silence after a track ends is expected; a decoder that is behind is an underrun
+            const StreamingDecoder* active = mixer.stream(mixer.active());
+            if (active && !active->finished()) {
+                underrun_count.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        if (sink) {
+            sink(block.data(), block.size());
+        }
+        callback_count.fetch_add(1, std::memory_order_relaxed);
+        const Clock::time_point end = Clock::now();
+        const uint64_t took = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        if (took > longest_ns.load(std::memory_order_relaxed)) {
+            longest_ns.store(took, std::memory_order_relaxed);
+        }
+
+        if (!paced) {
+            continue;
+        }
+        deadline += period;
+        if (end > deadline) {
+            late_count.fetch_add(1, std::memory_order_relaxed);
+            if (end - deadline > period) {
+                deadline = end;   // Too far behind to catch up: drop the backlog
+            }
+            continue;
+        }
+        std::this_thread::sleep_until(deadline);
+    }
+}
@@ -1,15 +1,33 @@
 #include "MixingEngineService.h"
+#include "KeyDetector.h"
+#include <algorithm>
 #include <iostream>
 #include <memory>
+#include <cmath>
+#include <vector>
 // #include <cstdlib>
 // #include <climits>
+
+namespace {
+
+// Tempo used for compatibility and sync: the detected one (at the playback
+// speed of a time-stretched deck) when the beat grid is trustworthy, otherwise
+// the configured BPM, which sync_bpm already set to the retuned value
+int mixing_bpm(const AudioTrack& track, double tempo = 1.0) {
+    const BeatGrid* grid = track.get_beat_grid();
+    return grid && grid->confident() ? static_cast<int>(std::lround(grid->bpm * tempo)) : track.get_bpm();
+}
+
+} // namespace
 /**
  * TODO: Implement MixingEngineService constructor
  */
 MixingEngineService::MixingEngineService()
-    : decks(), active_deck(1), auto_sync(false), bpm_tolerance(0)
+    : decks(2), policy(new RoundRobinDeckPolicy()), active_deck(0), auto_sync(false), bpm_tolerance(0),
+      streaming(false), crossfade_seconds(0), crossfade_curve(CrossfadeRenderer::LINEAR), mixer(2), mixer_thread()
 {
-    std::cout << "[MixingEngineService] Initialized with 2 empty decks." << std::endl;
+    policy->reset(decks.size());
+    std::cout << "[MixingEngineService] Initialized with " << decks.size() << " empty decks." << std::endl;
 }
 
 /**
@@ -17,9 +35,11 @@ MixingEngineService::MixingEngineService()
  */
 MixingEngineService::~MixingEngineService() {
     std::cout << "[MixingEngineService] Cleaning up decks..." << std::endl;
-    for (AudioTrack*& deck : decks){
-        delete deck;
-        deck = nullptr;
+    stop_mixer_thread();
+    for (Deck& deck : decks) {
+        deck.stream = nullptr;
+        deck.track.reset();
+        deck.pinned.reset();
     }
     active_deck = 0;
     auto_sync = false;
@@ -30,18 +50,18 @@ MixingEngineService::~MixingEngineService() {
 */
 MixingEngineService& MixingEngineService::operator=(const MixingEngineService& other){
     if (this != &other ){
+        stop_mixer_thread();
+        decks.clear();
+        decks.resize(other.decks.size());
+        policy = other.policy->clone();
         active_deck = other.active_deck;
         auto_sync = other.auto_sync;
         bpm_tolerance = other.bpm_tolerance;
-        for (int i = 0; i < 2; i++) {
-            delete decks[i];            
-            if (other.decks[i] != nullptr) {
-                decks[i] = other.decks[i]->clone().release(); 
-            } 
-            else {
-                decks[i] = nullptr;
-            }
-        }
+        streaming = other.streaming;
+        crossfade_seconds = other.crossfade_seconds;
+        crossfade_curve = other.crossfade_curve;
+        mixer.set_deck_count(decks.size());
+        copy_decks(other);
     }
     return *this;
 }
@@ -49,12 +69,114 @@ MixingEngineService& MixingEngineService::operator=(const MixingEngineService& o
 /*
 * copy constructor
 */
-MixingEngineService::MixingEngineService(const MixingEngineService& other):  decks{nullptr,nullptr}, active_deck(other.active_deck),
-                                        auto_sync(other.auto_sync), bpm_tolerance(other.bpm_tolerance){
-    for(int i= 0; i < 2; i++){
-        if(other.decks[i] != nullptr)
-        decks[i] = other.decks[i]->clone().release();
+MixingEngineService::MixingEngineService(const MixingEngineService& other):  decks(other.decks.size()),
+                                        policy(other.policy->clone()), active_deck(other.active_deck),
+                                        auto_sync(other.auto_sync), bpm_tolerance(other.bpm_tolerance),
+                                        streaming(other.streaming),
+                                        crossfade_seconds(other.crossfade_seconds),
+                                        crossfade_curve(other.crossfade_curve), mixer(other.decks.size()),
+                                        mixer_thread(){
+    copy_decks(other);
+}
+
+void MixingEngineService::copy_decks(const MixingEngineService& other) {
+    DeckMixer::Command curve = DeckMixer::Command::crossfader(crossfade_curve);
+    mixer.apply(curve);
+    for (size_t i = 0; i < decks.size(); i++) {
+        if (other.decks[i].track) {
+            decks[i].track = other.decks[i].track->clone();
+        }
+        decks[i].pinned = other.decks[i].pinned;   // Borrowed tracks stay shared
+        decks[i].tempo = other.decks[i].tempo;
+    }
+    // A copy plays its decks from the start, on its own mixer; the active deck is
+    // loaded last so that it ends up active
+    for (size_t n = 1; n <= decks.size(); n++) {
+        const size_t i = (active_deck + n) % decks.size();
+        PointerWrapper<StreamingDecoder> stream;
+        if (other.decks[i].stream) {
+            stream = open_decoder(i);
+            decks[i].stream = stream ? stream.get() : nullptr;
+        }
+        if (stream || i == active_deck) {
+            DeckMixer::Command load = DeckMixer::Command::load(i, std::move(stream), 0);
+            mixer.apply(load);
+        }
+    }
+}
+
+// A decoder over the deck's track at the deck's tempo (empty if the deck is empty)
+PointerWrapper<StreamingDecoder> MixingEngineService::open_decoder(size_t deck) const {
+    if (!decks[deck].get()) {
+        return PointerWrapper<StreamingDecoder>();
+    }
+    PointerWrapper<TrackStream> stream = decks[deck].get()->open_stream();
+    if (stream && decks[deck].tempo != 1.0) {
+        stream = PointerWrapper<TrackStream>(new TimeStretchStream(std::move(stream), decks[deck].tempo));
     }
+    return PointerWrapper<StreamingDecoder>(new StreamingDecoder(std::move(stream)));
+}
+
+// Hand a command to the mixer thread, or carry it out here; either way the
+// decoder it replaces is freed on this thread
+void MixingEngineService::submit(DeckMixer::Command&& command) {
+    if (mixer_thread) {
+        mixer_thread->send(std::move(command));
+        return;
+    }
+    mixer.apply(command);
+    command.stream.reset();
+}
+
+bool MixingEngineService::start_mixer_thread(double sample_rate, size_t callback_frames,
+                                             const MixerThread::Sink& sink, bool paced) {
+    if (!streaming || mixer_thread) {
+        return false;
+    }
+    mixer_thread.reset(new MixerThread(mixer, sample_rate, callback_frames, sink, paced));
+    return true;
+}
+
+void MixingEngineService::stop_mixer_thread() {
+    if (mixer_thread) {
+        mixer_thread->stop();
+        mixer_thread.reset();
+    }
+}
+
+void MixingEngineService::set_crossfade(int seconds, CrossfadeRenderer::Curve curve) {
+    crossfade_seconds = seconds;
+    crossfade_curve = curve;
+    submit(DeckMixer::Command::crossfader(curve));
+}
+
+void MixingEngineService::set_deck_count(size_t count) {
+    count = std::max<size_t>(1, count);
+    stop_mixer_thread();
+    decks.clear();
+    decks.resize(count);
+    policy->reset(count);
+    active_deck = 0;
+    mixer.set_deck_count(count);
+}
+
+bool MixingEngineService::set_deck_policy(const std::string& name) {
+    PointerWrapper<DeckPolicy> created = DeckPolicy::create(name);
+    if (!created) {
+        return false;
+    }
+    created->reset(decks.size());
+    policy = std::move(created);
+    return true;
+}
+
+bool MixingEngineService::any_deck_loaded() const {
+    for (const Deck& deck : decks) {
+        if (deck.get()) {
+            return true;
+        }
+    }
+    return false;
 }
 
 
@@ -64,44 +186,121 @@ MixingEngineService::MixingEngineService(const MixingEngineService& other):  dec
  * @return: Index of the deck where track was loaded, or -1 on failure
  */
 int MixingEngineService::loadTrackToDeck(const AudioTrack& track) {
-    bool first_track = !decks[0] && !decks[1];
-    size_t target;
-    if (first_track){
-        target = 0;
-        active_deck = 0;
-    }
-    else{
-        target = 1 - active_deck;
-    }
-
-    std::cout << "\n=== Loading Track to Deck ===" << std::endl;
-
     PointerWrapper<AudioTrack> wrap_track;
     wrap_track = track.clone();
     if (!wrap_track){
         std::cout << "[ERROR] Track: \""<< track.get_title() << "\" failed to clone" << std::endl;
         return -1;
     }
+    return loadTrackToDeck(std::move(wrap_track));
+}
 
-    std::cout << "[Deck Switch] Target deck: "<< target << std::endl;
-
-    if (!first_track){
-        if (decks[target]){
-            delete decks[target];
-            decks[target] = nullptr;
-        }
+int MixingEngineService::loadTrackToDeck(PointerWrapper<AudioTrack>&& track) {
+    if (!track) {
+        std::cout << "[ERROR] No track to load" << std::endl;
+        return -1;
     }
+    PointerWrapper<AudioTrack> wrap_track = std::move(track);
+    size_t target = begin_load();
+    Deck& deck = decks[target];
 
     wrap_track->load();
     wrap_track->analyze_beatgrid();
 
-    bool active_deck_exists = decks[active_deck];
-    if (active_deck_exists && auto_sync && !can_mix_tracks(wrap_track)){
+    if (retunes(*wrap_track, target)) {
+        int original_bpm = mixing_bpm(*wrap_track);
         sync_bpm(wrap_track);
+        if (original_bpm > 0) {
+            deck.tempo = std::max(TimeStretcher::MIN_RATIO, std::min(TimeStretcher::MAX_RATIO,
+                                  static_cast<double>(wrap_track->get_bpm()) / original_bpm));
+        }
     }
-    decks[target] = wrap_track.release();
+    deck.track = std::move(wrap_track);
+    return finish_load(target);
+}
 
-    std::cout << "[Load Complete] \'" << decks[target]->get_title() << "\' is now loaded on deck "<< target << std::endl;
+int MixingEngineService::loadTrackToDeck(TrackHandle track) {
+    if (!track) {
+        std::cout << "[ERROR] No track to load" << std::endl;
+        return -1;
+    }
+    if (!can_borrow(*track)) {
+        return loadTrackToDeck(*track);
+    }
+    size_t target = begin_load();
+    std::cout << "[Deck Load] Playing the cached copy of \'" << track->get_title() << "\' in place" << std::endl;
+    decks[target].pinned = std::move(track);
+    return finish_load(target);
+}
+
+bool MixingEngineService::can_borrow(const AudioTrack& track) const {
+    size_t active = any_deck_loaded() ? active_deck : DeckPolicy::NO_DECK;
+    size_t target = policy->target(active);
+    return track.get_beat_grid() && (active == DeckPolicy::NO_DECK || !retunes(track, target));
+}
+
+// A track loaded to target is synced when the active deck stays loaded and the BPMs do not mix
+bool MixingEngineService::retunes(const AudioTrack& track, size_t target) const {
+    return auto_sync && target != active_deck && decks[active_deck].get() && !tempo_matches(track);
+}
+
+// Pick the deck for the next load and empty it
+size_t MixingEngineService::begin_load() {
+    bool first_track = !any_deck_loaded();
+    size_t target = policy->target(first_track ? DeckPolicy::NO_DECK : active_deck);
+    if (first_track){
+        active_deck = target;
+    }
+
+    std::cout << "\n=== Loading Track to Deck ===" << std::endl;
+    std::cout << "[Deck Switch] Target deck: "<< target << std::endl;
+
+    Deck& deck = decks[target];
+    deck.stream = nullptr;   // Its decoder plays on until the load command replaces it
+    deck.track.reset();
+    deck.pinned.reset();
+    deck.tempo = 1.0;
+    return target;
+}
+
+// Start the target deck's stream and transition, then make it the active deck
+int MixingEngineService::finish_load(size_t target) {
+    Deck& deck = decks[target];
+    policy->onLoad(target);
+
+    PointerWrapper<StreamingDecoder> stream;
+    if (streaming) {
+        // Playback may start once the first chunk is decoded, not the whole track
+        stream = open_decoder(target);
+        bool ready = stream->wait_ready(std::chrono::milliseconds(1000));
+        std::cout << "[Streaming] Deck " << target << (ready ? " ready: " : " still buffering: ")
+                  << stream->chunks() << " chunks x " << stream->chunk_frames() << " frames ("
+                  << stream->buffer_bytes() << " bytes) for " << stream->length() << " frames" << std::endl;
+        if (deck.tempo != 1.0) {
+            std::cout << "[Time Stretch] Deck " << target << " plays at x" << deck.tempo
+                      << " (WSOLA, pitch unchanged)" << std::endl;
+        }
+    }
+
+    const AudioTrack* playing = target != active_deck ? decks[active_deck].get() : nullptr;
+    if (playing && !KeyDetector::compatible(playing->get_camelot_key(), deck.get()->get_camelot_key())) {
+        std::cout << "[Key Clash] " << HarmonicKey::name(playing->get_camelot_key()) << " -> "
+                  << HarmonicKey::name(deck.get()->get_camelot_key())
+                  << " are not neighbours on the Camelot wheel" << std::endl;
+    }
+
+    std::cout << "[Load Complete] \'" << deck.get()->get_title() << "\' is now loaded on deck "<< target << std::endl;
+
+    // Every deck still audible fades out from its current gain under the new one
+    size_t fade_frames = 0;
+    if (target != active_deck && decks[active_deck].get() && stream) {
+        fade_frames = static_cast<size_t>(std::max(0, crossfade_seconds) * stream->sample_rate());
+        std::cout << "[Crossfade] Deck " << active_deck << " -> deck " << target << " over "
+                  << crossfade_seconds << " s (" << CrossfadeRenderer::curveName(crossfade_curve) << ", "
+                  << fade_frames << " frames)" << std::endl;
+    }
+    deck.stream = stream ? stream.get() : nullptr;
+    submit(DeckMixer::Command::load(target, std::move(stream), fade_frames));
 
     active_deck = target;
     std::cout << "[Active Deck] Switched to deck "<< target << std::endl;
@@ -110,14 +309,72 @@ int MixingEngineService::loadTrackToDeck(const AudioTrack& track) {
     
 
 
+size_t MixingEngineService::read_deck(size_t deck, double* out, size_t frames) {
+    return mixer_thread ? 0 : mixer.read(deck, out, frames);
+}
+
+size_t MixingEngineService::render(double* out, size_t frames) {
+    return mixer_thread ? 0 : mixer.render(out, frames);
+}
+
+bool MixingEngineService::set_deck_tempo(size_t deck, double tempo) {
+    if (deck >= decks.size() || !decks[deck].stream || !decks[deck].get()) {
+        return false;
+    }
+    Deck& target = decks[deck];
+    PointerWrapper<TrackStream> source = target.get()->open_stream();
+    if (!source) {
+        return false;
+    }
+    tempo = std::max(TimeStretcher::MIN_RATIO, std::min(TimeStretcher::MAX_RATIO, tempo));
+
+    // Frames played so far at the old tempo, in frames of the track
+    const uint64_t position = target.stream->played_frames();
+    uint64_t offset = static_cast<uint64_t>(position * target.tempo);
+    std::vector<double> scratch(StreamingDecoder::DEFAULT_CHUNK_FRAMES);
+    while (offset > 0) {
+        const size_t n = source->read(scratch.data(), static_cast<size_t>(std::min<uint64_t>(scratch.size(), offset)));
+        if (n == 0) {
+            break;
+        }
+        offset -= n;
+    }
+    if (tempo != 1.0) {
+        source = PointerWrapper<TrackStream>(new TimeStretchStream(std::move(source), tempo));
+    }
+    PointerWrapper<StreamingDecoder> stream(new StreamingDecoder(std::move(source)));
+    stream->wait_ready(std::chrono::milliseconds(1000));
+
+    std::cout << "[Sync] Deck " << deck << " retimed from x" << target.tempo << " to x" << tempo
+              << " at frame " << position << std::endl;
+    const double skip_ratio = target.tempo / tempo;
+    target.tempo = tempo;
+    target.stream = stream.get();
+    submit(DeckMixer::Command::sync(deck, std::move(stream), position, skip_ratio));
+    return true;
+}
+
+bool MixingEngineService::unload_deck(size_t deck) {
+    if (deck >= decks.size() || !decks[deck].get()) {
+        return false;
+    }
+    decks[deck].stream = nullptr;
+    decks[deck].track.reset();
+    decks[deck].pinned.reset();
+    decks[deck].tempo = 1.0;
+    submit(DeckMixer::Command::unload(deck));
+    return true;
+}
+
+
 /**
  * @brief Display current deck status
  */
 void MixingEngineService::displayDeckStatus() const {
     std::cout << "\n=== Deck Status ===\n";
-    for (size_t i = 0; i < 2; ++i) {
-        if (decks[i])
-            std::cout << "Deck " << i << ": " << decks[i]->get_title() << "\n";
+    for (size_t i = 0; i < decks.size(); ++i) {
+        if (decks[i].get())
+            std::cout << "Deck " << i << ": " << decks[i].get()->get_title() << "\n";
         else
             std::cout << "Deck " << i << ": [EMPTY]\n";
     }
@@ -126,19 +383,29 @@ void MixingEngineService::displayDeckStatus() const {
 }
 
 /**
- * TODO: Implement can_mix_tracks method
- * 
- * Check if two tracks can be mixed based on BPM difference.
- * 
+ * Check if a track can be mixed with the active deck's track.
+ *
  * @param track: Track to check for mixing compatibility
- * @return: true if BPM difference <= tolerance, false otherwise
+ * @return: true if the BPM difference is within bpm_tolerance and the Camelot
+ * keys are compatible (a track with an unknown key is judged on BPM alone);
+ * false otherwise, or if the active deck is empty
  */
 bool MixingEngineService::can_mix_tracks(const PointerWrapper<AudioTrack>& track) const {
-    if (!decks[active_deck] || !track){
+    return track && can_mix(*track);
+}
+
+bool MixingEngineService::can_mix(const AudioTrack& track) const {
+    return tempo_matches(track) && KeyDetector::compatible(decks[active_deck].get()->get_camelot_key(),
+                                                           track.get_camelot_key());
+}
+
+// BPM criterion alone: the part of can_mix that sync_bpm can fix
+bool MixingEngineService::tempo_matches(const AudioTrack& track) const {
+    if (!decks[active_deck].get()){
         return false;
     }
-    int deck_bpm = decks[active_deck]->get_bpm();
-    int track_bpm = track->get_bpm(); 
+    int deck_bpm = mixing_bpm(*decks[active_deck].get(), decks[active_deck].tempo);
+    int track_bpm = mixing_bpm(track);
     return std::abs(deck_bpm-track_bpm)<=bpm_tolerance;//deck_bpm - track_bpm <= bpm_tolerance) || (track_bpm - deck_bpm <= bpm_tolerance);
 }
 
@@ -147,9 +414,9 @@ bool MixingEngineService::can_mix_tracks(const PointerWrapper<AudioTrack>& track
  * @param track: Track to synchronize with active deck
  */
 void MixingEngineService::sync_bpm(const PointerWrapper<AudioTrack>& track) const {
-    if (decks[active_deck] && track){
-        int track_bpm = track->get_bpm();
-        int deck_bpm = decks[active_deck]->get_bpm();
+    if (decks[active_deck].get() && track){
+        int track_bpm = mixing_bpm(*track);
+        int deck_bpm = mixing_bpm(*decks[active_deck].get(), decks[active_deck].tempo);
         int avg_bpm = (track_bpm + deck_bpm) / 2;
         track->set_bpm(avg_bpm);
         std::cout << "[Sync BPM] Syncing BPM from " << track_bpm << " to " << avg_bpm << std::endl;
@@ -0,0 +1,334 @@
+#include "Mp3File.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+const char INDEX_MAGIC[4] = {'D', 'J', 'S', 'K'};
+const uint32_t INDEX_VERSION = 1;
+
+// Seek table file (native byte order): header, then uint32 offsets[frames]
+struct IndexHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t frames;
+    uint32_t reserved;
+    uint64_t file_size;
+    int64_t modified;       // Nanoseconds since the epoch
+    uint64_t audio_bytes;
+};
+
+// Layer III bitrates in kbps by bitrate index (0 = free format, unsupported)
+const unsigned KBPS_MPEG1[15] = {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320};
+const unsigned KBPS_MPEG2[15] = {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160};
+const unsigned RATES_MPEG1[3] = {44100, 48000, 32000};
+
+struct FrameHeader {
+    unsigned version;   // 3 = MPEG-1, 2 = MPEG-2, 0 = MPEG-2.5
+    unsigned rate;
+    unsigned length;    // Whole frame in bytes, header included
+    bool mono;
+    bool crc;
+};
+
+bool read_header(const unsigned char* p, FrameHeader& header) {
+    if (p[0] != 0xFF || (p[1] & 0xE0) != 0xE0) return false;
+    const unsigned version = (p[1] >> 3) & 3;
+    const unsigned layer = (p[1] >> 1) & 3;
+    const unsigned bitrate_index = p[2] >> 4;
+    const unsigned rate_index = (p[2] >> 2) & 3;
+    if (version == 1 || layer != 1 || bitrate_index == 0 || bitrate_index == 15 || rate_index == 3) {
+        return false;
+    }
+    const bool mpeg1 = version == 3;
+    header.version = version;
+    header.rate = RATES_MPEG1[rate_index] >> (mpeg1 ? 0 : version == 2 ? 1 : 2);
+    const unsigned kbps = mpeg1 ? KBPS_MPEG1[bitrate_index] : KBPS_MPEG2[bitrate_index];
+    header.length = (mpeg1 ? 144000 : 72000) * kbps / header.rate + ((p[2] >> 1) & 1);
+    header.mono = (p[3] >> 6) == 3;
+    header.crc = (p[1] & 1) == 0;
+    return true;
+}
+
+size_t side_info_size(bool mpeg1, bool mono) {
+    return mpeg1 ? (mono ? 17 : 32) : (mono ? 9 : 17);
+}
+
+inline uint32_t be32(const unsigned char* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+// MSB-first reader over the side information
+class BitReader {
+public:
+    explicit BitReader(const unsigned char* data) : bytes(data), position(0) {}
+
+    unsigned read(unsigned count) {
+        unsigned value = 0;
+        for (unsigned i = 0; i < count; ++i, ++position) {
+            value = (value << 1) | ((bytes[position >> 3] >> (7 - (position & 7))) & 1);
+        }
+        return value;
+    }
+
+    void skip(unsigned count) { position += count; }
+
+private:
+    const unsigned char* bytes;
+    size_t position;
+};
+
+} // namespace
+
+Mp3File::Mp3File(const std::string& path, const std::string& index_path)
+    : file_path(path), mapped(path, 4), offsets(), audio_end(0), audio_bytes(0),
+      rate(0), channel_count(0), frame_samples(0), mpeg1(false), id3(false), toc_present(false), toc(),
+      loaded(false), saved(false), failure(mapped.error()) {
+    if (!mapped.is_open()) {
+        return;
+    }
+    if (static_cast<uint64_t>(mapped.size()) > UINT32_MAX) {
+        failure = "file too large to index";
+        unmap();
+        return;
+    }
+    mapped.advise_sequential(true);   // The index scan
+    if (!parse()) {
+        unmap();
+        return;
+    }
+    if (!index_path.empty()) {
+        loaded = load_index(index_path, mapped.size(), mapped.modified_ns());
+    }
+    if (!loaded) {
+        // One pass over the frame headers: each frame's length gives the next header
+        const unsigned char* base = static_cast<const unsigned char*>(mapped.data());
+        size_t position = offsets.empty() ? 0 : offsets.front();
+        offsets.clear();
+        FrameHeader header;
+        while (position + 4 <= audio_end) {
+            if (read_header(base + position, header) && header.rate == rate &&
+                (header.version == 3) == mpeg1) {
+                if (position + header.length > audio_end) break;   // Truncated last frame
+                offsets.push_back(static_cast<uint32_t>(position));
+                audio_bytes += header.length;
+                position += header.length;
+            } else {
+                ++position;   // Resynchronize after junk between frames
+            }
+        }
+        if (offsets.empty()) {
+            failure = "no audio frames";
+            unmap();
+            return;
+        }
+        if (!index_path.empty()) {
+            saved = save_index(index_path, mapped.size(), mapped.modified_ns());
+        }
+    }
+    // Scans from here on follow playback or analysis: mostly forward, but seeks jump
+    mapped.advise_sequential(false);
+}
+
+bool Mp3File::parse() {
+    const unsigned char* base = static_cast<const unsigned char*>(mapped.data());
+    const size_t mapped_size = mapped.size();
+    size_t start = 0;
+    audio_end = mapped_size;
+    if (mapped_size >= 10 && std::memcmp(base, "ID3", 3) == 0) {
+        // Synchsafe size: 7 bits per byte, plus a 10-byte footer if flagged
+        size_t size = (static_cast<size_t>(base[6] & 0x7F) << 21) | (static_cast<size_t>(base[7] & 0x7F) << 14) |
+                      (static_cast<size_t>(base[8] & 0x7F) << 7) | static_cast<size_t>(base[9] & 0x7F);
+        start = 10 + size + ((base[5] & 0x10) ? 10 : 0);
+        id3 = true;
+    }
+    if (mapped_size >= 128 && std::memcmp(base + mapped_size - 128, "TAG", 3) == 0) {
+        audio_end = mapped_size - 128;
+        id3 = true;
+    }
+
+    // First frame: a valid header whose successor is also a matching header
+    FrameHeader header, next;
+    size_t position = start;
+    for (; position + 4 <= audio_end; ++position) {
+        if (!read_header(base + position, header)) continue;
+        size_t following = position + header.length;
+        if (following == audio_end || (following + 4 <= audio_end && read_header(base + following, next) &&
+                                       next.version == header.version && next.rate == header.rate)) {
+            break;
+        }
+    }
+    if (position + 4 > audio_end) {
+        failure = "no MPEG Layer III frames";
+        return false;
+    }
+    mpeg1 = header.version == 3;
+    rate = header.rate;
+    channel_count = header.mono ? 1 : 2;
+    frame_samples = mpeg1 ? 1152 : 576;
+
+    // A Xing/Info tag sits where the first frame's main data would start
+    const size_t tag = position + 4 + (header.crc ? 2 : 0) + side_info_size(mpeg1, header.mono);
+    if (tag + 8 <= audio_end && (std::memcmp(base + tag, "Xing", 4) == 0 || std::memcmp(base + tag, "Info", 4) == 0)) {
+        const uint32_t flags = be32(base + tag + 4);
+        size_t field = tag + 8 + ((flags & 1) ? 4 : 0) + ((flags & 2) ? 4 : 0);
+        if ((flags & 4) && field + 100 <= audio_end) {
+            std::memcpy(toc, base + field, sizeof(toc));
+            toc_present = true;
+        }
+        position += header.length;
+    }
+    offsets.assign(1, static_cast<uint32_t>(position));   // Where the scan starts
+    return true;
+}
+
+bool Mp3File::load_index(const std::string& index_path, uint64_t file_size, int64_t modified) {
+    std::ifstream in(index_path.c_str(), std::ios::binary);
+    IndexHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 || header.version != INDEX_VERSION ||
+        header.file_size != file_size || header.modified != modified || header.frames == 0) {
+        return false;
+    }
+    std::vector<uint32_t> table(header.frames);
+    if (!in.read(reinterpret_cast<char*>(table.data()), table.size() * sizeof(uint32_t))) {
+        return false;
+    }
+    // Spot check both ends of the table against the file
+    const unsigned char* base = static_cast<const unsigned char*>(mapped.data());
+    FrameHeader first, last;
+    if (table.front() + 4 > audio_end || table.back() + 4 > audio_end ||
+        !read_header(base + table.front(), first) || !read_header(base + table.back(), last) ||
+        table.back() + last.length > audio_end) {
+        return false;
+    }
+    offsets.swap(table);
+    audio_bytes = header.audio_bytes;
+    return true;
+}
+
+bool Mp3File::save_index(const std::string& index_path, uint64_t file_size, int64_t modified) const {
+    std::string temp_path = index_path + ".tmp";
+    std::ofstream out(temp_path.c_str(), std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+    IndexHeader header;
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = INDEX_VERSION;
+    header.frames = static_cast<uint32_t>(offsets.size());
+    header.reserved = 0;
+    header.file_size = file_size;
+    header.modified = modified;
+    header.audio_bytes = audio_bytes;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint32_t));
+    out.close();
+    if (!out || std::rename(temp_path.c_str(), index_path.c_str()) != 0) {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+int Mp3File::average_kbps() const {
+    const double seconds = duration();
+    return seconds > 0.0 ? static_cast<int>(std::lround(audio_bytes * 8.0 / seconds / 1000.0)) : 0;
+}
+
+uint32_t Mp3File::frame_at(double seconds) const {
+    if (offsets.empty() || seconds <= 0.0) return 0;
+    const double frame = seconds / frame_duration();
+    return frame >= offsets.size() ? frame_count() - 1 : static_cast<uint32_t>(frame);
+}
+
+const unsigned char* Mp3File::frame_data(uint32_t index) const {
+    return static_cast<const unsigned char*>(mapped.data()) + offsets[index];
+}
+
+size_t Mp3File::frame_size(uint32_t index) const {
+    FrameHeader header;
+    return read_header(frame_data(index), header) ? header.length : 0;
+}
+
+size_t Mp3File::side_info_offset(const unsigned char* frame) const {
+    return (frame[1] & 1) == 0 ? 6 : 4;
+}
+
+Mp3File::FrameRange Mp3File::decode_range(double start_seconds, double end_seconds) const {
+    FrameRange range = {0, 0, 0};
+    if (offsets.empty() || end_seconds <= start_seconds) return range;
+    range.begin = frame_at(start_seconds);
+    const double last = std::ceil(end_seconds / frame_duration());
+    range.end = last >= offsets.size() ? frame_count() : std::max(range.begin + 1, static_cast<uint32_t>(last));
+    // main_data_begin: how many bytes of this frame's main data sit in earlier frames
+    const unsigned char* frame = frame_data(range.begin);
+    BitReader bits(frame + side_info_offset(frame));
+    size_t needed = bits.read(mpeg1 ? 9 : 8);
+    range.first = range.begin;
+    while (range.first > 0 && needed > 0) {
+        --range.first;
+        const unsigned char* previous = frame_data(range.first);
+        size_t overhead = side_info_offset(previous) + side_info_size(mpeg1, (previous[3] >> 6) == 3);
+        size_t size = frame_size(range.first);
+        size_t main_data = size > overhead ? size - overhead : 0;
+        needed = main_data >= needed ? 0 : needed - main_data;
+    }
+    // The first output granule also overlap-adds the previous frame's MDCT tail
+    if (range.first == range.begin && range.first > 0) {
+        --range.first;
+    }
+    return range;
+}
+
+uint64_t Mp3File::toc_offset(double seconds) const {
+    if (offsets.empty()) return 0;
+    const double total = duration();
+    double percent = total > 0.0 ? seconds / total * 100.0 : 0.0;
+    percent = percent < 0.0 ? 0.0 : percent > 99.999 ? 99.999 : percent;
+    double fraction = percent / 100.0;
+    if (toc_present) {
+        // Linear interpolation between TOC entries (each a 1/256 fraction of the file)
+        const unsigned a = static_cast<unsigned>(percent);
+        const double fa = toc[a];
+        const double fb = a < 99 ? toc[a + 1] : 256.0;
+        fraction = (fa + (fb - fa) * (percent - a)) / 256.0;
+    }
+    return offsets.front() + static_cast<uint64_t>(fraction * static_cast<double>(audio_bytes));
+}
+
+void Mp3File::granule_energy(uint32_t first, uint32_t count, double* out) const {
+    const unsigned granules = granules_per_frame();
+    for (uint32_t f = 0; f < count; ++f) {
+        const unsigned char* frame = frame_data(first + f);
+        const unsigned frame_channels = (frame[3] >> 6) == 3 ? 1 : 2;
+        BitReader bits(frame + side_info_offset(frame));
+        // main_data_begin, private bits, scfsi (MPEG-1 only)
+        if (mpeg1) {
+            bits.skip(9 + (frame_channels == 1 ? 5 : 3) + 4 * frame_channels);
+        } else {
+            bits.skip(8 + frame_channels);
+        }
+        for (unsigned gr = 0; gr < granules; ++gr) {
+            double energy = 0.0;
+            for (unsigned ch = 0; ch < frame_channels; ++ch) {
+                const unsigned coded_bits = bits.read(12);    // part2_3_length
+                bits.skip(9);                                 // big_values
+                const unsigned global_gain = bits.read(8);
+                // scalefac_compress, block/region fields and the trailing flags
+                bits.skip(mpeg1 ? 4 + 1 + 22 + 3 : 9 + 1 + 22 + 2);
+                energy += std::exp2((static_cast<double>(global_gain) - 210.0) / 2.0) * coded_bits;
+            }
+            out[f * granules + gr] = energy;
+        }
+    }
+}
+
+void Mp3File::unmap() {
+    mapped.reset();
+    offsets.clear();
+}
@@ -0,0 +1,66 @@
+#include "PcmRingBuffer.h"
+#include <algorithm>
+#include <cstring>
+
+PcmRingBuffer::PcmRingBuffer(size_t chunk_frames, size_t chunks)
+    : chunk_size(std::max<size_t>(1, chunk_frames)), samples(chunk_size * std::max<size_t>(1, chunks)),
+      slots(std::max<size_t>(1, chunks), 0), written(0), consumed(0), read_offset(0) {}
+
+double* PcmRingBuffer::write_slot() {
+    const size_t head = written.load(std::memory_order_relaxed);
+    if (head - consumed.load(std::memory_order_acquire) >= slots.size()) {
+        return nullptr;
+    }
+    return samples.data() + (head % slots.size()) * chunk_size;
+}
+
+void PcmRingBuffer::publish(size_t frames) {
+    const size_t head = written.load(std::memory_order_relaxed);
+    slots[head % slots.size()] = std::min(frames, chunk_size);
+    written.store(head + 1, std::memory_order_release);
+}
+
+size_t PcmRingBuffer::read(double* out, size_t frames) {
+    return consume(out, frames);
+}
+
+size_t PcmRingBuffer::discard(size_t frames) {
+    return consume(nullptr, frames);
+}
+
+size_t PcmRingBuffer::consume(double* out, size_t frames) {
+    size_t copied = 0;
+    size_t tail = consumed.load(std::memory_order_relaxed);
+    const size_t head = written.load(std::memory_order_acquire);
+    while (copied < frames && tail != head) {
+        const size_t slot = tail % slots.size();
+        const size_t available = slots[slot] - read_offset;
+        const size_t count = std::min(available, frames - copied);
+        if (out) {
+            std::memcpy(out + copied, samples.data() + slot * chunk_size + read_offset, count * sizeof(double));
+        }
+        copied += count;
+        read_offset += count;
+        if (read_offset == slots[slot]) {
+            // Chunk drained: return the slot to the producer
+            read_offset = 0;
+            consumed.store(++tail, std::memory_order_release);
+        }
+    }
+    return copied;
+}
+
+size_t PcmRingBuffer::buffered() const {
+    size_t tail = consumed.load(std::memory_order_acquire);
+    const size_t head = written.load(std::memory_order_acquire);
+    size_t frames = 0;
+    for (; tail != head; ++tail) {
+        frames += slots[tail % slots.size()];
+    }
+    return frames - read_offset;
+}
+
+void PcmRingBuffer::clear() {
+    read_offset = 0;
+    consumed.store(written.load(std::memory_order_acquire), std::memory_order_release);
+}
@@ -3,7 +3,7 @@
 #include <iostream>
 #include <algorithm>
 Playlist::Playlist(const std::string& name) 
-    : head(nullptr), playlist_name(name), track_count(0) {
+    : head(nullptr), playlist_name(name), track_count(0), by_id() {
     std::cout << "Created playlist: " << name << std::endl;
 }
 // TODO: Fix memory leaks!
@@ -21,7 +21,8 @@ Playlist::~Playlist() {
     }
 }
 
-Playlist::Playlist(const Playlist& other) : head(nullptr), playlist_name(other.playlist_name), track_count(other.track_count){
+Playlist::Playlist(const Playlist& other)
+    : head(nullptr), playlist_name(other.playlist_name), track_count(other.track_count), by_id() {
     PlaylistNode* curr_other = other.head;
     PlaylistNode* last_new_node = nullptr;
     while (curr_other){
@@ -40,6 +41,7 @@ Playlist::Playlist(const Playlist& other) : head(nullptr), playlist_name(other.p
         last_new_node = new_node;
         curr_other = curr_other->next;
     }
+    rebuild_id_index();
 }
 
 Playlist& Playlist::operator=(const Playlist& other){
@@ -52,12 +54,15 @@ Playlist& Playlist::operator=(const Playlist& other){
 
         playlist_name = new_copy.playlist_name;
         track_count = new_copy.track_count;
+        by_id.swap(new_copy.by_id);
     }
     return *this;
 }
 
 
-Playlist::Playlist(Playlist&& other) noexcept : head(other.head), playlist_name(std::move(other.playlist_name)), track_count(other.track_count) {
+Playlist::Playlist(Playlist&& other) noexcept
+    : head(other.head), playlist_name(std::move(other.playlist_name)), track_count(other.track_count),
+      by_id(std::move(other.by_id)) {
     other.head = nullptr;
     other.track_count = 0;
 }
@@ -73,6 +78,7 @@ Playlist& Playlist::operator=(Playlist&& other) noexcept {
         head = other.head;
         playlist_name = std::move(other.playlist_name);
         track_count = other.track_count;
+        by_id = std::move(other.by_id);
 
         other.head = nullptr;
         other.track_count = 0;
@@ -94,6 +100,14 @@ void Playlist::add_track(AudioTrack* track) {
     new_node->next = head;
     head = new_node;
     track_count++;
+    // The new head is now the first track with its ID
+    TrackId id = track->get_id();
+    if (id != INVALID_TRACK_ID) {
+        if (id >= by_id.size()) {
+            by_id.resize(id + 1, nullptr);
+        }
+        by_id[id] = track;
+    }
 
     std::cout << "Added '" << track->get_title() << "' to playlist '" 
               << playlist_name << "'" << std::endl;
@@ -116,8 +130,13 @@ void Playlist::remove_track(const std::string& title) {
         } else {
             head = current->next;
         }
+        TrackId id = current->track->get_id();
+        bool indexed = id != INVALID_TRACK_ID && by_id[id] == current->track;
         delete current->track;
         delete current;
+        if (indexed) {
+            rebuild_id_index();
+        }
 
         track_count--;
         std::cout << "Removed '" << title << "' from playlist" << std::endl;
@@ -173,6 +192,32 @@ AudioTrack* Playlist::find_track(const std::string& title) const {
     return nullptr;
 }
 
+AudioTrack* Playlist::find_track(TrackId id) const {
+    return id < by_id.size() ? by_id[id] : nullptr;
+}
+
+void Playlist::reserve_ids(size_t id_count) {
+    if (id_count > by_id.size()) {
+        by_id.resize(id_count, nullptr);
+    }
+}
+
+void Playlist::rebuild_id_index() {
+    by_id.clear();
+    for (PlaylistNode* current = head; current; current = current->next) {
+        TrackId id = current->track ? current->track->get_id() : INVALID_TRACK_ID;
+        if (id == INVALID_TRACK_ID) {
+            continue;
+        }
+        if (id >= by_id.size()) {
+            by_id.resize(id + 1, nullptr);
+        }
+        if (!by_id[id]) {
+            by_id[id] = current->track;
+        }
+    }
+}
+
 int Playlist::get_total_duration() const {
     int total = 0;
     PlaylistNode* current = head;
@@ -2,6 +2,7 @@
 #include <iostream>
 #include <sstream>
 #include <algorithm>
+#include <stdexcept>
 
 // ========== PUBLIC METHODS (PROVIDED FOR STUDENTS) ==========
 
@@ -51,6 +52,41 @@ bool SessionFileParser::parse_config_file(const std::string& config_path, Sessio
                     std::cout << "[WARNING] Invalid cache size at line " << line_number << std::endl;
                 }
                 
+            } else if (key == "controller_cache_policy") {
+                config.controller_cache_policy = value;
+                
+            } else if (key == "controller_cache_shards") {
+                try {
+                    config.controller_cache_shards = std::stoi(value);
+                } catch (const std::exception& e) {
+                    std::cout << "[WARNING] Invalid cache shard count at line " << line_number << std::endl;
+                }
+                
+            } else if (key == "controller_cache_bytes") {
+                try {
+                    // stoull accepts a sign and would wrap "-1" around to 2^64 - 1
+                    size_t first = value.find_first_not_of(" \t");
+                    if (first != std::string::npos && value[first] == '-') {
+                        throw std::invalid_argument(value);
+                    }
+                    config.controller_cache_bytes = std::stoull(value);
+                } catch (const std::exception& e) {
+                    std::cout << "[WARNING] Invalid cache byte budget at line " << line_number << std::endl;
+                }
+                
+            } else if (key == "prefetch_lookahead") {
+                try {
+                    config.prefetch_lookahead = std::stoi(value);
+                } catch (const std::exception& e) {
+                    std::cout << "[WARNING] Invalid prefetch lookahead at line " << line_number << std::endl;
+                }
+                
+            } else if (key == "controller_cache_snapshot") {
+                config.controller_cache_snapshot = value;
+                
+            } else if (key == "waveform_format") {
+                config.waveform_format = value;
+                
             } else if (key == "bpm_tolerance") {
                 try {
                     config.bpm_tolerance = std::stoi(value);
@@ -61,6 +97,53 @@ bool SessionFileParser::parse_config_file(const std::string& config_path, Sessio
             } else if (key == "auto_sync") {
                 config.auto_sync = parse_bool(value);
                 
+            } else if (key == "deck_streaming") {
+                config.deck_streaming = parse_bool(value);
+                
+            } else if (key == "default_crossfade_time") {
+                try {
+                    config.default_crossfade_time = std::stoi(value);
+                } catch (const std::exception& e) {
+                    std::cout << "[WARNING] Invalid crossfade time at line " << line_number << std::endl;
+                }
+                
+            } else if (key == "crossfade_curve") {
+                config.crossfade_curve = value;
+                
+            } else if (key == "deck_count") {
+                try {
+                    config.deck_count = std::stoi(value);
+                } catch (const std::exception& e) {
+                    std::cout << "[WARNING] Invalid deck count at line " << line_number << std::endl;
+                }
+                
+            } else if (key == "deck_policy") {
+                config.deck_policy = value;
+                
+            } else if (key == "mixdown_sample_rate") {
+                try {
+                    config.mixdown_sample_rate = std::stoi(value);
+                } catch (const std::exception& e) {
+                    std::cout << "[WARNING] Invalid mixdown sample rate at line " << line_number << std::endl;
+                }
+                
+            } else if (key == "mixdown_threads") {
+                try {
+                    config.mixdown_threads = std::stoi(value);
+                } catch (const std::exception& e) {
+                    std::cout << "[WARNING] Invalid mixdown thread count at line " << line_number << std::endl;
+                }
+                
+            } else if (key == "realtime_mixer") {
+                config.realtime_mixer = parse_bool(value);
+                
+            } else if (key == "mixer_callback_frames") {
+                try {
+                    config.mixer_callback_frames = std::stoi(value);
+                } catch (const std::exception& e) {
+                    std::cout << "[WARNING] Invalid mixer callback size at line " << line_number << std::endl;
+                }
+                
             } else {
                 // Check if it's a playlist definition (any other key=value where value contains numbers/commas)
                 std::string playlist_name;
@@ -175,6 +258,7 @@ bool SessionFileParser::parse_key_value(const std::string& line, std::string& ke
 bool SessionFileParser::parse_library_track(const std::string& line, SessionConfig::TrackInfo& track_info) {
     // Expected format: MP3,title,{artist1;artist2;},duration,bpm,bitrate,has_tags
     // or: WAV,title,{artist1;artist2;},duration,bpm,sample_rate,bit_depth
+    // optionally followed by the path of the audio file: ...,bit_depth,path/to/file.wav
     
     std::vector<std::string> parts = split_string(line, ',');
     
@@ -193,6 +277,7 @@ bool SessionFileParser::parse_library_track(const std::string& line, SessionConf
         track_info.bpm = std::stoi(parts[4]);
         track_info.extra_param1 = std::stoi(parts[5]);  // bitrate or sample_rate
         track_info.extra_param2 = std::stoi(parts[6]);  // has_tags or bit_depth
+        track_info.file_path = parts.size() > 7 ? trim_string(parts[7]) : "";
         
         // Validate track type is MP3 or WAV
         if (track_info.type != "MP3" && track_info.type != "WAV") {
@@ -0,0 +1,62 @@
+#include "ShadowCache.h"
+#include "CacheSlot.h"
+
+ShadowCache::ShadowCache(PointerWrapper<CachePolicy> policy, size_t capacity, size_t byte_budget)
+    : policy(std::move(policy)), index(), keys(capacity, INVALID_TRACK_ID), weights(capacity, 0), free_slots(),
+      resident(0), oversized(INVALID_TRACK_ID), max_bytes(byte_budget),
+      used_bytes(0), hit_count(0), miss_count(0) {
+    this->policy->reset(capacity);
+    for (size_t i = capacity; i-- > 0; ) {
+        free_slots.push_back(i);
+    }
+}
+
+bool ShadowCache::access(TrackId id, size_t weight) {
+    if (id >= index.size()) {
+        index.resize(id + 1, CacheSlot::npos);
+    }
+    if (index[id] != CacheSlot::npos) {
+        policy->onHit(index[id]);
+        hit_count++;
+        return true;
+    }
+    if (id == oversized) {
+        hit_count++;
+        return true;
+    }
+    miss_count++;
+    weight = max_bytes ? weight : 0;
+    if (keys.empty()) {
+        return false;
+    }
+    if (max_bytes && weight > max_bytes) {
+        oversized = id;   // Bypasses the cache, held aside until the next one
+        return false;
+    }
+    policy->onMiss(id);
+    while (resident > 0 && (free_slots.empty() || (max_bytes && used_bytes + weight > max_bytes))) {
+        size_t victim = policy->victim(id);
+        policy->commitVictim(victim);
+        policy->onEvict(victim, keys[victim]);
+        index[keys[victim]] = CacheSlot::npos;
+        keys[victim] = INVALID_TRACK_ID;
+        used_bytes -= weights[victim];
+        weights[victim] = 0;
+        free_slots.push_back(victim);
+        resident--;
+    }
+    size_t slot = free_slots.back();
+    free_slots.pop_back();
+    keys[slot] = id;
+    weights[slot] = weight;
+    used_bytes += weight;
+    index[id] = slot;
+    resident++;
+    policy->onInsert(slot, id);
+    return false;
+}
+
+double ShadowCache::hitRatio() const {
+    size_t total = hit_count + miss_count;
+    return total == 0 ? 0.0 : static_cast<double>(hit_count) / total;
+}
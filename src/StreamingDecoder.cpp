@@ -0,0 +1,95 @@
+#include "StreamingDecoder.h"
+
+constexpr size_t StreamingDecoder::DEFAULT_CHUNK_FRAMES;
+constexpr size_t StreamingDecoder::DEFAULT_CHUNKS;
+
+StreamingDecoder::StreamingDecoder(PointerWrapper<TrackStream> stream, size_t chunk_frames, size_t chunks)
+    : stream(std::move(stream)), ring(chunk_frames, chunks), rate(0.0), total_frames(0), decoded(0), played(0),
+      end_of_stream(false), stopping(false), producer_waiting(false), mutex(), space(), ready(), producer() {
+    if (!this->stream) {
+        end_of_stream = true;
+        return;
+    }
+    rate = this->stream->sample_rate();
+    total_frames = this->stream->length();
+    producer = std::thread(&StreamingDecoder::run, this);
+}
+
+StreamingDecoder::~StreamingDecoder() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    space.notify_all();
+    if (producer.joinable()) {
+        producer.join();
+    }
+}
+
+bool StreamingDecoder::wait_ready(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex);
+    return ready.wait_for(lock, timeout, [this] { return decoded.load() > 0 || end_of_stream.load(); });
+}
+
+size_t StreamingDecoder::read(double* out, size_t frames) {
+    size_t copied = ring.read(out, frames);
+    if (copied > 0) {
+        played.store(played.load(std::memory_order_relaxed) + copied, std::memory_order_relaxed);
+        release_space();
+    }
+    return copied;
+}
+
+size_t StreamingDecoder::skip(size_t frames) {
+    size_t dropped = ring.discard(frames);
+    if (dropped > 0) {
+        played.store(played.load(std::memory_order_relaxed) + dropped, std::memory_order_relaxed);
+        release_space();
+    }
+    return dropped;
+}
+
+void StreamingDecoder::release_space() {
+    // Only the read that ends a full ring notifies: the others cost one load, no
+    // syscall. No lock either: the producer's wait is timed, so a notification
+    // that slips between its check and its wait costs one tick.
+    if (producer_waiting.load(std::memory_order_relaxed) && producer_waiting.exchange(false)) {
+        space.notify_one();
+    }
+}
+
+bool StreamingDecoder::finished() const {
+    return end_of_stream.load() && ring.buffered() == 0;
+}
+
+void StreamingDecoder::run() {
+    const size_t chunk = ring.chunk_frames();
+    while (!stopping.load()) {
+        double* slot = ring.write_slot();
+        if (!slot) {
+            producer_waiting = true;
+            std::unique_lock<std::mutex> lock(mutex);
+            space.wait_for(lock, std::chrono::milliseconds(2),
+                           [this] { return stopping.load() || ring.write_slot() != nullptr; });
+            producer_waiting = false;
+            continue;
+        }
+        size_t frames = stream->read(slot, chunk);
+        if (frames > 0) {
+            ring.publish(frames);
+            decoded += frames;
+        }
+        if (frames < chunk) {
+            end_of_stream = true;
+        }
+        if (frames > 0 && decoded.load() == frames) {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready.notify_all();
+        }
+        if (end_of_stream.load()) {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready.notify_all();
+            return;
+        }
+    }
+}
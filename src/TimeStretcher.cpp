@@ -0,0 +1,233 @@
+#include "TimeStretcher.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+constexpr double TimeStretcher::MIN_RATIO;
+constexpr double TimeStretcher::MAX_RATIO;
+
+namespace {
+
+const double TWO_PI = 6.28318530717958647692;
+const size_t DECIMATION = 4;   // Coarse search step (samples)
+
+double dot(const double* a, const double* b, size_t n) {
+    double sum = 0.0;
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    for (; i + 4 <= n; i += 4) {
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+    sum = lanes[0] + lanes[1];
+#endif
+    for (; i < n; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+// acc[i] += window[i] * in[i]
+void overlap_add(double* acc, const double* in, const double* window, size_t n) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 2 <= n; i += 2) {
+        __m128d term = _mm_mul_pd(_mm_loadu_pd(in + i), _mm_loadu_pd(window + i));
+        _mm_storeu_pd(acc + i, _mm_add_pd(_mm_loadu_pd(acc + i), term));
+    }
+#endif
+    for (; i < n; ++i) {
+        acc[i] += window[i] * in[i];
+    }
+}
+
+// Sums of DECIMATION consecutive samples (a box filter ahead of the coarse search)
+void decimate(const double* in, double* out, size_t count) {
+    for (size_t j = 0; j < count; ++j, in += DECIMATION) {
+        out[j] = in[0] + in[1] + in[2] + in[3];
+    }
+}
+
+} // namespace
+
+TimeStretcher::TimeStretcher(double sample_rate, double ratio)
+    : speed(std::max(MIN_RATIO, std::min(MAX_RATIO, ratio > 0.0 ? ratio : 1.0))), frame(16), hop(0),
+      tolerance(0), window(), input(), base(0), frames_done(0), previous(0), overlap(), output(),
+      output_read(0), skip(0), flushing(false), output_total(UINT64_MAX), output_emitted(0),
+      coarse_natural(), coarse_region() {
+    // Power of two nearest to 23 ms
+    const double target = 0.023 * sample_rate;
+    while (frame * 1.5 < target) {
+        frame *= 2;
+    }
+    hop = frame / 2;
+    tolerance = frame / 4;
+    window.resize(frame);
+    for (size_t i = 0; i < frame; ++i) {
+        window[i] = 0.5 - 0.5 * std::cos(TWO_PI * i / frame);
+    }
+    // hop leading zeros put the first input sample at the peak of frame 0; the
+    // output they produce is dropped, so output time 0 is input time 0
+    input.assign(hop, 0.0);
+    skip = hop;
+    overlap.assign(frame, 0.0);
+    coarse_natural.resize(frame / DECIMATION);
+    coarse_region.resize((frame + 2 * tolerance) / DECIMATION);
+}
+
+int64_t TimeStretcher::nominal(uint64_t k) const {
+    return static_cast<int64_t>(std::llround(static_cast<double>(k) * hop * speed));
+}
+
+size_t TimeStretcher::needed() const {
+    int64_t end = static_cast<int64_t>(frame);
+    if (frames_done > 0) {
+        end = std::max(nominal(frames_done) + static_cast<int64_t>(tolerance + frame),
+                       previous + static_cast<int64_t>(hop + frame));
+    }
+    return end > input_end() ? static_cast<size_t>(end - input_end()) : 0;
+}
+
+void TimeStretcher::write(const double* in, size_t frames) {
+    input.insert(input.end(), in, in + frames);
+}
+
+void TimeStretcher::finish() {
+    if (flushing) {
+        return;
+    }
+    flushing = true;
+    output_total = static_cast<uint64_t>(std::llround((input_end() - static_cast<int64_t>(hop)) / speed));
+}
+
+bool TimeStretcher::done() const {
+    return flushing && output_emitted >= output_total && output_read == output.size();
+}
+
+size_t TimeStretcher::read(double* out, size_t frames) {
+    size_t copied = 0;
+    while (copied < frames) {
+        if (output_read == output.size()) {
+            output.clear();
+            output_read = 0;
+            if (!step()) {
+                break;
+            }
+            continue;
+        }
+        const size_t n = std::min(frames - copied, output.size() - output_read);
+        std::memcpy(out + copied, output.data() + output_read, n * sizeof(double));
+        output_read += n;
+        copied += n;
+    }
+    return copied;
+}
+
+int64_t TimeStretcher::best_start(int64_t target, int64_t natural) {
+    const int64_t lo = std::max(base, target - static_cast<int64_t>(tolerance));
+    const int64_t hi = target + static_cast<int64_t>(tolerance);
+    const double* region = &input[lo - base];
+
+    // Coarse pass: every DECIMATION-th shift of the decimated signals
+    const size_t coarse_frame = coarse_natural.size();
+    const size_t shifts = static_cast<size_t>(hi - lo) / DECIMATION;
+    decimate(&input[natural - base], coarse_natural.data(), coarse_frame);
+    decimate(region, coarse_region.data(), coarse_frame + shifts);
+    size_t coarse_best = 0;
+    double best_score = -HUGE_VAL;
+    for (size_t c = 0; c <= shifts; ++c) {
+        double score = dot(coarse_natural.data(), coarse_region.data() + c, coarse_frame);
+        if (score > best_score) {
+            best_score = score;
+            coarse_best = c;
+        }
+    }
+
+    // Fine pass around it at full rate
+    const int64_t centre = lo + static_cast<int64_t>(coarse_best * DECIMATION);
+    const int64_t first = std::max(lo, centre - static_cast<int64_t>(DECIMATION - 1));
+    const int64_t last = std::min(hi, centre + static_cast<int64_t>(DECIMATION - 1));
+    const double* continuation = &input[natural - base];
+    int64_t best = centre;
+    best_score = -HUGE_VAL;
+    for (int64_t start = first; start <= last; ++start) {
+        double score = dot(continuation, &input[start - base], frame);
+        if (score > best_score) {
+            best_score = score;
+            best = start;
+        }
+    }
+    return best;
+}
+
+bool TimeStretcher::step() {
+    if (output_emitted >= output_total) {
+        return false;
+    }
+    const size_t missing = needed();
+    if (missing > 0) {
+        if (!flushing) {
+            return false;
+        }
+        input.resize(input.size() + missing, 0.0);   // Past the end: silence
+    }
+
+    const int64_t target = nominal(frames_done);
+    const int64_t start = frames_done == 0 ? 0 : best_start(target, previous + static_cast<int64_t>(hop));
+    overlap_add(overlap.data(), &input[start - base], window.data(), frame);
+
+    // The first hop of the accumulator has all its contributions
+    size_t first = std::min(skip, hop);
+    skip -= first;
+    const size_t count = static_cast<size_t>(std::min<uint64_t>(hop - first, output_total - output_emitted));
+    output.insert(output.end(), overlap.begin() + first, overlap.begin() + first + count);
+    output_emitted += count;
+    std::memmove(overlap.data(), overlap.data() + hop, hop * sizeof(double));
+    std::fill(overlap.begin() + hop, overlap.end(), 0.0);
+
+    previous = start;
+    ++frames_done;
+
+    // Drop input no later frame can reach (in batches, to keep the erase amortized)
+    const int64_t keep = std::max(base, std::min(nominal(frames_done) - static_cast<int64_t>(tolerance),
+                                                 previous + static_cast<int64_t>(hop)));
+    if (keep - base >= static_cast<int64_t>(4 * frame)) {
+        input.erase(input.begin(), input.begin() + (keep - base));
+        base = keep;
+    }
+    return true;
+}
+
+// ========== TimeStretchStream ==========
+
+TimeStretchStream::TimeStretchStream(PointerWrapper<TrackStream> source, double ratio)
+    : source(std::move(source)), stretcher(this->source->sample_rate(), ratio), chunk(4096), total(0), next(0) {
+    total = static_cast<uint64_t>(std::llround(this->source->length() / stretcher.ratio()));
+}
+
+size_t TimeStretchStream::read(double* out, size_t frames) {
+    size_t done = 0;
+    while (done < frames) {
+        done += stretcher.read(out + done, frames - done);
+        if (done == frames || stretcher.done()) {
+            break;
+        }
+        // The stretcher needs more input
+        size_t got = source->read(chunk.data(), chunk.size());
+        if (got > 0) {
+            stretcher.write(chunk.data(), got);
+        }
+        if (got < chunk.size()) {
+            stretcher.finish();
+        }
+    }
+    next += done;
+    return done;
+}
@@ -0,0 +1,114 @@
+#include "TrackPrefetcher.h"
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+TrackPrefetcher::TrackPrefetcher(DJControllerService& controller)
+    : controller(controller), lookahead(0), jobs(), queued_upto(0), busy(false), stopping(false),
+      warmed(0), skipped(0), log(), mutex(), wake(), idle(), worker() {}
+
+TrackPrefetcher::~TrackPrefetcher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        jobs.clear();
+    }
+    wake.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void TrackPrefetcher::set_lookahead(size_t tracks, size_t cache_capacity) {
+    // The current track plus its K successors must fit, or prefetches would only evict each other
+    size_t max_lookahead = cache_capacity > 1 ? cache_capacity - 1 : 0;
+    lookahead = tracks < max_lookahead ? tracks : max_lookahead;
+    if (lookahead > 0 && !worker.joinable()) {
+        worker = std::thread(&TrackPrefetcher::run, this);
+    }
+}
+
+void TrackPrefetcher::schedule(const std::vector<AudioTrack*>& tracks, size_t current) {
+    if (lookahead == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // Drop work that is no longer ahead of the current track; queued work
+        // that is still ahead keeps its place so a slow worker is not starved
+        while (!jobs.empty() && jobs.front().position <= current) {
+            jobs.pop_front();
+        }
+        size_t last = std::min(tracks.size() - 1, current + lookahead);
+        for (size_t next = std::max(queued_upto, current) + 1; next <= last; ++next) {
+            if (tracks[next]) {
+                Job job = {tracks[next], next, std::vector<TrackId>()};
+                jobs.push_back(job);
+            }
+        }
+        queued_upto = std::max(queued_upto, last);
+        // Everything due before a job's track must survive it
+        for (Job& job : jobs) {
+            job.keep.clear();
+            for (size_t due = current; due < job.position; ++due) {
+                if (tracks[due]) {
+                    job.keep.push_back(tracks[due]->get_id());
+                }
+            }
+        }
+    }
+    wake.notify_one();
+}
+
+void TrackPrefetcher::cancel() {
+    std::unique_lock<std::mutex> lock(mutex);
+    jobs.clear();
+    queued_upto = 0;
+    idle.wait(lock, [this] { return !busy; });
+}
+
+void TrackPrefetcher::flush_log() {
+    std::string text;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        text.swap(log);
+    }
+    std::cout << text << std::flush;
+}
+
+size_t TrackPrefetcher::get_warmed() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return warmed;
+}
+
+size_t TrackPrefetcher::get_skipped() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return skipped;
+}
+
+void TrackPrefetcher::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+        if (stopping) {
+            return;
+        }
+        Job job = jobs.front();
+        jobs.pop_front();
+        busy = true;
+        lock.unlock();
+
+        std::ostringstream text;
+        bool stored = controller.prefetchTrackToCache(*job.source, job.keep, text);
+
+        lock.lock();
+        log += text.str();
+        busy = false;
+        if (stored) {
+            warmed++;
+        } else {
+            skipped++;
+        }
+        idle.notify_all();
+    }
+}
@@ -0,0 +1,22 @@
+#include "TrackRegistry.h"
+
+TrackId TrackRegistry::intern(const std::string& title) {
+    auto it = ids.find(title);
+    if (it != ids.end()) {
+        return it->second;
+    }
+    TrackId id = static_cast<TrackId>(titles.size());
+    titles.push_back(title);
+    ids.emplace(title, id);
+    return id;
+}
+
+TrackId TrackRegistry::find(const std::string& title) const {
+    auto it = ids.find(title);
+    return it == ids.end() ? INVALID_TRACK_ID : it->second;
+}
+
+void TrackRegistry::clear() {
+    titles.clear();
+    ids.clear();
+}
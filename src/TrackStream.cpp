@@ -0,0 +1,19 @@
+#include "TrackStream.h"
+#include "AudioTrack.h"
+
+WaveformStream::WaveformStream(const std::shared_ptr<const TrackPayload>& payload, double duration_seconds)
+    : payload(payload), rate(duration_seconds > 0.0 ? payload->waveform_size / duration_seconds : 0.0), next(0) {}
+
+uint64_t WaveformStream::length() const {
+    return payload->waveform_size;
+}
+
+size_t WaveformStream::read(double* out, size_t frames) {
+    const uint64_t remaining = payload->waveform_size - next;
+    const size_t count = remaining < frames ? static_cast<size_t>(remaining) : frames;
+    if (count > 0) {
+        payload->read(static_cast<size_t>(next), out, count);
+        next += count;
+    }
+    return count;
+}
@@ -0,0 +1,232 @@
+#include "TrackTable.h"
+#include "MP3Track.h"
+#include "WAVTrack.h"
+#include <algorithm>
+#include <utility>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Append row base + i for every set bit i of mask
+inline void append_rows(std::vector<uint32_t>& rows, size_t base, int mask) {
+    while (mask) {
+        int bit = __builtin_ctz(static_cast<unsigned>(mask));
+        rows.push_back(static_cast<uint32_t>(base + bit));
+        mask &= mask - 1;
+    }
+}
+
+#if defined(__SSE2__)
+// SSE2 has no 32-bit min/max; select through a comparison mask
+inline __m128i min_epi32(__m128i a, __m128i b) {
+    __m128i gt = _mm_cmpgt_epi32(a, b);
+    return _mm_or_si128(_mm_and_si128(gt, b), _mm_andnot_si128(gt, a));
+}
+
+inline __m128i max_epi32(__m128i a, __m128i b) {
+    __m128i gt = _mm_cmpgt_epi32(a, b);
+    return _mm_or_si128(_mm_and_si128(gt, a), _mm_andnot_si128(gt, b));
+}
+
+inline int horizontal(__m128i v, const int& (*pick)(const int&, const int&)) {
+    int lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), v);
+    return pick(pick(lanes[0], lanes[1]), pick(lanes[2], lanes[3]));
+}
+#endif
+
+// Min-heap order on (quality, row): the root is the weakest of the kept rows
+typedef std::pair<float, uint32_t> Candidate;
+
+struct Weaker {
+    bool operator()(const Candidate& a, const Candidate& b) const {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    }
+};
+
+} // namespace
+
+void TrackTable::build(const std::vector<AudioTrack*>& library) {
+    clear();
+    ids.reserve(library.size());
+    bpms.reserve(library.size());
+    durations.reserve(library.size());
+    qualities.reserve(library.size());
+    formats.reserve(library.size());
+    rates.reserve(library.size());
+    for (const AudioTrack* track : library) {
+        ids.push_back(track->get_id());
+        bpms.push_back(track->get_bpm());
+        durations.push_back(track->get_duration());
+        qualities.push_back(static_cast<float>(track->get_quality_score()));
+        if (const MP3Track* mp3 = dynamic_cast<const MP3Track*>(track)) {
+            formats.push_back(FORMAT_MP3);
+            rates.push_back(mp3->get_bitrate());
+        } else if (const WAVTrack* wav = dynamic_cast<const WAVTrack*>(track)) {
+            formats.push_back(FORMAT_WAV);
+            rates.push_back(wav->get_sample_rate());
+        } else {
+            formats.push_back(FORMAT_OTHER);
+            rates.push_back(0);
+        }
+    }
+}
+
+void TrackTable::clear() {
+    ids.clear();
+    bpms.clear();
+    durations.clear();
+    qualities.clear();
+    formats.clear();
+    rates.clear();
+}
+
+std::vector<uint32_t> TrackTable::filterBpm(int min_bpm, int max_bpm) const {
+    std::vector<uint32_t> rows;
+    const size_t n = bpms.size();
+    const int32_t* bpm = bpms.data();
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i lo = _mm_set1_epi32(min_bpm);
+    const __m128i hi = _mm_set1_epi32(max_bpm);
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bpm + i));
+        __m128i out = _mm_or_si128(_mm_cmpgt_epi32(lo, v), _mm_cmpgt_epi32(v, hi));
+        int mask = ~_mm_movemask_ps(_mm_castsi128_ps(out)) & 0xF;
+        append_rows(rows, i, mask);
+    }
+#endif
+    for (; i < n; ++i) {
+        if (bpm[i] >= min_bpm && bpm[i] <= max_bpm) {
+            rows.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    return rows;
+}
+
+size_t TrackTable::countFormat(Format format) const {
+    const size_t n = formats.size();
+    const uint8_t* fmt = formats.data();
+    size_t count = 0;
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i wanted = _mm_set1_epi8(static_cast<char>(format));
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(fmt + i));
+        count += __builtin_popcount(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, wanted))));
+    }
+#endif
+    for (; i < n; ++i) {
+        count += fmt[i] == format ? 1 : 0;
+    }
+    return count;
+}
+
+TrackTable::Summary TrackTable::summarize() const {
+    Summary summary;
+    const size_t n = ids.size();
+    summary.count = n;
+    if (n == 0) {
+        return summary;
+    }
+    const int32_t* bpm = bpms.data();
+    const int32_t* dur = durations.data();
+    const float* q = qualities.data();
+    int64_t duration_sum = 0;
+    double quality_sum = 0.0;
+    int min_bpm = bpm[0];
+    int max_bpm = bpm[0];
+    size_t i = 0;
+#if defined(__SSE2__)
+    if (n >= 4) {
+        __m128i vmin = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bpm));
+        __m128i vmax = vmin;
+        __m128i dsum = _mm_setzero_si128();    // 2 x int64
+        __m128d qsum = _mm_setzero_pd();
+        for (; i + 4 <= n; i += 4) {
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bpm + i));
+            vmin = min_epi32(vmin, b);
+            vmax = max_epi32(vmax, b);
+            // Widen durations to 64 bits (sign-extended) so a huge library cannot overflow
+            __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dur + i));
+            __m128i sign = _mm_srai_epi32(d, 31);
+            dsum = _mm_add_epi64(dsum, _mm_unpacklo_epi32(d, sign));
+            dsum = _mm_add_epi64(dsum, _mm_unpackhi_epi32(d, sign));
+            __m128 qv = _mm_loadu_ps(q + i);
+            qsum = _mm_add_pd(qsum, _mm_cvtps_pd(qv));
+            qsum = _mm_add_pd(qsum, _mm_cvtps_pd(_mm_movehl_ps(qv, qv)));
+        }
+        min_bpm = horizontal(vmin, std::min<int>);
+        max_bpm = horizontal(vmax, std::max<int>);
+        int64_t dlanes[2];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dlanes), dsum);
+        duration_sum = dlanes[0] + dlanes[1];
+        double qlanes[2];
+        _mm_storeu_pd(qlanes, qsum);
+        quality_sum = qlanes[0] + qlanes[1];
+    }
+#endif
+    for (; i < n; ++i) {
+        min_bpm = std::min(min_bpm, static_cast<int>(bpm[i]));
+        max_bpm = std::max(max_bpm, static_cast<int>(bpm[i]));
+        duration_sum += dur[i];
+        quality_sum += q[i];
+    }
+    summary.total_duration = static_cast<uint64_t>(duration_sum);
+    summary.min_bpm = min_bpm;
+    summary.max_bpm = max_bpm;
+    summary.mean_quality = quality_sum / n;
+    return summary;
+}
+
+std::vector<uint32_t> TrackTable::topQuality(size_t k) const {
+    const size_t n = qualities.size();
+    k = std::min(k, n);
+    if (k == 0) {
+        return std::vector<uint32_t>();
+    }
+    std::vector<Candidate> heap;
+    heap.reserve(k);
+    const float* q = qualities.data();
+    // Only a row strictly better than the current k-th best can enter the heap
+    // (an equal score loses to the earlier row already kept)
+    auto offer = [&heap, k](float score, uint32_t row) {
+        if (heap.size() < k) {
+            heap.push_back(Candidate(score, row));
+            std::push_heap(heap.begin(), heap.end(), Weaker());
+        } else if (score > heap.front().first) {
+            std::pop_heap(heap.begin(), heap.end(), Weaker());
+            heap.back() = Candidate(score, row);
+            std::push_heap(heap.begin(), heap.end(), Weaker());
+        }
+    };
+    size_t i = 0;
+    for (; i < n && heap.size() < k; ++i) {
+        offer(q[i], static_cast<uint32_t>(i));
+    }
+#if defined(__SSE2__)
+    // Once the heap is full, most blocks hold nothing above the threshold and
+    // are rejected with one compare
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(q + i);
+        int mask = _mm_movemask_ps(_mm_cmpgt_ps(v, _mm_set1_ps(heap.front().first)));
+        while (mask) {
+            int bit = __builtin_ctz(static_cast<unsigned>(mask));
+            offer(q[i + bit], static_cast<uint32_t>(i + bit));
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        offer(q[i], static_cast<uint32_t>(i));
+    }
+    std::sort_heap(heap.begin(), heap.end(), Weaker());
+    std::vector<uint32_t> rows;
+    rows.reserve(heap.size());
+    for (const Candidate& candidate : heap) {
+        rows.push_back(candidate.second);
+    }
+    return rows;
+}
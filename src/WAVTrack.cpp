@@ -1,27 +1,81 @@
 #include "WAVTrack.h"
+#include "AnalysisCache.h"
+#include "BeatGridAnalyzer.h"
+#include "KeyDetector.h"
 #include <iostream>
 
+namespace {
+
+// Mapped PCM, downmixed to mono as it is read
+class PcmStream : public TrackStream {
+public:
+    explicit PcmStream(const std::shared_ptr<const WavFile>& file) : file(file), next(0) {}
+
+    size_t read(double* out, size_t frames) override {
+        const WavFile::PcmView& pcm = file->pcm();
+        const uint64_t remaining = pcm.frames - next;
+        const size_t count = remaining < frames ? static_cast<size_t>(remaining) : frames;
+        pcm.read_mono(next, count, out);
+        next += count;
+        return count;
+    }
+
+    double sample_rate() const override { return file->pcm().sample_rate; }
+    uint64_t length() const override { return file->pcm().frames; }
+    uint64_t position() const override { return next; }
+
+private:
+    std::shared_ptr<const WavFile> file;
+    uint64_t next;
+};
+
+} // namespace
+
 WAVTrack::WAVTrack(const std::string& title, const std::vector<std::string>& artists, 
-                   int duration, int bpm, int sample_rate, int bit_depth)
-    : AudioTrack(title, artists, duration, bpm), sample_rate(sample_rate), bit_depth(bit_depth) {
+                   int duration, int bpm, int sample_rate, int bit_depth, const std::string& file_path)
+    : AudioTrack(title, artists, duration, bpm), sample_rate(sample_rate), bit_depth(bit_depth),
+      file_path(file_path),
+      mapping(file_path.empty() ? nullptr : std::make_shared<SharedFile<WavFile>>()), audio() {
 
     std::cout << "WAVTrack created: " << sample_rate << "Hz/" << bit_depth << "bit" << std::endl;
 }
 
 // ========== TODO: STUDENTS IMPLEMENT THESE VIRTUAL FUNCTIONS ==========
 
-void WAVTrack::load() {
+void WAVTrack::load(std::ostream& out) {
     // TODO: Implement realistic WAV loading simulation
     // NOTE: Use exactly 2 spaces before the arrow (→) character
-    std::cout << "[WAVTrack::load] Loading WAV: \"" << title << "\" at " << sample_rate << "Hz/" << bit_depth << "bit (uncompressed)..." << std::endl;
+    std::string map_error;
+    if (mapping && !audio) {
+        const std::string& path = file_path;
+        std::shared_ptr<const WavFile> file = mapping->open([&path] { return std::make_shared<WavFile>(path); });
+        if (file->is_open()) {
+            audio = file;
+            // The file's header is authoritative over the configured format
+            sample_rate = static_cast<int>(file->pcm().sample_rate);
+            bit_depth = static_cast<int>(file->pcm().bits);
+        } else {
+            map_error = file->error();
+        }
+    }
+    out << "[WAVTrack::load] Loading WAV: \"" << title << "\" at " << sample_rate << "Hz/" << bit_depth << "bit (uncompressed)..." << std::endl;
+    if (audio) {
+        const WavFile::PcmView& pcm = audio->pcm();
+        out << "  → Mapped \"" << file_path << "\": " << pcm.frames << " frames x " << pcm.channels
+                  << " channels, " << audio->data_bytes() << " bytes of PCM (zero-copy)" << std::endl;
+        return;
+    }
+    if (!map_error.empty()) {
+        out << "  → Could not map \"" << file_path << "\" (" << map_error << "), using estimates" << std::endl;
+    }
     long size = duration_seconds * sample_rate * (bit_depth / 8) * 2;
-    std::cout << "  → Estimated file size: " << size << " bytes" << std::endl;
-    std::cout << "  → Fast loading due to uncompressed format." << std::endl;
+    out << "  → Estimated file size: " << size << " bytes" << std::endl;
+    out << "  → Fast loading due to uncompressed format." << std::endl;
 
 }
 
-void WAVTrack::analyze_beatgrid() {
-    std::cout << "[WAVTrack::analyze_beatgrid] Analyzing beat grid for: \"" << title << "\"\n";
+void WAVTrack::analyze_beatgrid(std::ostream& out) {
+    out << "[WAVTrack::analyze_beatgrid] Analyzing beat grid for: \"" << title << "\"\n";
     // TODO: Implement WAV-specific beat detection analysis
     // Requirements:
     // 1. Print analysis message with track title
@@ -30,7 +84,26 @@ void WAVTrack::analyze_beatgrid() {
     // should print "  → Estimated beats: <beats>  → Precision factor: 1.0 (uncompressed audio)"
 
     long beats = (duration_seconds / 60.0) * bpm;
-    std::cout << "  → Estimated beats: " << beats << "  → Precision factor: 1 (uncompressed audio)" << std::endl;
+    out << "  → Estimated beats: " << beats << "  → Precision factor: 1 (uncompressed audio)" << std::endl;
+    if (audio) {
+        // Analyze the mapped PCM itself; memoized per file mapping, which every copy shares
+        std::shared_ptr<const WavFile> file = audio;
+        int fallback_bpm = bpm;
+        beat_grid = AnalysisCache::shared().beatGrid(file, duration_seconds, bpm, [file, fallback_bpm] {
+            return BeatGridAnalyzer::analyze(file->pcm(), fallback_bpm,
+                                             BeatGridAnalyzer::timeBudget(file->pcm().duration()));
+        });
+        camelot_key = AnalysisCache::shared().harmonicKey(file, [file] { return KeyDetector::detect(file->pcm()); })->camelot;
+    } else {
+        beat_grid = AnalysisCache::shared().beatGrid(*this);
+        camelot_key = AnalysisCache::shared().harmonicKey(*this)->camelot;
+    }
+    if (beat_grid->confident()) {
+        out << "  → Detected BPM: " << beat_grid->bpm << " (confidence " << beat_grid->confidence << ")" << std::endl;
+    }
+    if (camelot_key != HarmonicKey::UNKNOWN) {
+        out << "  → Detected key: " << HarmonicKey::name(camelot_key) << std::endl;
+    }
 }
 
 double WAVTrack::get_quality_score() const {
@@ -49,7 +122,24 @@ double WAVTrack::get_quality_score() const {
     return score;
 }
 
+size_t WAVTrack::get_memory_footprint() const {
+    if (audio) {
+        // The mapped PCM, paged in as it is read
+        return static_cast<size_t>(audio->data_bytes()) + AudioTrack::get_memory_footprint();
+    }
+    // Uncompressed stereo PCM
+    size_t pcm_bytes = static_cast<size_t>(duration_seconds) * sample_rate * (bit_depth / 8) * 2;
+    return pcm_bytes + AudioTrack::get_memory_footprint();
+}
+
 PointerWrapper<AudioTrack> WAVTrack::clone() const {
     // TODO: Implement the clone method
     return PointerWrapper<AudioTrack>(new WAVTrack(*this)); // Replace with your implementation
-}
\ No newline at end of file
+}
+
+PointerWrapper<TrackStream> WAVTrack::open_stream() const {
+    if (audio) {
+        return PointerWrapper<TrackStream>(new PcmStream(audio));
+    }
+    return PointerWrapper<TrackStream>(new WaveformStream(payload, duration_seconds));
+}
@@ -0,0 +1,221 @@
+#include "WavFile.h"
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+const uint16_t FORMAT_EXTENSIBLE = 0xFFFE;
+const uint32_t SIZE_UNKNOWN = 0xFFFFFFFF;   // RF64 / streamed: real size in ds64 or to EOF
+
+// RIFF is little-endian regardless of the host
+inline uint16_t le16(const unsigned char* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+inline uint32_t le32(const unsigned char* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+inline uint64_t le64(const unsigned char* p) {
+    return static_cast<uint64_t>(le32(p)) | (static_cast<uint64_t>(le32(p + 4)) << 32);
+}
+
+inline bool is_id(const unsigned char* p, const char* id) {
+    return std::memcmp(p, id, 4) == 0;
+}
+
+template <typename T>
+const T* aligned_as(const unsigned char* data) {
+    return reinterpret_cast<uintptr_t>(data) % alignof(T) == 0 ? reinterpret_cast<const T*>(data) : nullptr;
+}
+
+} // namespace
+
+// ========== PcmView ==========
+
+const int16_t* WavFile::PcmView::int16() const {
+    return encoding == PCM_INT && bits == 16 ? aligned_as<int16_t>(data) : nullptr;
+}
+
+const int32_t* WavFile::PcmView::int32() const {
+    return encoding == PCM_INT && bits == 32 ? aligned_as<int32_t>(data) : nullptr;
+}
+
+const float* WavFile::PcmView::float32() const {
+    return encoding == PCM_FLOAT && bits == 32 ? aligned_as<float>(data) : nullptr;
+}
+
+double WavFile::PcmView::sample(uint64_t frame, unsigned channel) const {
+    const unsigned char* p = data + frame * frame_bytes() + channel * (bits / 8);
+    if (encoding == PCM_FLOAT) {
+        uint32_t word = le32(p);
+        float value;
+        std::memcpy(&value, &word, sizeof(value));
+        return value;
+    }
+    switch (bits) {
+        case 16: return static_cast<int16_t>(le16(p)) / 32768.0;
+        case 24: {
+            // Sign-extend by placing the 24 bits at the top of an int32
+            int32_t value = static_cast<int32_t>(static_cast<uint32_t>(le16(p)) << 8 | static_cast<uint32_t>(p[2]) << 24) >> 8;
+            return value / 8388608.0;
+        }
+        default: return static_cast<int32_t>(le32(p)) / 2147483648.0;
+    }
+}
+
+void WavFile::PcmView::read_mono(uint64_t first, size_t count, double* out) const {
+    const unsigned char* p = data + first * frame_bytes();
+    size_t i = 0;
+#if defined(__SSE2__)
+    // Little-endian host assumed for the vector paths (x86)
+    if (encoding == PCM_INT && bits == 16 && channels <= 2) {
+        const __m128d scale = _mm_set1_pd(1.0 / (32768.0 * channels));
+        for (; i + 4 <= count; i += 4) {
+            __m128i sums;
+            if (channels == 2) {
+                // madd with ones adds each L/R pair into one int32
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i * 4));
+                sums = _mm_madd_epi16(v, _mm_set1_epi16(1));
+            } else {
+                __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p + i * 2));
+                sums = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+            }
+            _mm_storeu_pd(out + i, _mm_mul_pd(_mm_cvtepi32_pd(sums), scale));
+            _mm_storeu_pd(out + i + 2, _mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(sums, 8)), scale));
+        }
+    } else if (bits == 32 && channels <= 2) {
+        const bool is_float = encoding == PCM_FLOAT;
+        const __m128d scale = _mm_set1_pd((is_float ? 1.0 : 1.0 / 2147483648.0) / channels);
+        const size_t step = channels == 2 ? 2 : 4;   // Frames per 16-byte load
+        for (; i + step <= count; i += step) {
+            const unsigned char* src = p + i * channels * 4;
+            __m128d lo, hi;
+            if (is_float) {
+                __m128 v = _mm_loadu_ps(reinterpret_cast<const float*>(src));
+                lo = _mm_cvtps_pd(v);
+                hi = _mm_cvtps_pd(_mm_movehl_ps(v, v));
+            } else {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                lo = _mm_cvtepi32_pd(v);
+                hi = _mm_cvtepi32_pd(_mm_srli_si128(v, 8));
+            }
+            if (channels == 2) {
+                // lo = (L0, R0), hi = (L1, R1)
+                _mm_storeu_pd(out + i, _mm_mul_pd(_mm_add_pd(_mm_unpacklo_pd(lo, hi), _mm_unpackhi_pd(lo, hi)), scale));
+            } else {
+                _mm_storeu_pd(out + i, _mm_mul_pd(lo, scale));
+                _mm_storeu_pd(out + i + 2, _mm_mul_pd(hi, scale));
+            }
+        }
+    }
+#endif
+    if (encoding == PCM_INT && bits == 24) {
+        // Packed 3-byte samples have no vector load: sum whole frames as integers
+        const double scale = 1.0 / (8388608.0 * channels);
+        const size_t stride = frame_bytes();
+        for (; i < count; ++i) {
+            const unsigned char* frame = p + i * stride;
+            int64_t sum = 0;
+            for (unsigned c = 0; c < channels; ++c, frame += 3) {
+                sum += static_cast<int32_t>(static_cast<uint32_t>(frame[0]) << 8 | static_cast<uint32_t>(frame[1]) << 16
+                                            | static_cast<uint32_t>(frame[2]) << 24) >> 8;
+            }
+            out[i] = static_cast<double>(sum) * scale;
+        }
+    }
+    for (; i < count; ++i) {
+        double sum = 0.0;
+        for (unsigned c = 0; c < channels; ++c) {
+            sum += sample(first + i, c);
+        }
+        out[i] = sum / channels;
+    }
+}
+
+// ========== WavFile ==========
+
+WavFile::WavFile(const std::string& path)
+    : file_path(path), mapped(path, 12), view(), failure(mapped.error()) {
+    if (!mapped.is_open()) {
+        return;
+    }
+    // Scans run front to back: read ahead aggressively, drop pages behind
+    mapped.advise_sequential(true);
+    if (!parse()) {
+        unmap();
+    }
+}
+
+bool WavFile::parse() {
+    const unsigned char* base = static_cast<const unsigned char*>(mapped.data());
+    const size_t mapped_size = mapped.size();
+    const bool rf64 = is_id(base, "RF64");
+    if ((!rf64 && !is_id(base, "RIFF")) || !is_id(base + 8, "WAVE")) {
+        failure = "not a RIFF/WAVE file";
+        return false;
+    }
+    uint16_t format = 0, channels = 0, block_align = 0, bits = 0;
+    uint32_t sample_rate = 0;
+    bool have_format = false;
+    uint64_t ds64_data_size = 0;
+    const unsigned char* data = nullptr;
+    uint64_t data_size = 0;
+
+    // Walk the chunk headers; chunk bodies are never touched except fmt and ds64
+    uint64_t offset = 12;
+    while (offset + 8 <= mapped_size) {
+        const unsigned char* chunk = base + offset;
+        const uint64_t body = offset + 8;
+        const uint64_t available = mapped_size - body;
+        uint64_t size = le32(chunk + 4);
+        if (is_id(chunk, "ds64") && size >= 16 && available >= 16) {
+            ds64_data_size = le64(chunk + 16);
+        } else if (is_id(chunk, "fmt ") && size >= 16 && available >= 16) {
+            format = le16(chunk + 8);
+            channels = le16(chunk + 10);
+            sample_rate = le32(chunk + 12);
+            block_align = le16(chunk + 20);
+            bits = le16(chunk + 22);
+            if (format == FORMAT_EXTENSIBLE && size >= 40 && available >= 40) {
+                format = le16(chunk + 32);   // First two bytes of the SubFormat GUID
+            }
+            have_format = true;
+        } else if (is_id(chunk, "data")) {
+            if (size == SIZE_UNKNOWN) {
+                size = rf64 && ds64_data_size ? ds64_data_size : available;
+            }
+            data = base + body;
+            data_size = size < available ? size : available;   // Tolerate truncated files
+            if (have_format) break;
+        }
+        if (size > available) break;
+        offset = body + size + (size & 1);   // Chunks are padded to even sizes
+    }
+
+    if (!have_format || !data) {
+        failure = have_format ? "no data chunk" : "no fmt chunk";
+        return false;
+    }
+    bool supported = (format == PCM_INT && (bits == 16 || bits == 24 || bits == 32)) ||
+                     (format == PCM_FLOAT && bits == 32);
+    if (!supported || channels == 0 || block_align != channels * (bits / 8)) {
+        failure = "unsupported sample format";
+        return false;
+    }
+    view.data = data;
+    view.channels = channels;
+    view.bits = bits;
+    view.sample_rate = sample_rate;
+    view.encoding = static_cast<Encoding>(format);
+    view.frames = data_size / block_align;
+    return true;
+}
+
+void WavFile::unmap() {
+    mapped.reset();
+    view = PcmView();
+}
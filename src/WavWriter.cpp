@@ -0,0 +1,145 @@
+#include "WavWriter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+constexpr size_t WavWriter::DEFAULT_BLOCK_BYTES;
+
+namespace {
+
+const size_t HEADER_BYTES = 44;
+
+void put_le(unsigned char* at, uint32_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        at[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+}
+
+} // namespace
+
+WavWriter::WavWriter(const std::string& path, unsigned sample_rate, size_t block_bytes)
+    : path(path), temp_path(path + ".tmp"), out(), rate(sample_rate),
+      block(std::max<size_t>(1, block_bytes / sizeof(int16_t))), filled(0), written(0), flushes(0),
+      io_time(std::chrono::steady_clock::duration::zero()), open(false) {
+    out.open(temp_path.c_str(), std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return;
+    }
+    // Sizes are patched by close()
+    unsigned char header[HEADER_BYTES] = {};
+    std::memcpy(header, "RIFF", 4);
+    std::memcpy(header + 8, "WAVEfmt ", 8);
+    put_le(header + 16, 16, 4);
+    put_le(header + 20, 1, 2);              // PCM
+    put_le(header + 22, 1, 2);              // Mono
+    put_le(header + 24, rate, 4);
+    put_le(header + 28, rate * 2, 4);       // Byte rate
+    put_le(header + 32, 2, 2);              // Block align
+    put_le(header + 34, 16, 2);             // Bits per sample
+    std::memcpy(header + 36, "data", 4);
+    out.write(reinterpret_cast<const char*>(header), HEADER_BYTES);
+    open = static_cast<bool>(out);
+}
+
+WavWriter::~WavWriter() {
+    if (!temp_path.empty()) {
+        out.close();
+        std::remove(temp_path.c_str());
+    }
+}
+
+void WavWriter::encode(const double* in, int16_t* out, size_t count) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128d low = _mm_set1_pd(-1.0);
+    const __m128d high = _mm_set1_pd(1.0);
+    const __m128d scale = _mm_set1_pd(32767.0);
+    for (; i + 4 <= count; i += 4) {
+        __m128d a = _mm_mul_pd(_mm_min_pd(_mm_max_pd(_mm_loadu_pd(in + i), low), high), scale);
+        __m128d b = _mm_mul_pd(_mm_min_pd(_mm_max_pd(_mm_loadu_pd(in + i + 2), low), high), scale);
+        __m128i words = _mm_unpacklo_epi64(_mm_cvtpd_epi32(a), _mm_cvtpd_epi32(b));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(words, words));
+    }
+#endif
+    for (; i < count; ++i) {
+        out[i] = static_cast<int16_t>(std::nearbyint(std::max(-1.0, std::min(1.0, in[i])) * 32767.0));
+    }
+}
+
+void WavWriter::write(const double* samples, size_t count) {
+    while (open && count > 0) {
+        const size_t n = std::min(count, block.size() - filled);
+        encode(samples, block.data() + filled, n);
+        filled += n;
+        samples += n;
+        count -= n;
+        if (filled == block.size()) {
+            flush();
+        }
+    }
+}
+
+void WavWriter::write(const int16_t* samples, size_t count) {
+    if (open && filled == 0 && count >= block.size()) {
+        // Already encoded and at least a block long: skip the copy
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        out.write(reinterpret_cast<const char*>(samples), count * sizeof(int16_t));
+        io_time += std::chrono::steady_clock::now() - start;
+        written += count;
+        ++flushes;
+        open = static_cast<bool>(out);
+        return;
+    }
+    while (open && count > 0) {
+        const size_t n = std::min(count, block.size() - filled);
+        std::memcpy(block.data() + filled, samples, n * sizeof(int16_t));
+        filled += n;
+        samples += n;
+        count -= n;
+        if (filled == block.size()) {
+            flush();
+        }
+    }
+}
+
+void WavWriter::flush() {
+    if (filled == 0) {
+        return;
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    out.write(reinterpret_cast<const char*>(block.data()), filled * sizeof(int16_t));
+    io_time += std::chrono::steady_clock::now() - start;
+    written += filled;
+    filled = 0;
+    ++flushes;
+    open = static_cast<bool>(out);
+}
+
+bool WavWriter::close() {
+    if (!open) {
+        return false;
+    }
+    flush();
+    const uint64_t data_bytes = written * sizeof(int16_t);
+    if (!open || data_bytes + HEADER_BYTES - 8 > UINT32_MAX) {
+        return false;   // The destructor removes the partial file
+    }
+    unsigned char size[4];
+    put_le(size, static_cast<uint32_t>(data_bytes + HEADER_BYTES - 8), 4);
+    out.seekp(4);
+    out.write(reinterpret_cast<const char*>(size), 4);
+    put_le(size, static_cast<uint32_t>(data_bytes), 4);
+    out.seekp(40);
+    out.write(reinterpret_cast<const char*>(size), 4);
+    out.close();
+    open = false;
+    if (!out || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        return false;
+    }
+    temp_path.clear();
+    return true;
+}
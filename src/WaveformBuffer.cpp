@@ -0,0 +1,219 @@
+#include "WaveformBuffer.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+std::atomic<int> default_format(WaveformBuffer::FLOAT64);
+std::atomic<uint64_t> sample_allocations(0);
+
+const double INT16_RANGE = 32767.0;
+const double INT8_RANGE = 127.0;
+
+// ---- Conversion kernels: vector body + scalar tail ----
+
+void f64_to_f32(const double* src, float* dst, size_t n) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 4 <= n; i += 4) {
+        __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(src + i));
+        __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(src + i + 2));
+        _mm_storeu_ps(dst + i, _mm_movelh_ps(lo, hi));
+    }
+#endif
+    for (; i < n; ++i) {
+        dst[i] = static_cast<float>(src[i]);
+    }
+}
+
+void f32_to_f64(const float* src, double* dst, size_t n) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(src + i);
+        _mm_storeu_pd(dst + i, _mm_cvtps_pd(v));
+        _mm_storeu_pd(dst + i + 2, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+    }
+#endif
+    for (; i < n; ++i) {
+        dst[i] = src[i];
+    }
+}
+
+inline int quantize(double x, double mul, double range) {
+    return static_cast<int>(std::lrint(std::max(-range, std::min(range, x * mul))));
+}
+
+#if defined(__SSE2__)
+// 8 doubles -> 8 saturated int16 (x * mul, clamped to +-range, rounded to nearest)
+inline __m128i quantize8(const double* src, __m128d mul, __m128d lo, __m128d hi) {
+    __m128i a = _mm_cvtpd_epi32(_mm_max_pd(lo, _mm_min_pd(hi, _mm_mul_pd(_mm_loadu_pd(src), mul))));
+    __m128i b = _mm_cvtpd_epi32(_mm_max_pd(lo, _mm_min_pd(hi, _mm_mul_pd(_mm_loadu_pd(src + 2), mul))));
+    __m128i c = _mm_cvtpd_epi32(_mm_max_pd(lo, _mm_min_pd(hi, _mm_mul_pd(_mm_loadu_pd(src + 4), mul))));
+    __m128i d = _mm_cvtpd_epi32(_mm_max_pd(lo, _mm_min_pd(hi, _mm_mul_pd(_mm_loadu_pd(src + 6), mul))));
+    return _mm_packs_epi32(_mm_unpacklo_epi64(a, b), _mm_unpacklo_epi64(c, d));
+}
+
+// 8 int16 -> 8 doubles (q * mul)
+inline void dequantize8(__m128i q, double* dst, __m128d mul) {
+    __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(q, q), 16);
+    __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(q, q), 16);
+    _mm_storeu_pd(dst, _mm_mul_pd(_mm_cvtepi32_pd(lo), mul));
+    _mm_storeu_pd(dst + 2, _mm_mul_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(lo, _MM_SHUFFLE(1, 0, 3, 2))), mul));
+    _mm_storeu_pd(dst + 4, _mm_mul_pd(_mm_cvtepi32_pd(hi), mul));
+    _mm_storeu_pd(dst + 6, _mm_mul_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(hi, _MM_SHUFFLE(1, 0, 3, 2))), mul));
+}
+#endif
+
+void f64_to_i16(const double* src, int16_t* dst, size_t n, double mul) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128d m = _mm_set1_pd(mul), lo = _mm_set1_pd(-INT16_RANGE), hi = _mm_set1_pd(INT16_RANGE);
+    for (; i + 8 <= n; i += 8) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), quantize8(src + i, m, lo, hi));
+    }
+#endif
+    for (; i < n; ++i) {
+        dst[i] = static_cast<int16_t>(quantize(src[i], mul, INT16_RANGE));
+    }
+}
+
+void i16_to_f64(const int16_t* src, double* dst, size_t n, double mul) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128d m = _mm_set1_pd(mul);
+    for (; i + 8 <= n; i += 8) {
+        dequantize8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), dst + i, m);
+    }
+#endif
+    for (; i < n; ++i) {
+        dst[i] = src[i] * mul;
+    }
+}
+
+void f64_to_i8(const double* src, int8_t* dst, size_t n, double mul) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128d m = _mm_set1_pd(mul), lo = _mm_set1_pd(-INT8_RANGE), hi = _mm_set1_pd(INT8_RANGE);
+    for (; i + 16 <= n; i += 16) {
+        __m128i a = quantize8(src + i, m, lo, hi);
+        __m128i b = quantize8(src + i + 8, m, lo, hi);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi16(a, b));
+    }
+#endif
+    for (; i < n; ++i) {
+        dst[i] = static_cast<int8_t>(quantize(src[i], mul, INT8_RANGE));
+    }
+}
+
+void i8_to_f64(const int8_t* src, double* dst, size_t n, double mul) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128d m = _mm_set1_pd(mul);
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i));
+        dequantize8(_mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8), dst + i, m);
+    }
+#endif
+    for (; i < n; ++i) {
+        dst[i] = src[i] * mul;
+    }
+}
+
+} // namespace
+
+WaveformBuffer::WaveformBuffer()
+    : sample_format(FLOAT64), count(0), sample_scale(1.0), f64(), f32(), i16(), i8() {}
+
+void WaveformBuffer::reset(Format format, size_t sample_count, double scale) {
+    sample_format = format;
+    count = sample_count;
+    sample_scale = scale > 0.0 ? scale : 1.0;
+    Samples<double>().swap(f64);
+    Samples<float>().swap(f32);
+    Samples<int16_t>().swap(i16);
+    Samples<int8_t>().swap(i8);
+    switch (format) {
+        case FLOAT64: f64.assign(count, 0.0); break;
+        case FLOAT32: f32.assign(count, 0.0f); break;
+        case INT16: i16.assign(count, 0); break;
+        case INT8: i8.assign(count, 0); break;
+    }
+}
+
+void WaveformBuffer::store(size_t offset, const double* samples, size_t n) {
+    if (offset > count || n > count - offset) {
+        return;
+    }
+    switch (sample_format) {
+        case FLOAT64: std::copy(samples, samples + n, f64.begin() + offset); break;
+        case FLOAT32: f64_to_f32(samples, f32.data() + offset, n); break;
+        case INT16: f64_to_i16(samples, i16.data() + offset, n, INT16_RANGE / sample_scale); break;
+        case INT8: f64_to_i8(samples, i8.data() + offset, n, INT8_RANGE / sample_scale); break;
+    }
+}
+
+void WaveformBuffer::load(size_t offset, double* out, size_t n) const {
+    if (offset > count || n > count - offset) {
+        return;
+    }
+    switch (sample_format) {
+        case FLOAT64: std::copy(f64.begin() + offset, f64.begin() + offset + n, out); break;
+        case FLOAT32: f32_to_f64(f32.data() + offset, out, n); break;
+        case INT16: i16_to_f64(i16.data() + offset, out, n, sample_scale / INT16_RANGE); break;
+        case INT8: i8_to_f64(i8.data() + offset, out, n, sample_scale / INT8_RANGE); break;
+    }
+}
+
+size_t WaveformBuffer::bytesPerSample(Format format) {
+    switch (format) {
+        case FLOAT32: return sizeof(float);
+        case INT16: return sizeof(int16_t);
+        case INT8: return sizeof(int8_t);
+        default: return sizeof(double);
+    }
+}
+
+const char* WaveformBuffer::formatName(Format format) {
+    switch (format) {
+        case FLOAT32: return "float32";
+        case INT16: return "int16";
+        case INT8: return "int8";
+        default: return "float64";
+    }
+}
+
+bool WaveformBuffer::parseFormat(const std::string& name, Format& format) {
+    std::string lower(name);
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    const Format all[] = {FLOAT64, FLOAT32, INT16, INT8};
+    for (Format candidate : all) {
+        if (lower == formatName(candidate)) {
+            format = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+WaveformBuffer::Format WaveformBuffer::defaultFormat() {
+    return static_cast<Format>(default_format.load());
+}
+
+void WaveformBuffer::setDefaultFormat(Format format) {
+    default_format.store(format);
+}
+
+uint64_t WaveformBuffer::allocations() {
+    return sample_allocations.load(std::memory_order_relaxed);
+}
+
+void WaveformBuffer::countAllocation() {
+    sample_allocations.fetch_add(1, std::memory_order_relaxed);
+}
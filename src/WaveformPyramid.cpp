@@ -0,0 +1,163 @@
+#include "WaveformPyramid.h"
+#include <algorithm>
+#include <cmath>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Level 0 from the samples: pairwise min, max and mean square
+void reduce_samples(const double* x, size_t pairs, float* mn, float* mx, float* ms) {
+    size_t p = 0;
+#if defined(__SSE2__)
+    const __m128d half = _mm_set1_pd(0.5);
+    for (; p + 2 <= pairs; p += 2) {
+        __m128d a = _mm_loadu_pd(x + 2 * p);        // pair p
+        __m128d b = _mm_loadu_pd(x + 2 * p + 2);    // pair p + 1
+        __m128d even = _mm_unpacklo_pd(a, b);
+        __m128d odd = _mm_unpackhi_pd(a, b);
+        __m128 lo = _mm_cvtpd_ps(_mm_min_pd(even, odd));
+        __m128 hi = _mm_cvtpd_ps(_mm_max_pd(even, odd));
+        __m128 sq = _mm_cvtpd_ps(_mm_mul_pd(half, _mm_add_pd(_mm_mul_pd(even, even), _mm_mul_pd(odd, odd))));
+        _mm_storel_pi(reinterpret_cast<__m64*>(mn + p), lo);
+        _mm_storel_pi(reinterpret_cast<__m64*>(mx + p), hi);
+        _mm_storel_pi(reinterpret_cast<__m64*>(ms + p), sq);
+    }
+#endif
+    for (; p < pairs; ++p) {
+        double a = x[2 * p], b = x[2 * p + 1];
+        mn[p] = static_cast<float>(std::min(a, b));
+        mx[p] = static_cast<float>(std::max(a, b));
+        ms[p] = static_cast<float>(0.5 * (a * a + b * b));
+    }
+}
+
+// Level k + 1 from level k: merge entry pairs
+void reduce_level(const float* in_mn, const float* in_mx, const float* in_ms, size_t pairs,
+                  float* mn, float* mx, float* ms) {
+    size_t p = 0;
+#if defined(__SSE2__)
+    const __m128 half = _mm_set1_ps(0.5f);
+    for (; p + 4 <= pairs; p += 4) {
+        __m128 a, b;
+        a = _mm_loadu_ps(in_mn + 2 * p);
+        b = _mm_loadu_ps(in_mn + 2 * p + 4);
+        _mm_storeu_ps(mn + p, _mm_min_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)),
+                                         _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))));
+        a = _mm_loadu_ps(in_mx + 2 * p);
+        b = _mm_loadu_ps(in_mx + 2 * p + 4);
+        _mm_storeu_ps(mx + p, _mm_max_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)),
+                                         _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))));
+        a = _mm_loadu_ps(in_ms + 2 * p);
+        b = _mm_loadu_ps(in_ms + 2 * p + 4);
+        _mm_storeu_ps(ms + p, _mm_mul_ps(half, _mm_add_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)),
+                                                          _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)))));
+    }
+#endif
+    for (; p < pairs; ++p) {
+        mn[p] = std::min(in_mn[2 * p], in_mn[2 * p + 1]);
+        mx[p] = std::max(in_mx[2 * p], in_mx[2 * p + 1]);
+        ms[p] = 0.5f * (in_ms[2 * p] + in_ms[2 * p + 1]);
+    }
+}
+
+} // namespace
+
+void WaveformPyramid::build(const double* samples, size_t count) {
+    levels.clear();
+    sample_count = count;
+    if (count < 2) {
+        return;
+    }
+    // Level 0: full pairs, plus a single-sample tail
+    Level base;
+    base.block = 2;
+    size_t pairs = count / 2;
+    size_t entries = (count + 1) / 2;
+    base.min.resize(entries);
+    base.max.resize(entries);
+    base.mean_square.resize(entries);
+    reduce_samples(samples, pairs, base.min.data(), base.max.data(), base.mean_square.data());
+    if (entries > pairs) {
+        double last = samples[count - 1];
+        base.min[pairs] = base.max[pairs] = static_cast<float>(last);
+        base.mean_square[pairs] = static_cast<float>(last * last);
+    }
+    levels.push_back(base);
+
+    while (levels.back().size() > 1) {
+        const Level& below = levels.back();
+        Level next;
+        next.block = below.block * 2;
+        pairs = below.size() / 2;
+        entries = (below.size() + 1) / 2;
+        next.min.resize(entries);
+        next.max.resize(entries);
+        next.mean_square.resize(entries);
+        reduce_level(below.min.data(), below.max.data(), below.mean_square.data(), pairs,
+                     next.min.data(), next.max.data(), next.mean_square.data());
+        // The last merged entry may include the partial tail block: weight by coverage
+        size_t tail_samples = count - (below.size() - 1) * below.block;   // Samples in below's last entry
+        if (entries > pairs) {
+            size_t last = below.size() - 1;
+            next.min[pairs] = below.min[last];
+            next.max[pairs] = below.max[last];
+            next.mean_square[pairs] = below.mean_square[last];
+        } else if (tail_samples < below.block) {
+            size_t last = below.size() - 1;
+            double full = below.block, partial = static_cast<double>(tail_samples);
+            next.mean_square[pairs - 1] = static_cast<float>(
+                (below.mean_square[last - 1] * full + below.mean_square[last] * partial) / (full + partial));
+        }
+        levels.push_back(next);
+    }
+}
+
+size_t WaveformPyramid::bytes() const {
+    size_t total = 0;
+    for (const Level& level : levels) {
+        total += level.size() * 3 * sizeof(float);
+    }
+    return total;
+}
+
+const WaveformPyramid::Level* WaveformPyramid::coarsestAtMost(size_t max_block) const {
+    const Level* found = nullptr;
+    for (const Level& level : levels) {
+        if (level.block > max_block) break;
+        found = &level;
+    }
+    return found;
+}
+
+void WaveformPyramid::overview(size_t width, std::vector<float>& min, std::vector<float>& max,
+                               std::vector<float>& rms) const {
+    min.assign(width, 0.0f);
+    max.assign(width, 0.0f);
+    rms.assign(width, 0.0f);
+    if (width == 0 || levels.empty()) {
+        return;
+    }
+    const Level* level = coarsestAtMost(std::max<size_t>(2, sample_count / width));
+    if (!level) {
+        level = &levels.front();
+    }
+    const size_t n = level->size();
+    for (size_t column = 0; column < width; ++column) {
+        size_t begin = column * n / width;
+        size_t end = std::max(begin + 1, (column + 1) * n / width);
+        if (begin >= n) break;
+        end = std::min(end, n);
+        float lo = level->min[begin], hi = level->max[begin];
+        double energy = 0.0;
+        for (size_t i = begin; i < end; ++i) {
+            lo = std::min(lo, level->min[i]);
+            hi = std::max(hi, level->max[i]);
+            energy += level->mean_square[i];
+        }
+        min[column] = lo;
+        max[column] = hi;
+        rms[column] = static_cast<float>(std::sqrt(energy / (end - begin)));
+    }
+}
@@ -0,0 +1,63 @@
+#include "CacheSimulator.h"
+#include "SessionFileParser.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+/**
+ * cache_sim - offline controller-cache sizing tool
+ *
+ * Replays the access trace of a play-all session through every cache policy
+ * and Belady's OPT at a sweep of capacities, without cloning or loading tracks.
+ *
+ * Usage: cache_sim [config_path] [--max-capacity N] [--reuse-histogram]
+ *   config_path        Session config (default: bin/dj_config.txt)
+ *   --max-capacity N   Largest capacity of the sweep (default: number of distinct tracks)
+ *   --reuse-histogram  Print the reuse-distance histogram instead of miss-ratio curves
+ *
+ * CSV goes to stdout; parser messages and the trace summary go to stderr.
+ */
+int main(int argc, char* argv[]) {
+    std::string config_path = "bin/dj_config.txt";
+    size_t max_capacity = 0;
+    bool reuse_histogram = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--max-capacity") == 0 && i + 1 < argc) {
+            max_capacity = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--reuse-histogram") == 0) {
+            reuse_histogram = true;
+        } else if (argv[i][0] == '-') {
+            std::cerr << "Usage: " << argv[0] << " [config_path] [--max-capacity N] [--reuse-histogram]" << std::endl;
+            return 1;
+        } else {
+            config_path = argv[i];
+        }
+    }
+
+    // Keep stdout clean for the CSV
+    SessionConfig config;
+    std::streambuf* stdout_buffer = std::cout.rdbuf(std::cerr.rdbuf());
+    bool parsed = SessionFileParser::parse_config_file(config_path, config);
+    std::cout.rdbuf(stdout_buffer);
+    if (!parsed) {
+        return 1;
+    }
+
+    CacheSimulator simulator(CacheSimulator::buildTrace(config));
+    std::cerr << "Trace: " << simulator.accesses() << " accesses, " << simulator.distinctTracks()
+              << " distinct tracks, configured capacity " << config.controller_cache_size << std::endl;
+
+    if (reuse_histogram) {
+        simulator.writeReuseHistogram(std::cout);
+        return 0;
+    }
+    if (max_capacity == 0) {
+        max_capacity = simulator.distinctTracks();
+    }
+    std::vector<size_t> capacities;
+    for (size_t capacity = 1; capacity <= max_capacity; ++capacity) {
+        capacities.push_back(capacity);
+    }
+    simulator.writeMissRatioCurves(std::cout, capacities);
+    return 0;
+}
@@ -0,0 +1,1523 @@
+#include "AnalysisCache.h"
+#include "BeatGridAnalyzer.h"
+#include "ConcurrentTrackCache.h"
+#include "CrossfadeRenderer.h"
+#include "DJControllerService.h"
+#include "DJLibraryService.h"
+#include "KeyDetector.h"
+#include "LRUCache.h"
+#include "MP3Track.h"
+#include "MixingEngineService.h"
+#include "SessionFileParser.h"
+#include "TrackTable.h"
+#include "TimeStretcher.h"
+#include "WAVTrack.h"
+#include "WavFile.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <set>
+#include <thread>
+#include <vector>
+
+/**
+ * dj_bench - offline benchmarks over a session's library
+ *
+ * Usage: dj_bench beatgrid [config_path] [--rate HZ]
+ *        dj_bench wavscan [file.wav] [--mb N]
+ *        dj_bench mp3index [--seconds S]
+ *        dj_bench crossfade [--seconds S] [--rate HZ] [--decks N]
+ *        dj_bench stretch [--seconds S] [--rate HZ]
+ *        dj_bench deckload [--decks N] [--loads L]
+ *        dj_bench keys [--seconds S] [--rate HZ]
+ *        dj_bench mixer [--seconds S] [--rate HZ] [--decks N] [--loads L]
+ *        dj_bench lru
+ *        dj_bench concurrent [--loads L]
+ *        dj_bench library [--tracks N]
+ *        dj_bench payload [config_path] [--loads L]
+ *        dj_bench allocs [config_path] [--loads L]
+ *   beatgrid     Beat-grid analysis of every library track. Each track is
+ *                rendered as a click track at its configured BPM (so the
+ *                detected tempo can be checked) at --rate samples per second
+ *                (default 44100), then analyzed at the default time budget
+ *                for its length: once from the raw samples, then as a track
+ *                (through its waveform pyramid, whose build is timed apart).
+ *                Fails unless every analysis completes within its budget.
+ *   config_path  Session config (default: bin/dj_config.txt)
+ *   wavscan      Sequential scan throughput (GB/s) of a memory-mapped WAV
+ *                file: a raw pass over the PCM bytes, then a pass through
+ *                PcmView::read_mono (the conversion analysis uses), each run
+ *                twice. Without a file, stereo 16-, 24- and 32-bit (int and
+ *                float) files of --mb megabytes (default 256) are written to
+ *                the temp directory, measured and removed.
+ *   mp3index     MP3 frame index of a synthetic file of S seconds (default
+ *                600) of silent frames at random bitrates: a header scan that
+ *                saves the seek table, a reopen that must load it, and a
+ *                rescan once the file changed, each checked against the
+ *                frame offsets written. Then two independent MP3Tracks of
+ *                the file with the table stored with the analysis data
+ *                (AnalysisCache::seekTablePath): the first scans, the second
+ *                must reuse the table, and neither may open a deck stream.
+ *                Last, 10^6 random seeks (frame_at) checked against the
+ *                frame arithmetic. Fails unless every check passes.
+ *   crossfade    Real-time factor (seconds of audio rendered per wall-clock
+ *                second) of a crossfade over S seconds (default 60) of noise
+ *                at --rate (default 44100) for every curve: the block renderer
+ *                against evaluating the curve per sample, with the largest
+ *                difference between the two. Then the whole engine: N
+ *                streaming decks (default 2) mixed by
+ *                MixingEngineService::render(), loaded one second apart so
+ *                their transitions overlap and the last one fades every
+ *                earlier deck out at once.
+ *   stretch      Time-stretch speed of S seconds (default 60) of a harmonic
+ *                tone at --rate (default 44100) for sync ratios from 0.9 to
+ *                1.1 and the 0.5 / 2.0 limits, fed through TimeStretcher in
+ *                4096-frame chunks as a streaming deck does: wall time as a
+ *                real-time factor and as a share of the track's duration,
+ *                the output length relative to the expected one, and the
+ *                output pitch relative to the input (zero-crossing rate).
+ *   deckload     Cost of handing a cached track to a deck: L loads (default
+ *                1000) rotating over N decks (default 2) with the track cloned
+ *                (loadTrackToDeck(const AudioTrack&)), moved in from a clone
+ *                made beforehand, and borrowed through the cache's pinned
+ *                TrackHandle. Reports heap allocations and bytes per load
+ *                (counted by this binary's operator new) and microseconds per
+ *                load. Decks do not stream, so only the track hand-over and
+ *                deck switch are measured.
+ *   keys         Key detection on synthetic tracks: two chord progressions
+ *                (I-IV-V-I or i-iv-V-i, with bass and harmonics) in every one
+ *                of the 24 keys, S seconds long (default 30) at --rate
+ *                (default 22050), plus noise tracks that must stay unknown.
+ *                Per track: detected Camelot key, correlation and time. Then
+ *                a shuffled playlist of them, all within the BPM tolerance:
+ *                how many transitions clash harmonically under the BPM-only
+ *                check and under the BPM + key check, and the cost of one
+ *                compatibility lookup.
+ *   mixer        Stress test of the real-time mixer thread: N streaming decks
+ *                (default 2) rendered by a MixerThread in 64-frame callbacks
+ *                at --rate (default 44100) while the control thread sends
+ *                it L rounds (default 250) of four commands as fast as it
+ *                can: load a cached track of S seconds (default 20), change
+ *                the crossfader curve, retime the active deck and unload
+ *                another. Reports callbacks, underruns, late callbacks, the
+ *                longest callback and the heap allocations made on the mixer
+ *                thread (counted per thread by this binary's operator new);
+ *                fails unless that count is zero.
+ *   lru          Controller cache lookups and inserts at 8, 1000 and 100000
+ *                slots: LRUCache (hash index and intrusive recency list)
+ *                against the linear-scan LRU it replaced. Requests are drawn
+ *                uniformly from twice as many tracks as slots, so about half
+ *                miss and every missing put evicts. Reports nanoseconds per
+ *                get and per put and the get hit ratio, which must match.
+ *   concurrent   Controller cache throughput from 1 to 32 threads: the
+ *                single-mutex LRUCache path against the sharded
+ *                ConcurrentTrackCache (16 shards), 1024 slots. L requests in
+ *                total (default 200000), split evenly between the threads.
+ *                Each is a get for a uniformly random track of 2048, and a
+ *                put of a fresh clone on a miss, as the controller loads
+ *                tracks. Reports operations per second and hit ratio.
+ *   library      Library queries on N synthetic tracks (default 1000000,
+ *                80% WAV): every TrackTable query (filterBpm, countFormat,
+ *                summarize, topQuality) against a brute-force scan over the
+ *                AudioTrack pointers with virtual calls, as the library was
+ *                queried before the table. Reports the fastest of three runs
+ *                of each and fails unless both return the same result.
+ *   payload      Check that copies share the waveform: the config's library
+ *                is built, then every playlist is replayed L times (default
+ *                3) as a session plays it: cloned into the playlist, loaded
+ *                into the controller cache and cloned onto a deck. Counts
+ *                the waveform sample arrays allocated (WaveformBuffer's
+ *                counting allocator, which also sees deep copies) after each
+ *                round; fails unless the count is exactly one per library
+ *                track played.
+ *   allocs       Heap allocations of a play-all session (counted by this
+ *                binary's operator new): the config's library is built and
+ *                the controller configured as dj_manager does, then every
+ *                playlist is replayed L times (default 3): loaded by index,
+ *                each track requested from the controller cache by TrackId
+ *                and handed to a deck. Reports allocations and bytes per
+ *                phase and round, requests split into hits and misses.
+ *
+ * CSV goes to stdout; parser messages and the summary go to stderr.
+ */
+// Every heap allocation of the process, for the deckload and allocs benchmarks, and of
+// the calling thread, for the mixer stress test
+std::atomic<uint64_t> heap_allocations(0);
+std::atomic<uint64_t> heap_bytes(0);
+thread_local uint64_t thread_allocations = 0;
+
+void* operator new(std::size_t size) {
+    ++heap_allocations;
+    heap_bytes += size;
+    ++thread_allocations;
+    if (void* block = std::malloc(size ? size : 1)) {
+        return block;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* block) noexcept {
+    std::free(block);
+}
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const double TWO_PI = 6.28318530717958647692;
+
+double elapsed_ms(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Deterministic noise in [-1, 1)
+double noise(uint64_t& state) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return static_cast<double>(state >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+}
+
+// Decaying noise bursts on every beat over a low noise floor
+std::vector<double> render_clicks(int duration, int bpm, double rate, uint64_t seed) {
+    std::vector<double> samples(static_cast<size_t>(duration * rate));
+    const double period = 60.0 / bpm * rate;
+    const double decay = 0.01 * rate;    // 10 ms
+    for (size_t i = 0; i < samples.size(); ++i) {
+        double since_beat = std::fmod(static_cast<double>(i), period);
+        samples[i] = noise(seed) * (0.1 + std::exp(-since_beat / decay));
+    }
+    return samples;
+}
+
+int bench_beatgrid(const SessionConfig& config, double rate) {
+    std::cout << "title,configured_bpm,samples,budget_ms,detected_bpm,confidence,beats,analysis_ms,complete,"
+                 "library_waveform_confident,pyramid_ms,track_ms,track_complete,track_bpm" << std::endl;
+    size_t tracks = 0, total_samples = 0, detected = 0, complete = 0, track_complete = 0;
+    double total_ms = 0.0, error_sum = 0.0, pyramid_ms = 0.0, track_ms = 0.0;
+    for (const SessionConfig::TrackInfo& info : config.library_tracks) {
+        // Tracks are built only to analyze the library's own waveform; their
+        // constructors log to stdout, which carries the CSV
+        std::streambuf* stdout_buffer = std::cout.rdbuf(std::cerr.rdbuf());
+        std::unique_ptr<AudioTrack> track;
+        if (info.type == "MP3") {
+            track.reset(new MP3Track(info.title, info.artists, info.duration_seconds, info.bpm,
+                                     info.extra_param1, info.extra_param2));
+        } else {
+            track.reset(new WAVTrack(info.title, info.artists, info.duration_seconds, info.bpm,
+                                     info.extra_param1, info.extra_param2));
+        }
+        std::cout.rdbuf(stdout_buffer);
+        bool library_confident = BeatGridAnalyzer::analyze(*track)->confident();
+
+        // Everything below runs at the default budget for the track's length
+        const std::chrono::microseconds budget = BeatGridAnalyzer::timeBudget(info.duration_seconds);
+        std::vector<double> samples = render_clicks(info.duration_seconds, info.bpm, rate, tracks + 1);
+        Clock::time_point start = Clock::now();
+        std::shared_ptr<const BeatGrid> grid = BeatGridAnalyzer::analyze(
+            samples.data(), samples.size(), info.duration_seconds, info.bpm, budget);
+        double ms = elapsed_ms(start);
+
+        ++tracks;
+        total_samples += samples.size();
+        total_ms += ms;
+        complete += grid->complete ? 1 : 0;
+        if (grid->confident()) {
+            ++detected;
+            error_sum += std::fabs(grid->bpm - info.bpm);
+        }
+
+        // Same audio as a track: building the pyramid is timed apart, as the budget excludes it
+        track->set_waveform(samples.data(), samples.size());
+        start = Clock::now();
+        track->get_waveform_pyramid();
+        double pyramid = elapsed_ms(start);
+        start = Clock::now();
+        std::shared_ptr<const BeatGrid> track_grid = BeatGridAnalyzer::analyze(*track);
+        double analysis = elapsed_ms(start);
+        pyramid_ms += pyramid;
+        track_ms += analysis;
+        track_complete += track_grid->complete ? 1 : 0;
+
+        std::cout << "\"" << info.title << "\"," << info.bpm << "," << samples.size() << ","
+                  << budget.count() / 1000.0 << "," << grid->bpm << "," << grid->confidence << ","
+                  << grid->beats.size() << "," << ms << "," << grid->complete << "," << library_confident << ","
+                  << pyramid << "," << analysis << "," << track_grid->complete << "," << track_grid->bpm << std::endl;
+    }
+    std::cerr << "Beat grid: " << tracks << " tracks, " << total_samples << " samples at " << rate << " Hz, "
+              << total_ms << " ms (" << (total_ms > 0.0 ? total_samples / total_ms / 1000.0 : 0.0) << " Msamples/s)"
+              << std::endl;
+    std::cerr << "  Tempo detected: " << detected << "/" << tracks << ", mean |error| "
+              << (detected ? error_sum / detected : 0.0) << " BPM" << std::endl;
+    std::cerr << "  Complete within the default budget ("
+              << BeatGridAnalyzer::timeBudget().count() / 1000.0 << " ms per minute of audio): "
+              << complete << "/" << tracks << " from samples, " << track_complete << "/" << tracks << " as tracks"
+              << std::endl;
+    std::cerr << "  As tracks: " << pyramid_ms << " ms building pyramids (outside the budget), "
+              << track_ms << " ms analyzing" << std::endl;
+    return complete == tracks && track_complete == tracks ? 0 : 1;
+}
+
+void put_le(std::ostream& out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+// Stereo noise, written in blocks so the file can be larger than memory
+bool write_wav(const std::string& path, unsigned bits, WavFile::Encoding encoding, uint64_t data_bytes) {
+    const unsigned channels = 2, rate = 44100;
+    const unsigned frame_bytes = channels * bits / 8;
+    const uint64_t frames = data_bytes / frame_bytes;
+    const uint64_t size = frames * frame_bytes;
+    if (size + 36 > UINT32_MAX) {
+        return false;
+    }
+    std::ofstream out(path.c_str(), std::ios::binary);
+    out.write("RIFF", 4);
+    put_le(out, 36 + size, 4);
+    out.write("WAVEfmt ", 8);
+    put_le(out, 16, 4);
+    put_le(out, encoding, 2);
+    put_le(out, channels, 2);
+    put_le(out, rate, 4);
+    put_le(out, static_cast<uint64_t>(rate) * frame_bytes, 4);
+    put_le(out, frame_bytes, 2);
+    put_le(out, bits, 2);
+    out.write("data", 4);
+    put_le(out, size, 4);
+
+    std::vector<char> block(1 << 20);
+    const size_t sample_bytes = bits / 8;
+    uint64_t state = bits;
+    for (uint64_t written = 0; written < size; ) {
+        size_t chunk = static_cast<size_t>(std::min<uint64_t>(block.size(), size - written));
+        for (size_t i = 0; i + sample_bytes <= chunk; i += sample_bytes) {
+            double value = 0.5 * noise(state);
+            if (encoding == WavFile::PCM_FLOAT) {
+                float f = static_cast<float>(value);
+                std::memcpy(&block[i], &f, sizeof(f));
+            } else {
+                int64_t q = static_cast<int64_t>(value * static_cast<double>(1LL << (bits - 1)));
+                for (size_t b = 0; b < sample_bytes; ++b) {
+                    block[i + b] = static_cast<char>((q >> (8 * b)) & 0xFF);
+                }
+            }
+        }
+        out.write(block.data(), static_cast<std::streamsize>(chunk));
+        written += chunk;
+    }
+    return static_cast<bool>(out);
+}
+
+// Sum of the mapped bytes, 8 at a time (touches every page once, in order)
+uint64_t scan_bytes(const unsigned char* data, uint64_t size) {
+    uint64_t total = 0;
+    uint64_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        total += word;
+    }
+    for (; i < size; ++i) {
+        total += data[i];
+    }
+    return total;
+}
+
+double scan_mono(const WavFile::PcmView& pcm) {
+    const size_t block = 4096;
+    std::vector<double> out(block);
+    double total = 0.0;
+    for (uint64_t first = 0; first < pcm.frames; first += block) {
+        size_t count = static_cast<size_t>(std::min<uint64_t>(block, pcm.frames - first));
+        pcm.read_mono(first, count, out.data());
+        total += out[count - 1];
+    }
+    return total;
+}
+
+int bench_wavscan(const std::vector<std::string>& files, bool remove_files) {
+    std::cout << "file,bits,encoding,channels,bytes,raw_cold_gbps,raw_warm_gbps,mono_cold_gbps,mono_warm_gbps" << std::endl;
+    double checksum = 0.0;
+    for (const std::string& path : files) {
+        WavFile file(path);
+        if (!file.is_open()) {
+            std::cerr << "Could not map " << path << ": " << file.error() << std::endl;
+            continue;
+        }
+        const WavFile::PcmView& pcm = file.pcm();
+        const double gb = static_cast<double>(file.data_bytes()) / 1e9;
+        double rates[4];
+        for (int pass = 0; pass < 4; ++pass) {
+            Clock::time_point start = Clock::now();
+            if (pass < 2) {
+                checksum += static_cast<double>(scan_bytes(pcm.data, file.data_bytes()) & 0xFF);
+            } else {
+                checksum += scan_mono(pcm);
+            }
+            double seconds = elapsed_ms(start) / 1000.0;
+            rates[pass] = seconds > 0.0 ? gb / seconds : 0.0;
+        }
+        std::cout << "\"" << path << "\"," << pcm.bits << "," << (pcm.encoding == WavFile::PCM_FLOAT ? "float" : "int")
+                  << "," << pcm.channels << "," << file.data_bytes() << "," << rates[0] << "," << rates[1]
+                  << "," << rates[2] << "," << rates[3] << std::endl;
+        if (remove_files) {
+            std::remove(path.c_str());
+        }
+    }
+    std::cerr << "(checksum " << checksum << ")" << std::endl;
+    return 0;
+}
+
+// Silent MPEG-1 Layer III frames at 44.1 kHz, each at a random bitrate (as in a
+// VBR file); returns the byte offset of every frame, or nothing if the write failed
+std::vector<uint32_t> write_mp3(const std::string& path, size_t frames, uint64_t seed) {
+    const unsigned kbps[] = {128, 192, 320};
+    const unsigned char bitrate_index[] = {9, 11, 14};
+    std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+    std::vector<uint32_t> offsets;
+    std::vector<char> frame;
+    uint32_t position = 0;
+    for (size_t i = 0; i < frames; ++i) {
+        const size_t kind = static_cast<size_t>((noise(seed) + 1.0) * 1.5) % 3;
+        frame.assign(144 * kbps[kind] * 1000 / 44100, 0);   // No padding
+        frame[0] = static_cast<char>(0xFF);
+        frame[1] = static_cast<char>(0xFB);
+        frame[2] = static_cast<char>(bitrate_index[kind] << 4);
+        frame[3] = static_cast<char>(0x64);
+        out.write(frame.data(), static_cast<std::streamsize>(frame.size()));
+        offsets.push_back(position);
+        position += static_cast<uint32_t>(frame.size());
+    }
+    return out ? offsets : std::vector<uint32_t>();
+}
+
+// Whether file indexed exactly the frames written at offsets
+bool same_frames(const Mp3File& file, const std::vector<uint32_t>& offsets) {
+    if (!file.is_open() || file.frame_count() != offsets.size()) {
+        return false;
+    }
+    const unsigned char* first = file.frame_data(0);
+    for (uint32_t i = 0; i < file.frame_count(); ++i) {
+        if (static_cast<size_t>(file.frame_data(i) - first) != offsets[i] - offsets[0]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int bench_mp3index(double seconds) {
+    const char* tmp = std::getenv("TMPDIR");
+    const std::string dir = tmp && *tmp ? tmp : "/tmp";
+    const std::string path = dir + "/dj_bench.mp3";
+    const std::string index_path = path + ".index";
+    const size_t frames = static_cast<size_t>(seconds * 44100.0 / 1152.0) + 1;
+    std::vector<uint32_t> offsets = write_mp3(path, frames, 1);
+    if (offsets.empty()) {
+        std::cerr << "Could not write " << path << std::endl;
+        return 1;
+    }
+    std::remove(index_path.c_str());
+    std::cout << "stage,frames,ms,index_loaded,index_saved,ok" << std::endl;
+    bool all_ok = true;
+    auto report = [&all_ok](const char* stage, const Mp3File& file, double ms, bool ok) {
+        std::cout << stage << "," << file.frame_count() << "," << ms << "," << file.index_loaded() << ","
+                  << file.index_saved() << "," << ok << std::endl;
+        all_ok = all_ok && ok;
+    };
+
+    // Header scan, then the saved table, then a rescan once the file changed
+    Clock::time_point start = Clock::now();
+    {
+        Mp3File file(path, index_path);
+        double ms = elapsed_ms(start);
+        report("scan", file, ms, same_frames(file, offsets) && !file.index_loaded() && file.index_saved());
+    }
+    start = Clock::now();
+    {
+        Mp3File file(path, index_path);
+        double ms = elapsed_ms(start);
+        report("reuse", file, ms, same_frames(file, offsets) && file.index_loaded());
+    }
+    offsets = write_mp3(path, frames + 1, 2);
+    start = Clock::now();
+    {
+        Mp3File file(path, index_path);
+        double ms = elapsed_ms(start);
+        report("stale", file, ms, same_frames(file, offsets) && !file.index_loaded() && file.index_saved());
+    }
+
+    // Through MP3Track: two independent tracks of the file, the table stored with the analysis data
+    AnalysisCache::shared().setStoreDirectory(dir);
+    const std::string store_path = AnalysisCache::shared().seekTablePath(path);
+    std::remove(store_path.c_str());
+    std::streambuf* const stdout_buffer = std::cout.rdbuf(std::cerr.rdbuf());   // Track logs go to stderr
+    const char* stages[] = {"track_scan", "track_reuse"};
+    for (int pass = 0; pass < 2; ++pass) {
+        MP3Track track("Bench", {"Bench"}, static_cast<int>(seconds), 120, 192, false, path);
+        start = Clock::now();
+        track.load();
+        double ms = elapsed_ms(start);
+        const Mp3File* file = track.get_audio();
+        bool ok = file && same_frames(*file, offsets) && file->index_loaded() == (pass == 1) &&
+                  (pass == 1 || file->index_saved()) && !track.open_stream();
+        std::cout.rdbuf(stdout_buffer);
+        if (file) {
+            report(stages[pass], *file, ms, ok);
+        } else {
+            std::cout << stages[pass] << ",0," << ms << ",0,0,0" << std::endl;
+            all_ok = false;
+        }
+        std::cout.rdbuf(std::cerr.rdbuf());
+    }
+    std::cout.rdbuf(stdout_buffer);
+    AnalysisCache::shared().setStoreDirectory("");
+
+    // Random seeks: frame index arithmetic plus one touch of the frame
+    {
+        Mp3File file(path, index_path);
+        const size_t seeks = 1000000;
+        const double length = file.duration();
+        uint64_t state = 3;
+        uint64_t checksum = 0;
+        bool ok = file.is_open();
+        start = Clock::now();
+        for (size_t i = 0; ok && i < seeks; ++i) {
+            const double t = (noise(state) + 1.0) * 0.5 * length;
+            const uint32_t frame = file.frame_at(t);
+            ok = frame == std::min(file.frame_count() - 1, static_cast<uint32_t>(t / file.frame_duration()));
+            checksum += file.frame_data(frame)[1];
+        }
+        double ms = elapsed_ms(start);
+        report("seek", file, ms, ok && checksum == 0xFB * seeks);
+        std::cerr << "  Seek: " << ms * 1e6 / seeks << " ns per frame_at + frame read over " << file.frame_count()
+                  << " frames" << std::endl;
+    }
+    std::remove(path.c_str());
+    std::remove(index_path.c_str());
+    std::remove(store_path.c_str());
+    return all_ok ? 0 : 1;
+}
+
+int bench_crossfade(double seconds, double rate, size_t decks) {
+    const size_t frames = static_cast<size_t>(seconds * rate);
+    const size_t callback = 4096;   // Frames per render call, as an audio callback would ask
+    uint64_t seed = 1;
+    std::vector<double> outgoing(frames), incoming(frames), out(frames), reference(frames);
+    for (size_t i = 0; i < frames; ++i) {
+        outgoing[i] = noise(seed);
+        incoming[i] = noise(seed);
+    }
+    std::cout << "stage,curve,frames,wall_ms,realtime_factor,max_difference" << std::endl;
+    const CrossfadeRenderer::Curve curves[] = {CrossfadeRenderer::LINEAR, CrossfadeRenderer::EQUAL_POWER,
+                                               CrossfadeRenderer::S_CURVE};
+    for (CrossfadeRenderer::Curve curve : curves) {
+        CrossfadeRenderer renderer;
+        renderer.set_curve(curve);
+        renderer.start(frames);   // The whole buffer is one transition
+        Clock::time_point start = Clock::now();
+        for (size_t done = 0; done < frames; done += callback) {
+            size_t n = std::min(callback, frames - done);
+            renderer.render(outgoing.data() + done, incoming.data() + done, out.data() + done, n);
+        }
+        double block_ms = elapsed_ms(start);
+
+        start = Clock::now();
+        for (size_t i = 0; i < frames; ++i) {
+            double out_gain, in_gain;
+            CrossfadeRenderer::gains(curve, static_cast<double>(i) / frames, out_gain, in_gain);
+            reference[i] = outgoing[i] * out_gain + incoming[i] * in_gain;
+        }
+        double sample_ms = elapsed_ms(start);
+        double difference = 0.0;
+        for (size_t i = 0; i < frames; ++i) {
+            difference = std::max(difference, std::fabs(out[i] - reference[i]));
+        }
+        const char* name = CrossfadeRenderer::curveName(curve);
+        std::cout << "block," << name << "," << frames << "," << block_ms << ","
+                  << (block_ms > 0.0 ? seconds * 1000.0 / block_ms : 0.0) << "," << difference << std::endl;
+        std::cout << "per_sample," << name << "," << frames << "," << sample_ms << ","
+                  << (sample_ms > 0.0 ? seconds * 1000.0 / sample_ms : 0.0) << ",0" << std::endl;
+    }
+
+    // Whole engine: decoder threads, ring buffers and the mix, over a 5 s transition
+    std::streambuf* stdout_buffer = std::cout.rdbuf(std::cerr.rdbuf());
+    MixingEngineService engine;
+    engine.set_deck_count(decks);
+    engine.set_streaming(true);
+    engine.set_crossfade(5, CrossfadeRenderer::EQUAL_POWER);
+    const int duration = static_cast<int>(seconds);
+    for (size_t deck = 0; deck < decks; ++deck) {
+        MP3Track track("Deck " + std::to_string(deck), {"Bench"}, duration, 128, 320);
+        track.set_waveform(deck % 2 ? incoming.data() : outgoing.data(), frames);
+        engine.loadTrackToDeck(track);
+        for (size_t warm = 0; deck + 1 < decks && warm < static_cast<size_t>(rate);) {
+            size_t n = engine.render(out.data(), std::min(callback, static_cast<size_t>(rate) - warm));
+            if (n == 0) {
+                std::this_thread::yield();
+            }
+            warm += n;
+        }
+    }
+    std::cout.rdbuf(stdout_buffer);
+    const StreamingDecoder* stream = engine.get_stream(engine.get_active_deck());
+    size_t rendered = 0, underruns = 0;
+    Clock::time_point start = Clock::now();
+    while (stream && !stream->finished()) {
+        size_t n = engine.render(out.data(), callback);
+        if (n == 0) {
+            ++underruns;
+            std::this_thread::yield();
+        }
+        rendered += n;
+    }
+    double engine_ms = elapsed_ms(start);
+    std::cout << "engine_" << decks << "_decks,equal_power," << rendered << "," << engine_ms << ","
+              << (engine_ms > 0.0 ? rendered / rate * 1000.0 / engine_ms : 0.0) << "," << std::endl;
+    std::cerr << "Engine: " << rendered << " frames in " << engine_ms << " ms, " << underruns
+              << " empty render calls (decoder behind)" << std::endl;
+    stdout_buffer = std::cout.rdbuf(std::cerr.rdbuf());   // Deck teardown logs
+    return 0;
+}
+
+// Upward zero crossings per sample
+double crossing_rate(const std::vector<double>& samples) {
+    size_t crossings = 0;
+    for (size_t i = 1; i < samples.size(); ++i) {
+        crossings += samples[i - 1] < 0.0 && samples[i] >= 0.0;
+    }
+    return samples.size() > 1 ? static_cast<double>(crossings) / (samples.size() - 1) : 0.0;
+}
+
+int bench_stretch(double seconds, double rate) {
+    const size_t frames = static_cast<size_t>(seconds * rate);
+    std::vector<double> input(frames);
+    for (size_t i = 0; i < frames; ++i) {
+        const double t = i / rate;
+        input[i] = 0.5 * std::sin(TWO_PI * 220.0 * t) + 0.3 * std::sin(TWO_PI * 440.0 * t)
+                 + 0.15 * std::sin(TWO_PI * 660.0 * t);
+    }
+    const double input_rate = crossing_rate(input);
+    const size_t chunk = 4096;
+    const double ratios[] = {0.9, 0.95, 0.98, 1.02, 1.05, 1.1, 0.5, 2.0};
+    std::cout << "ratio,input_frames,output_frames,wall_ms,realtime_factor,percent_of_duration,length_ratio,pitch_ratio"
+              << std::endl;
+    for (double ratio : ratios) {
+        std::vector<double> output(static_cast<size_t>(frames / ratio) + chunk);
+        size_t produced = 0;
+        Clock::time_point start = Clock::now();
+        TimeStretcher stretcher(rate, ratio);
+        for (size_t offset = 0; !stretcher.done();) {
+            size_t n = stretcher.read(output.data() + produced, std::min(chunk, output.size() - produced));
+            produced += n;
+            if (n == 0 && offset < frames) {
+                const size_t count = std::min(chunk, frames - offset);
+                stretcher.write(input.data() + offset, count);
+                offset += count;
+            } else if (n == 0) {
+                stretcher.finish();
+            }
+        }
+        double wall_ms = elapsed_ms(start);
+        output.resize(produced);
+        std::cout << ratio << "," << frames << "," << produced << "," << wall_ms << ","
+                  << (wall_ms > 0.0 ? seconds * 1000.0 / wall_ms : 0.0) << ","
+                  << wall_ms / (seconds * 10.0) << "," << produced * ratio / frames << ","
+                  << (input_rate > 0.0 ? crossing_rate(output) / input_rate : 0.0) << std::endl;
+    }
+    std::cerr << "Window: " << TimeStretcher(rate, 1.0).frame_size() << " frames" << std::endl;
+    return 0;
+}
+
+// S seconds of a chord progression in a key: root-position triads over a bass
+// note, each voice a wavetable of four harmonics, over a low noise floor
+std::vector<double> render_progression(int tonic, bool minor, double seconds, double rate, uint64_t seed) {
+    const size_t table_size = 4096;
+    std::vector<double> table(table_size);
+    for (size_t i = 0; i < table_size; ++i) {
+        const double phase = TWO_PI * i / table_size;
+        table[i] = std::sin(phase) + 0.5 * std::sin(2.0 * phase) + 0.33 * std::sin(3.0 * phase)
+                 + 0.25 * std::sin(4.0 * phase);
+    }
+    const int major_chords[4][3] = {{0, 4, 7}, {5, 9, 12}, {7, 11, 14}, {0, 4, 7}};
+    const int minor_chords[4][3] = {{0, 3, 7}, {5, 8, 12}, {7, 11, 14}, {0, 3, 7}};
+    const size_t chord_frames = static_cast<size_t>(2.0 * rate);
+    std::vector<double> samples(static_cast<size_t>(seconds * rate));
+    double phases[4] = {0.0};
+    double steps[4] = {0.0};   // Cycles per sample of each voice
+    for (size_t i = 0; i < samples.size(); ++i) {
+        if (i % chord_frames == 0) {
+            const int* chord = (minor ? minor_chords : major_chords)[(i / chord_frames) % 4];
+            const int root = 48 + tonic;   // C3-B3
+            const int notes[4] = {root + chord[0] - 12, root + chord[0], root + chord[1], root + chord[2]};
+            for (int v = 0; v < 4; ++v) {
+                steps[v] = 440.0 * std::pow(2.0, (notes[v] - 69) / 12.0) / rate;
+            }
+        }
+        double sample = 0.0;
+        for (int v = 0; v < 4; ++v) {
+            phases[v] += steps[v];
+            phases[v] -= std::floor(phases[v]);
+            sample += table[static_cast<size_t>(phases[v] * table_size)];
+        }
+        samples[i] = 0.1 * sample + 0.05 * noise(seed);
+    }
+    return samples;
+}
+
+int bench_keys(double seconds, double rate) {
+    struct Case { int truth; int detected; };
+    std::vector<Case> cases;
+    std::cout << "track,true_key,detected_key,confidence,detect_ms" << std::endl;
+    size_t exact = 0, related = 0, noise_keyed = 0;
+    double total_ms = 0.0;
+    uint64_t seed = 7;
+    for (int take = 0; take < 2; ++take) {
+        for (int tonic = 0; tonic < 12; ++tonic) {
+            for (int minor = 0; minor < 2; ++minor) {
+                std::vector<double> samples = render_progression(tonic, minor != 0, seconds, rate, seed++);
+                Clock::time_point start = Clock::now();
+                std::shared_ptr<const HarmonicKey> key = KeyDetector::detect(samples.data(), samples.size(), rate);
+                const double ms = elapsed_ms(start);
+                total_ms += ms;
+                const int truth = HarmonicKey::fromTonic(tonic, minor != 0);
+                cases.push_back(Case{truth, key->camelot});
+                exact += key->camelot == truth;
+                related += key->known() && KeyDetector::compatible(key->camelot, truth);
+                std::cout << "progression_" << cases.size() << "," << HarmonicKey::name(truth) << ","
+                          << HarmonicKey::name(key->camelot) << "," << key->confidence << "," << ms << std::endl;
+            }
+        }
+    }
+    const size_t noise_tracks = 8;
+    for (size_t n = 0; n < noise_tracks; ++n) {
+        std::vector<double> samples(static_cast<size_t>(seconds * rate));
+        for (double& sample : samples) {
+            sample = 0.5 * noise(seed);
+        }
+        Clock::time_point start = Clock::now();
+        std::shared_ptr<const HarmonicKey> key = KeyDetector::detect(samples.data(), samples.size(), rate);
+        const double ms = elapsed_ms(start);
+        noise_keyed += key->known();
+        std::cout << "noise_" << n + 1 << ",?," << HarmonicKey::name(key->camelot) << "," << key->confidence << ","
+                  << ms << std::endl;
+    }
+
+    // Shuffled playlist, every pair within the BPM tolerance: count harmonic clashes let through
+    std::vector<size_t> order(cases.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    uint64_t shuffle = 42;
+    for (size_t i = order.size(); i > 1; --i) {
+        shuffle = shuffle * 6364136223846793005ULL + 1442695040888963407ULL;
+        std::swap(order[i - 1], order[(shuffle >> 33) % i]);
+    }
+    size_t clashes = 0, clashes_passed = 0, compatible_rejected = 0;
+    for (size_t i = 1; i < order.size(); ++i) {
+        const Case& from = cases[order[i - 1]];
+        const Case& to = cases[order[i]];
+        const bool clash = !KeyDetector::compatible(from.truth, to.truth);
+        const bool passed = KeyDetector::compatible(from.detected, to.detected);
+        clashes += clash;
+        clashes_passed += clash && passed;
+        compatible_rejected += !clash && !passed;
+    }
+    const size_t lookups = 10000000;
+    size_t compatible = 0;
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < lookups; ++i) {
+        compatible += KeyDetector::compatible(static_cast<int>(i % 24), static_cast<int>((i / 24) % 24));
+    }
+    const double lookup_ms = elapsed_ms(start);
+
+    std::cerr << "Keys: " << exact << "/" << cases.size() << " exact, " << related << "/" << cases.size()
+              << " compatible with the true key, " << noise_keyed << "/" << noise_tracks
+              << " noise tracks given a key; " << total_ms / cases.size() << " ms per track" << std::endl;
+    std::cerr << "Playlist: " << order.size() - 1 << " transitions, " << clashes
+              << " harmonic clashes pass the BPM-only check, " << clashes_passed << " pass BPM + key ("
+              << compatible_rejected << " compatible transitions rejected)" << std::endl;
+    std::cerr << "Lookup: " << lookup_ms * 1e6 / lookups << " ns per compatibility check (" << compatible
+              << " compatible)" << std::endl;
+    return 0;
+}
+
+int bench_deckload(size_t decks, size_t loads) {
+    const double rate = 2000.0;
+    const int duration = 30;
+    const size_t library_size = decks + 1;   // Every load replaces a different track
+    std::streambuf* const stdout_buffer = std::cout.rdbuf(std::cerr.rdbuf());   // Engine logs go to stderr
+    // The controller cache's copies: cloned from the library, loaded and analyzed
+    std::vector<TrackHandle> cached;
+    for (size_t i = 0; i < library_size; ++i) {
+        MP3Track track("Track " + std::to_string(i), {"Bench"}, duration, 120 + static_cast<int>(i), 320);
+        std::vector<double> clicks = render_clicks(duration, track.get_bpm(), rate, i + 1);
+        track.set_waveform(clicks.data(), clicks.size());
+        PointerWrapper<AudioTrack> copy = track.clone();
+        copy->load();
+        copy->analyze_beatgrid();
+        cached.push_back(TrackHandle(copy.release()));
+    }
+    std::cout.rdbuf(stdout_buffer);
+    std::cout << "path,decks,loads,allocations_per_load,bytes_per_load,us_per_load" << std::endl;
+    std::cout.rdbuf(std::cerr.rdbuf());
+
+    const char* paths[] = {"clone", "move", "pinned"};
+    for (const char* path : paths) {
+        MixingEngineService engine;
+        engine.set_deck_count(decks);
+        std::vector<PointerWrapper<AudioTrack>> owned;
+        if (std::strcmp(path, "move") == 0) {
+            for (size_t i = 0; i < loads; ++i) {
+                owned.push_back(cached[i % library_size]->clone());
+            }
+        }
+        // Fill the decks first so every measured load replaces a track
+        for (size_t i = 0; i < decks; ++i) {
+            engine.loadTrackToDeck(*cached[library_size - 1 - i]);
+        }
+        const uint64_t allocations = heap_allocations.load();
+        const uint64_t bytes = heap_bytes.load();
+        Clock::time_point start = Clock::now();
+        for (size_t i = 0; i < loads; ++i) {
+            const TrackHandle& track = cached[i % library_size];
+            if (std::strcmp(path, "clone") == 0) {
+                engine.loadTrackToDeck(*track);
+            } else if (std::strcmp(path, "move") == 0) {
+                engine.loadTrackToDeck(std::move(owned[i]));
+            } else {
+                engine.loadTrackToDeck(track);
+            }
+        }
+        const double wall_ms = elapsed_ms(start);
+        const double per_load_allocations = static_cast<double>(heap_allocations.load() - allocations) / loads;
+        const double per_load_bytes = static_cast<double>(heap_bytes.load() - bytes) / loads;
+        std::cout.rdbuf(stdout_buffer);
+        std::cout << path << "," << decks << "," << loads << "," << per_load_allocations << ","
+                  << per_load_bytes << "," << wall_ms * 1000.0 / loads << std::endl;
+        std::cout.rdbuf(std::cerr.rdbuf());
+    }
+    std::cout.rdbuf(stdout_buffer);
+    return 0;
+}
+
+int bench_mixer(double seconds, double rate, size_t decks, size_t rounds) {
+    const size_t callback = 64;
+    const int duration = static_cast<int>(seconds);
+    const size_t library_size = decks + 1;
+    std::streambuf* const stdout_buffer = std::cout.rdbuf(std::cerr.rdbuf());   // Engine logs go to stderr
+    std::vector<TrackHandle> cached;
+    uint64_t seed = 1;
+    for (size_t i = 0; i < library_size; ++i) {
+        std::vector<double> samples(static_cast<size_t>(duration * rate));
+        for (double& sample : samples) {
+            sample = 0.5 * noise(seed);
+        }
+        MP3Track track("Track " + std::to_string(i), {"Bench"}, duration, 120, 320);
+        track.set_waveform(samples.data(), samples.size());
+        PointerWrapper<AudioTrack> copy = track.clone();
+        copy->load();
+        copy->analyze_beatgrid();
+        cached.push_back(TrackHandle(copy.release()));
+    }
+
+    // Runs on the mixer thread: every allocation that thread ever made
+    std::atomic<uint64_t> mixer_allocations(0);
+    std::atomic<uint64_t> peak_bits(0);
+    MixerThread::Sink sink = [&mixer_allocations, &peak_bits](const double* block, size_t frames) {
+        double peak = 0.0;
+        for (size_t i = 0; i < frames; ++i) {
+            peak = std::max(peak, std::fabs(block[i]));
+        }
+        uint64_t bits;
+        std::memcpy(&bits, &peak, sizeof(bits));   // Non-negative doubles order like their bits
+        if (bits > peak_bits.load(std::memory_order_relaxed)) {
+            peak_bits.store(bits, std::memory_order_relaxed);
+        }
+        mixer_allocations.store(thread_allocations, std::memory_order_relaxed);
+    };
+
+    MixingEngineService engine;
+    engine.set_deck_count(decks);
+    engine.set_streaming(true);
+    engine.set_crossfade(1, CrossfadeRenderer::EQUAL_POWER);
+    engine.start_mixer_thread(rate, callback, sink);
+    const CrossfadeRenderer::Curve curves[] = {CrossfadeRenderer::LINEAR, CrossfadeRenderer::EQUAL_POWER,
+                                               CrossfadeRenderer::S_CURVE};
+    const double tempos[] = {0.95, 1.0, 1.05};
+    Clock::time_point start = Clock::now();
+    for (size_t round = 0; round < rounds; ++round) {
+        const TrackHandle& track = cached[round % library_size];
+        if (engine.can_borrow(*track)) {
+            engine.loadTrackToDeck(track);
+        } else {
+            engine.loadTrackToDeck(*track);
+        }
+        engine.set_crossfade(1, curves[round % 3]);
+        engine.set_deck_tempo(engine.get_active_deck(), tempos[round % 3]);
+        engine.unload_deck((engine.get_active_deck() + 1) % decks);
+    }
+    const double wall_ms = elapsed_ms(start);
+    const MixerThread& mixer = *engine.get_mixer_thread();
+    const uint64_t callbacks = mixer.callbacks();
+    const uint64_t underruns = mixer.underruns();
+    const uint64_t late = mixer.late_callbacks();
+    const uint64_t applied = mixer.commands_applied();
+    const uint64_t retired = mixer.decoders_retired();
+    const double longest_us = mixer.longest_callback_us();
+    engine.stop_mixer_thread();
+    std::cout.rdbuf(stdout_buffer);
+
+    const uint64_t allocations = mixer_allocations.load();
+    const uint64_t bits = peak_bits.load();
+    double peak;
+    std::memcpy(&peak, &bits, sizeof(peak));
+    std::cout << "decks,commands,callbacks,callback_frames,underruns,late_callbacks,decoders_retired,"
+                 "longest_callback_us,mixer_thread_allocations,wall_ms" << std::endl;
+    std::cout << decks << "," << applied << "," << callbacks << "," << callback << "," << underruns << ","
+              << late << "," << retired << "," << longest_us << "," << allocations << "," << wall_ms << std::endl;
+    std::cerr << "Mixer thread: " << applied << " commands applied over " << callbacks << " callbacks ("
+              << callbacks * callback / rate << " s of audio, peak " << peak << "), " << underruns
+              << " underruns, " << late << " late, longest callback " << longest_us << " us (budget "
+              << callback * 1e6 / rate << " us); " << retired << " decoders retired to the control thread"
+              << std::endl;
+    std::cerr << (allocations == 0 ? "PASS" : "FAIL") << ": " << allocations
+              << " heap allocations on the mixer thread" << std::endl;
+    std::cout.rdbuf(std::cerr.rdbuf());   // Deck teardown logs
+    return allocations == 0 ? 0 : 1;
+}
+
+// The LRU cache before hash indexing: lookup, LRU victim and free slot are
+// each a linear scan over the slots (the reference of the lru benchmark)
+class ScanLRUCache {
+public:
+    explicit ScanLRUCache(size_t capacity) : slots(capacity), access_counter(0) {}
+
+    AudioTrack* get(const std::string& title) {
+        size_t idx = find_slot(title);
+        return idx == slots.size() ? nullptr : slots[idx].access(++access_counter);
+    }
+
+    bool put(PointerWrapper<AudioTrack> track) {
+        size_t existing = find_slot(track->get_title());
+        access_counter++;
+        if (existing != slots.size()) {
+            slots[existing].access(access_counter);
+            return false;
+        }
+        bool evicted = false;
+        if (find_empty_slot() == slots.size()) {
+            slots[find_lru_slot()].clear();
+            evicted = true;
+        }
+        slots[find_empty_slot()].store(std::move(track), access_counter);
+        return evicted;
+    }
+
+    // Store distinct tracks in the empty slots without scanning (benchmark setup)
+    void fill(std::vector<PointerWrapper<AudioTrack>>& tracks) {
+        for (size_t i = 0; i < tracks.size() && i < slots.size(); ++i) {
+            slots[i].store(std::move(tracks[i]), ++access_counter);
+        }
+    }
+
+private:
+    size_t find_slot(const std::string& title) const {
+        for (size_t i = 0; i < slots.size(); ++i) {
+            if (slots[i].isOccupied() && slots[i].getTrack()->get_title() == title) return i;
+        }
+        return slots.size();
+    }
+
+    size_t find_lru_slot() const {
+        uint64_t oldest = UINT64_MAX;
+        size_t lru = slots.size();
+        for (size_t i = 0; i < slots.size(); ++i) {
+            if (slots[i].isOccupied() && slots[i].getLastAccessTime() < oldest) {
+                oldest = slots[i].getLastAccessTime();
+                lru = i;
+            }
+        }
+        return lru;
+    }
+
+    size_t find_empty_slot() const {
+        for (size_t i = 0; i < slots.size(); ++i) {
+            if (!slots[i].isOccupied()) return i;
+        }
+        return slots.size();
+    }
+
+    std::vector<CacheSlot> slots;
+    uint64_t access_counter;
+};
+
+// Get and put timings of one cache over the request sequence keys
+template <typename Cache>
+void time_cache(Cache& cache, const std::vector<PointerWrapper<AudioTrack>>& library, const std::vector<size_t>& keys,
+                double& get_ns, double& put_ns, double& hit_ratio) {
+    size_t hits = 0;
+    Clock::time_point start = Clock::now();
+    for (size_t key : keys) {
+        hits += cache.get(library[key]->get_title()) != nullptr;
+    }
+    get_ns = elapsed_ms(start) * 1e6 / keys.size();
+    hit_ratio = static_cast<double>(hits) / keys.size();
+
+    std::vector<PointerWrapper<AudioTrack>> puts;
+    for (size_t key : keys) {
+        puts.push_back(library[key]->clone());
+    }
+    start = Clock::now();
+    for (PointerWrapper<AudioTrack>& track : puts) {
+        cache.put(std::move(track));
+    }
+    put_ns = elapsed_ms(start) * 1e6 / keys.size();
+}
+
+int bench_lru() {
+    const size_t capacities[] = {8, 1000, 100000};
+    std::cout << "cache,slots,ops,get_ns,put_ns,get_hit_ratio" << std::endl;
+    for (size_t capacity : capacities) {
+        // A scan over 100000 slots takes about a millisecond: fewer requests there
+        const size_t ops = std::max<size_t>(200, std::min<size_t>(200000, 20000000 / capacity));
+        std::streambuf* const stdout_buffer = std::cout.rdbuf(nullptr);   // Track constructors log
+        std::vector<PointerWrapper<AudioTrack>> library;
+        for (size_t i = 0; i < 2 * capacity; ++i) {
+            library.push_back(PointerWrapper<AudioTrack>(
+                new MP3Track("Track " + std::to_string(i), {"Bench"}, 180, 120, 320)));
+        }
+        std::vector<size_t> keys(ops);
+        uint64_t seed = capacity;
+        for (size_t& key : keys) {
+            key = static_cast<size_t>((noise(seed) + 1.0) * 0.5 * library.size()) % library.size();
+        }
+
+        double indexed_get, indexed_put, indexed_hits;
+        {
+            LRUCache cache(capacity);
+            for (size_t i = 0; i < capacity; ++i) {
+                cache.put(library[i]->clone());
+            }
+            time_cache(cache, library, keys, indexed_get, indexed_put, indexed_hits);
+        }
+        double scan_get, scan_put, scan_hits;
+        {
+            ScanLRUCache cache(capacity);
+            std::vector<PointerWrapper<AudioTrack>> prefill;
+            for (size_t i = 0; i < capacity; ++i) {
+                prefill.push_back(library[i]->clone());
+            }
+            cache.fill(prefill);
+            time_cache(cache, library, keys, scan_get, scan_put, scan_hits);
+        }
+        library.clear();
+        std::cout.rdbuf(stdout_buffer);
+
+        std::cout << "indexed," << capacity << "," << ops << "," << indexed_get << "," << indexed_put << ","
+                  << indexed_hits << std::endl;
+        std::cout << "scan," << capacity << "," << ops << "," << scan_get << "," << scan_put << ","
+                  << scan_hits << std::endl;
+        std::cerr << capacity << " slots: get " << indexed_get << " ns vs " << scan_get << " ns (x"
+                  << (indexed_get > 0.0 ? scan_get / indexed_get : 0.0) << "), put " << indexed_put << " ns vs "
+                  << scan_put << " ns (x" << (indexed_put > 0.0 ? scan_put / indexed_put : 0.0) << ")"
+                  << (indexed_hits == scan_hits ? "" : "; HIT RATIOS DIFFER") << std::endl;
+    }
+    return 0;
+}
+
+// The controller's unsharded cache: one LRUCache behind one mutex
+class LockedLRUCache {
+public:
+    explicit LockedLRUCache(size_t capacity) : mutex(), cache(capacity) {}
+
+    TrackHandle get(TrackId id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return cache.acquire(id);
+    }
+
+    bool put(PointerWrapper<AudioTrack> track) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return cache.put(std::move(track));
+    }
+
+private:
+    std::mutex mutex;
+    LRUCache cache;
+};
+
+// Requests per second of threads sharing cache; hits is the hit ratio
+template <typename Cache>
+double run_threads(Cache& cache, const std::vector<PointerWrapper<AudioTrack>>& library, size_t threads,
+                   size_t requests, double& hit_ratio) {
+    std::atomic<size_t> hits(0);
+    std::vector<std::thread> workers;
+    const size_t per_thread = requests / threads;
+    Clock::time_point start = Clock::now();
+    for (size_t t = 0; t < threads; ++t) {
+        workers.push_back(std::thread([&cache, &library, &hits, per_thread, t]() {
+            uint64_t seed = t + 1;
+            size_t local_hits = 0;
+            for (size_t i = 0; i < per_thread; ++i) {
+                const AudioTrack& track = *library[static_cast<size_t>((noise(seed) + 1.0) * 0.5 * library.size()) %
+                                                   library.size()];
+                if (cache.get(track.get_id())) {
+                    local_hits++;
+                } else {
+                    cache.put(track.clone());   // Cloned outside the lock, as the controller does
+                }
+            }
+            hits += local_hits;
+        }));
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    const double wall_ms = elapsed_ms(start);
+    hit_ratio = static_cast<double>(hits.load()) / (per_thread * threads);
+    return wall_ms > 0.0 ? per_thread * threads * 1000.0 / wall_ms : 0.0;
+}
+
+int bench_concurrent(size_t requests) {
+    const size_t capacity = 1024;
+    const size_t shards = 16;
+    const size_t thread_counts[] = {1, 2, 4, 8, 16, 32};
+    std::streambuf* const stdout_buffer = std::cout.rdbuf(nullptr);   // Track constructors log
+    std::vector<PointerWrapper<AudioTrack>> library;
+    for (size_t i = 0; i < 2 * capacity; ++i) {
+        library.push_back(PointerWrapper<AudioTrack>(
+            new MP3Track("Track " + std::to_string(i), {"Bench"}, 180, 120, 320)));
+        library.back()->set_id(static_cast<TrackId>(i));   // Dense IDs, as a TrackRegistry assigns them
+    }
+    std::cout.rdbuf(stdout_buffer);
+    std::cout << "cache,threads,requests,ops_per_second,hit_ratio" << std::endl;
+    for (size_t threads : thread_counts) {
+        double locked_hits, sharded_hits;
+        double locked, sharded;
+        std::cout.rdbuf(nullptr);
+        {
+            LockedLRUCache cache(capacity);
+            locked = run_threads(cache, library, threads, requests, locked_hits);
+        }
+        {
+            ConcurrentTrackCache cache(capacity, shards);
+            sharded = run_threads(cache, library, threads, requests, sharded_hits);
+        }
+        std::cout.rdbuf(stdout_buffer);
+        std::cout << "single_mutex," << threads << "," << requests << "," << locked << "," << locked_hits << std::endl;
+        std::cout << "sharded_" << shards << "," << threads << "," << requests << "," << sharded << ","
+                  << sharded_hits << std::endl;
+        std::cerr << threads << " threads: " << locked << " ops/s with one mutex, " << sharded
+                  << " ops/s sharded (x" << (locked > 0.0 ? sharded / locked : 0.0) << ")" << std::endl;
+    }
+    std::cerr << "(" << std::thread::hardware_concurrency() << " hardware threads)" << std::endl;
+    return 0;
+}
+
+} // namespace
+
+// Fastest of three runs of query in ms; result receives its output
+template <typename Result, typename Query>
+double time_query(Result& result, Query query) {
+    double best = 0.0;
+    for (int run = 0; run < 3; ++run) {
+        Clock::time_point start = Clock::now();
+        result = query();
+        const double ms = elapsed_ms(start);
+        best = run == 0 ? ms : std::min(best, ms);
+    }
+    return best;
+}
+
+int bench_library(size_t tracks) {
+    // Synthetic library: MP3 and WAV tracks with random tempo, length and quality
+    std::vector<SessionConfig::TrackInfo> infos(tracks);
+    uint64_t seed = 7;
+    const int bitrates[] = {128, 192, 320};
+    const int sample_rates[] = {44100, 48000, 96000};
+    for (size_t i = 0; i < tracks; ++i) {
+        SessionConfig::TrackInfo& info = infos[i];
+        const bool mp3 = noise(seed) < -0.6;   // One track in five
+        const size_t pick = static_cast<size_t>((noise(seed) + 1.0) * 1.5) % 3;
+        info.type = mp3 ? "MP3" : "WAV";
+        info.title = "Track " + std::to_string(i);
+        info.artists.push_back("Bench");
+        info.duration_seconds = 120 + static_cast<int>((noise(seed) + 1.0) * 240.0);
+        info.bpm = 70 + static_cast<int>((noise(seed) + 1.0) * 55.0);
+        info.extra_param1 = mp3 ? bitrates[pick] : sample_rates[pick];
+        info.extra_param2 = mp3 ? noise(seed) < 0.0 : (noise(seed) < 0.0 ? 16 : 24);
+    }
+    std::streambuf* const stdout_buffer = std::cout.rdbuf(nullptr);   // One creation line per track
+    DJLibraryService service;
+    Clock::time_point start = Clock::now();
+    service.buildLibrary(infos);
+    const double build_ms = elapsed_ms(start);
+    std::cout.rdbuf(stdout_buffer);
+    std::cout.clear();
+    const std::vector<AudioTrack*>& library = service.getLibrary();
+    TrackTable table;
+    start = Clock::now();
+    table.build(library);
+    const double table_ms = elapsed_ms(start);
+    std::cerr << "Library: " << tracks << " tracks built in " << build_ms << " ms, table columns in " << table_ms
+              << " ms" << std::endl;
+
+    std::cout << "query,rows,results,table_ms,scan_ms,speedup,ok" << std::endl;
+    bool all_ok = true;
+    auto report = [&all_ok, tracks](const std::string& query, size_t results, double fast, double slow, bool ok) {
+        std::cout << query << "," << tracks << "," << results << "," << fast << "," << slow << ","
+                  << (fast > 0.0 ? slow / fast : 0.0) << "," << ok << std::endl;
+        all_ok = all_ok && ok;
+    };
+
+    // Filters: row indices in ascending order
+    const int ranges[][2] = {{120, 128}, {172, 176}, {0, 1000}};
+    for (const auto& range : ranges) {
+        std::vector<uint32_t> fast, slow;
+        const double fast_ms = time_query(fast, [&] { return table.filterBpm(range[0], range[1]); });
+        const double slow_ms = time_query(slow, [&] {
+            std::vector<uint32_t> rows;
+            for (size_t i = 0; i < library.size(); ++i) {
+                if (library[i]->get_bpm() >= range[0] && library[i]->get_bpm() <= range[1]) {
+                    rows.push_back(static_cast<uint32_t>(i));
+                }
+            }
+            return rows;
+        });
+        report("filterBpm " + std::to_string(range[0]) + "-" + std::to_string(range[1]), fast.size(), fast_ms,
+               slow_ms, fast == slow);
+    }
+
+    const TrackTable::Format formats[] = {TrackTable::FORMAT_MP3, TrackTable::FORMAT_WAV};
+    for (TrackTable::Format format : formats) {
+        size_t fast = 0, slow = 0;
+        const double fast_ms = time_query(fast, [&] { return table.countFormat(format); });
+        const double slow_ms = time_query(slow, [&] {
+            size_t count = 0;
+            for (const AudioTrack* track : library) {
+                count += format == TrackTable::FORMAT_MP3 ? dynamic_cast<const MP3Track*>(track) != nullptr
+                                                          : dynamic_cast<const WAVTrack*>(track) != nullptr;
+            }
+            return count;
+        });
+        report(format == TrackTable::FORMAT_MP3 ? "countFormat MP3" : "countFormat WAV", fast, fast_ms, slow_ms,
+               fast == slow);
+    }
+
+    {
+        TrackTable::Summary fast, slow;
+        const double fast_ms = time_query(fast, [&] { return table.summarize(); });
+        const double slow_ms = time_query(slow, [&] {
+            TrackTable::Summary summary;
+            double quality_sum = 0.0;
+            for (const AudioTrack* track : library) {
+                summary.min_bpm = summary.count ? std::min(summary.min_bpm, track->get_bpm()) : track->get_bpm();
+                summary.max_bpm = summary.count ? std::max(summary.max_bpm, track->get_bpm()) : track->get_bpm();
+                summary.total_duration += static_cast<uint64_t>(track->get_duration());
+                quality_sum += static_cast<float>(track->get_quality_score());   // The table keeps floats
+                ++summary.count;
+            }
+            summary.mean_quality = summary.count ? quality_sum / summary.count : 0.0;
+            return summary;
+        });
+        const bool ok = fast.count == slow.count && fast.total_duration == slow.total_duration &&
+                        fast.min_bpm == slow.min_bpm && fast.max_bpm == slow.max_bpm &&
+                        std::fabs(fast.mean_quality - slow.mean_quality) <= 1e-9 * slow.mean_quality;
+        report("summarize", fast.count, fast_ms, slow_ms, ok);
+    }
+
+    // Top k: best score first, ties in row order
+    const size_t ks[] = {10, 1000};
+    for (size_t k : ks) {
+        std::vector<uint32_t> fast, slow;
+        const double fast_ms = time_query(fast, [&] { return table.topQuality(k); });
+        const double slow_ms = time_query(slow, [&] {
+            std::vector<std::pair<float, uint32_t>> scored;
+            scored.reserve(library.size());
+            for (size_t i = 0; i < library.size(); ++i) {
+                scored.push_back(std::make_pair(static_cast<float>(library[i]->get_quality_score()),
+                                                static_cast<uint32_t>(i)));
+            }
+            const size_t n = std::min(k, scored.size());
+            std::partial_sort(scored.begin(), scored.begin() + n, scored.end(),
+                              [](const std::pair<float, uint32_t>& a, const std::pair<float, uint32_t>& b) {
+                                  return a.first != b.first ? a.first > b.first : a.second < b.second;
+                              });
+            std::vector<uint32_t> rows;
+            for (size_t i = 0; i < n; ++i) {
+                rows.push_back(scored[i].second);
+            }
+            return rows;
+        });
+        report("topQuality " + std::to_string(k), fast.size(), fast_ms, slow_ms, fast == slow);
+    }
+    return all_ok ? 0 : 1;
+}
+
+int bench_payload(const SessionConfig& config, size_t rounds) {
+    std::streambuf* const stdout_buffer = std::cout.rdbuf(nullptr);   // Session logs
+    const uint64_t before = WaveformBuffer::allocations();
+    DJLibraryService library;
+    library.buildLibrary(config.library_tracks);
+    DJControllerService controller(static_cast<size_t>(std::max(1, config.controller_cache_size)));
+    PointerWrapper<MixingEngineService> engine(new MixingEngineService());
+    std::cout.rdbuf(stdout_buffer);
+    std::cout << "round,tracks_loaded,library_tracks_played,waveform_allocations" << std::endl;
+    std::cout.rdbuf(nullptr);
+
+    std::set<const TrackPayload*> played;   // Library tracks, by the payload their copies share
+    size_t loaded = 0;
+    bool shared = true;
+    for (size_t round = 1; round <= rounds; ++round) {
+        for (const auto& entry : config.playlists) {
+            library.loadPlaylistFromIndices(entry.first, entry.second);
+            for (const AudioTrack* track : library.getPlaylist().getTracks()) {
+                // Playlist clones are loaded and analyzed, so each one's waveform is needed
+                played.insert(track->get_payload().get());
+                AudioTrack* source = library.findTrack(track->get_id());
+                if (!source) {
+                    continue;
+                }
+                controller.loadTrackToCache(*source);
+                TrackHandle cached = controller.acquireTrack(*source);
+                if (cached && engine->loadTrackToDeck(*cached) >= 0) {
+                    ++loaded;
+                }
+            }
+        }
+        const uint64_t allocations = WaveformBuffer::allocations() - before;
+        shared = shared && allocations == played.size();
+        std::cout.rdbuf(stdout_buffer);
+        std::cout << round << "," << loaded << "," << played.size() << "," << allocations << std::endl;
+        std::cout.rdbuf(nullptr);
+    }
+    engine.reset();
+    std::cout.rdbuf(stdout_buffer);
+    std::cerr << "Payload: " << loaded << " deck loads of " << played.size() << " library tracks, "
+              << WaveformBuffer::allocations() - before << " waveforms allocated ("
+              << (shared ? "one per library track" : "FAILED: expected one per library track") << ")" << std::endl;
+    return shared && !played.empty() ? 0 : 1;
+}
+
+int bench_allocs(const SessionConfig& config, size_t rounds) {
+    // Heap allocations and bytes counted by this binary's operator new, per phase
+    struct Phase { const char* name; uint64_t operations; uint64_t allocations; uint64_t bytes; };
+    Phase build = {"build", 0, 0, 0};
+    std::streambuf* const stdout_buffer = std::cout.rdbuf(nullptr);   // Session logs
+    uint64_t allocations = heap_allocations.load();
+    uint64_t bytes = heap_bytes.load();
+    DJLibraryService library;
+    library.buildLibrary(config.library_tracks);
+    // Configured as DJSession configures the controller
+    DJControllerService controller(static_cast<size_t>(std::max(1, config.controller_cache_size)));
+    if (config.controller_cache_bytes > 0) {
+        controller.set_cache_bytes(config.controller_cache_bytes);
+    }
+    if (config.controller_cache_shards > 1) {
+        controller.set_cache_shards(static_cast<size_t>(config.controller_cache_shards));
+    }
+    controller.set_cache_policy(config.controller_cache_policy);
+    PointerWrapper<MixingEngineService> engine(new MixingEngineService());
+    build.operations = config.library_tracks.size();
+    build.allocations = heap_allocations.load() - allocations;
+    build.bytes = heap_bytes.load() - bytes;
+    std::cout.rdbuf(stdout_buffer);
+    std::cout << "round,phase,operations,allocations,bytes,allocations_per_operation" << std::endl;
+    std::cout << "0," << build.name << "," << build.operations << "," << build.allocations << "," << build.bytes
+              << "," << (build.operations ? static_cast<double>(build.allocations) / build.operations : 0.0)
+              << std::endl;
+    std::cout.rdbuf(nullptr);
+
+    std::vector<Phase> phases;
+    for (size_t round = 1; round <= rounds; ++round) {
+        Phase playlist = {"playlist", 0, 0, 0};
+        Phase hit = {"request_hit", 0, 0, 0};
+        Phase miss = {"request_miss", 0, 0, 0};
+        Phase deck = {"deck_load", 0, 0, 0};
+        for (const auto& entry : config.playlists) {
+            // As DJSession plays a playlist: load it, then request and deck every track by ID
+            allocations = heap_allocations.load();
+            bytes = heap_bytes.load();
+            library.loadPlaylistFromIndices(entry.first, entry.second);
+            std::vector<TrackId> ids = library.getTrackIds();
+            playlist.operations++;
+            playlist.allocations += heap_allocations.load() - allocations;
+            playlist.bytes += heap_bytes.load() - bytes;
+            for (TrackId id : ids) {
+                AudioTrack* source = library.findTrack(id);
+                if (!source) {
+                    continue;
+                }
+                allocations = heap_allocations.load();
+                bytes = heap_bytes.load();
+                Phase& request = controller.loadTrackToCache(*source) > 0 ? hit : miss;
+                request.operations++;
+                request.allocations += heap_allocations.load() - allocations;
+                request.bytes += heap_bytes.load() - bytes;
+                allocations = heap_allocations.load();
+                bytes = heap_bytes.load();
+                TrackHandle track = controller.acquireTrack(*source);
+                if (track) {
+                    if (engine->can_borrow(*track)) {
+                        engine->loadTrackToDeck(track);
+                    } else {
+                        engine->loadTrackToDeck(*track);
+                    }
+                    deck.operations++;
+                }
+                track = TrackHandle();
+                deck.allocations += heap_allocations.load() - allocations;
+                deck.bytes += heap_bytes.load() - bytes;
+            }
+        }
+        std::cout.rdbuf(stdout_buffer);
+        for (const Phase& phase : {playlist, hit, miss, deck}) {
+            std::cout << round << "," << phase.name << "," << phase.operations << "," << phase.allocations << ","
+                      << phase.bytes << ","
+                      << (phase.operations ? static_cast<double>(phase.allocations) / phase.operations : 0.0)
+                      << std::endl;
+        }
+        std::cout.rdbuf(nullptr);
+        if (round == rounds) {
+            phases = {playlist, hit, miss, deck};
+        }
+    }
+    engine.reset();
+    std::cout.rdbuf(stdout_buffer);
+    std::cerr << "Allocations: " << build.allocations << " to build " << build.operations << " library tracks";
+    for (const Phase& phase : phases) {
+        std::cerr << ", " << (phase.operations ? static_cast<double>(phase.allocations) / phase.operations : 0.0)
+                  << " per " << phase.name;
+    }
+    std::cerr << " (round " << rounds << ")" << std::endl;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    std::string benchmark;
+    std::string config_path = "bin/dj_config.txt";
+    std::string wav_path;
+    double rate = 0.0;   // Benchmark default unless --rate is given
+    double megabytes = 256.0;
+    double seconds = 0.0;   // Benchmark default unless --seconds is given
+    long decks = 2;
+    long loads = 0;   // Benchmark default unless --loads is given
+    long tracks = 1000000;
+    bool has_path = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            rate = std::strtod(argv[++i], nullptr);
+        } else if (std::strcmp(argv[i], "--mb") == 0 && i + 1 < argc) {
+            megabytes = std::strtod(argv[++i], nullptr);
+        } else if (std::strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = std::strtod(argv[++i], nullptr);
+        } else if (std::strcmp(argv[i], "--decks") == 0 && i + 1 < argc) {
+            decks = std::strtol(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--loads") == 0 && i + 1 < argc) {
+            loads = std::strtol(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--tracks") == 0 && i + 1 < argc) {
+            tracks = std::strtol(argv[++i], nullptr, 10);
+        } else if (argv[i][0] == '-') {
+            benchmark.clear();
+            break;
+        } else if (benchmark.empty()) {
+            benchmark = argv[i];
+        } else {
+            config_path = wav_path = argv[i];
+            has_path = true;
+        }
+    }
+    if (benchmark == "wavscan" && megabytes > 0.0) {
+        if (has_path) {
+            return bench_wavscan(std::vector<std::string>(1, wav_path), false);
+        }
+        const char* tmp = std::getenv("TMPDIR");
+        const std::string dir = tmp && *tmp ? tmp : "/tmp";
+        const uint64_t bytes = static_cast<uint64_t>(megabytes * 1024.0 * 1024.0);
+        const struct { unsigned bits; WavFile::Encoding encoding; const char* name; } formats[] = {
+            {16, WavFile::PCM_INT, "16"}, {24, WavFile::PCM_INT, "24"},
+            {32, WavFile::PCM_INT, "32"}, {32, WavFile::PCM_FLOAT, "32f"}};
+        std::vector<std::string> files;
+        for (const auto& format : formats) {
+            std::string path = dir + "/dj_bench_" + format.name + ".wav";
+            if (!write_wav(path, format.bits, format.encoding, bytes)) {
+                std::cerr << "Could not write " << path << std::endl;
+                std::remove(path.c_str());
+                continue;
+            }
+            files.push_back(path);
+        }
+        return bench_wavscan(files, true);
+    }
+    if (benchmark == "mp3index" && seconds >= 0.0) {
+        return bench_mp3index(seconds > 0.0 ? seconds : 600.0);
+    }
+    if (benchmark == "crossfade" && seconds >= 0.0 && rate >= 0.0 && decks > 0) {
+        return bench_crossfade(seconds > 0.0 ? seconds : 60.0, rate > 0.0 ? rate : 44100.0, static_cast<size_t>(decks));
+    }
+    if (benchmark == "stretch" && seconds >= 0.0 && rate >= 0.0) {
+        return bench_stretch(seconds > 0.0 ? seconds : 60.0, rate > 0.0 ? rate : 44100.0);
+    }
+    if (benchmark == "keys" && seconds >= 0.0 && rate >= 0.0) {
+        return bench_keys(seconds > 0.0 ? seconds : 30.0, rate > 0.0 ? rate : 22050.0);
+    }
+    if (benchmark == "deckload" && decks > 0 && loads >= 0) {
+        return bench_deckload(static_cast<size_t>(decks), static_cast<size_t>(loads > 0 ? loads : 1000));
+    }
+    if (benchmark == "mixer" && seconds >= 0.0 && rate >= 0.0 && decks > 0 && loads >= 0) {
+        return bench_mixer(seconds > 0.0 ? seconds : 20.0, rate > 0.0 ? rate : 44100.0, static_cast<size_t>(decks),
+                           static_cast<size_t>(loads > 0 ? loads : 250));
+    }
+    if (benchmark == "lru") {
+        return bench_lru();
+    }
+    if (benchmark == "library" && tracks > 0) {
+        return bench_library(static_cast<size_t>(tracks));
+    }
+    if (benchmark == "concurrent" && loads >= 0) {
+        return bench_concurrent(static_cast<size_t>(loads > 0 ? loads : 200000));
+    }
+    if (rate == 0.0) {
+        rate = 44100.0;
+    }
+    if ((benchmark != "beatgrid" || rate <= 0.0) && ((benchmark != "payload" && benchmark != "allocs") || loads < 0)) {
+        std::cerr << "Usage: " << argv[0] << " beatgrid [config_path] [--rate HZ]" << std::endl;
+        std::cerr << "       " << argv[0] << " wavscan [file.wav] [--mb N]" << std::endl;
+        std::cerr << "       " << argv[0] << " mp3index [--seconds S]" << std::endl;
+        std::cerr << "       " << argv[0] << " crossfade [--seconds S] [--rate HZ] [--decks N]" << std::endl;
+        std::cerr << "       " << argv[0] << " stretch [--seconds S] [--rate HZ]" << std::endl;
+        std::cerr << "       " << argv[0] << " deckload [--decks N] [--loads L]" << std::endl;
+        std::cerr << "       " << argv[0] << " keys [--seconds S] [--rate HZ]" << std::endl;
+        std::cerr << "       " << argv[0] << " mixer [--seconds S] [--rate HZ] [--decks N] [--loads L]" << std::endl;
+        std::cerr << "       " << argv[0] << " lru" << std::endl;
+        std::cerr << "       " << argv[0] << " concurrent [--loads L]" << std::endl;
+        std::cerr << "       " << argv[0] << " library [--tracks N]" << std::endl;
+        std::cerr << "       " << argv[0] << " payload [config_path] [--loads L]" << std::endl;
+        std::cerr << "       " << argv[0] << " allocs [config_path] [--loads L]" << std::endl;
+        return 1;
+    }
+
+    SessionConfig config;
+    std::streambuf* stdout_buffer = std::cout.rdbuf(std::cerr.rdbuf());
+    bool parsed = SessionFileParser::parse_config_file(config_path, config);
+    std::cout.rdbuf(stdout_buffer);
+    if (!parsed) {
+        return 1;
+    }
+    if (benchmark == "payload") {
+        return bench_payload(config, static_cast<size_t>(loads > 0 ? loads : 3));
+    }
+    if (benchmark == "allocs") {
+        return bench_allocs(config, static_cast<size_t>(loads > 0 ? loads : 3));
+    }
+    return bench_beatgrid(config, rate);
+}
@@ -162,6 +162,7 @@ int main(int argc, char* argv[]) {
      * Command-line argument parsing
      * - If "-I" is provided as the first argument, run interactive DJ software
      * - If "-A" is provided as the second argument, enable play_all mode
+     * - "-R <playlist> <out.wav>" renders the playlist's mix to a WAV file (no menu)
      */
     bool run_software = false;
     bool play_all = false;
@@ -173,6 +174,15 @@ int main(int argc, char* argv[]) {
         play_all = true;
     }
 
+    if (argc > 1 && std::string(argv[1]) == "-R") {
+        if (argc < 4) {
+            std::cerr << "Usage: " << argv[0] << " -R <playlist> <out.wav>" << std::endl;
+            return 1;
+        }
+        DJSession mixdown_session("Mixdown Session");
+        return mixdown_session.render_mixdown(argv[2], argv[3]) ? 0 : 1;
+    }
+
     if (run_software) {
         std::cout << "\n============= RUNNING INTERACTIVE SOFTWARE =============" << std::endl;
         DJSession live_session("Interactive Session", play_all);